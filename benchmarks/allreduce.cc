@@ -0,0 +1,55 @@
+#include "../float16_t.hpp"
+#include "../float16_t_allreduce.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+
+// usage: bench_allreduce [processes] [elements] [iterations]
+int main( int argc, char** argv )
+{
+    using numeric::float16_t;
+
+    std::size_t const world = argc > 1 ? std::strtoul( argv[1], nullptr, 10 ) : 4;
+    std::size_t const n = argc > 2 ? std::strtoul( argv[2], nullptr, 10 ) : ( 1 << 24 );
+    std::size_t const iterations = argc > 3 ? std::strtoul( argv[3], nullptr, 10 ) : 20;
+    std::size_t const capacity = std::min<std::size_t>( n, 1 << 22 );
+    std::string const name = "/float16_t_bench_allreduce_" + std::to_string( getpid() );
+
+    std::vector<pid_t> children;
+    std::size_t rank = 0;
+    for ( std::size_t r = 1; r != world; ++r )
+    {
+        pid_t const pid = fork();
+        if ( pid == 0 ) { rank = r; children.clear(); break; }
+        children.push_back( pid );
+    }
+
+    numeric::shm_allreduce ar{ name, rank, world, capacity };
+    std::vector<float16_t> data( n, float16_t{ 0.001f } );
+
+    ar.allreduce( data ); // warm up
+    ar.barrier();
+    auto const start = std::chrono::steady_clock::now();
+    for ( std::size_t it = 0; it != iterations; ++it )
+        ar.allreduce( data );
+    ar.barrier();
+    double const seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count() / iterations;
+
+    if ( rank != 0 )
+        return 0;
+    for ( auto pid : children )
+        waitpid( pid, nullptr, 0 );
+
+    // bus bandwidth as reported by nccl-tests: algbw * 2 (n-1) / n
+    double const bytes = double( n ) * sizeof( float16_t );
+    double const algbw = bytes / seconds / 1.0e9;
+    double const busbw = algbw * 2.0 * double( world - 1 ) / double( world );
+    std::cout << "processes: " << world << "  elements: " << n << "  time: " << seconds * 1.0e3 << " ms"
+              << "  algbw: " << algbw << " GB/s  busbw: " << busbw << " GB/s\n";
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include "../float16_t.hpp"
+#include "../float16_t_bitmap_index.hpp"
+#include "../float16_t_column.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// usage: bench_bitmap_index [elements] [bucket_bits] [threads]
+int main( int argc, char** argv )
+{
+    using numeric::float16_t;
+    using numeric::value_range;
+    using clock = std::chrono::steady_clock;
+
+    std::size_t const n = argc > 1 ? std::strtoul( argv[1], nullptr, 10 ) : ( 1 << 26 );
+    unsigned const bits = argc > 2 ? static_cast<unsigned>( std::strtoul( argv[2], nullptr, 10 ) ) : 8;
+    std::size_t const threads = argc > 3 ? std::strtoul( argv[3], nullptr, 10 ) : 0;
+
+    std::vector<float16_t> values( n );
+    std::mt19937 engine{ 42 };
+    std::normal_distribution<float> normal{ 0.0f, 1.0f };
+    for ( auto& v : values )
+        v = float16_t{ normal( engine ) };
+
+    auto start = clock::now();
+    numeric::float16_bitmap_index const index{ values, bits, threads };
+    double const build = std::chrono::duration<double>( clock::now() - start ).count();
+
+    // one block, so the scan below never prunes anything: a plain full scan
+    numeric::float16_column column{ n };
+    column.append( values );
+
+    std::cout << "elements: " << n << "  buckets: " << index.bucket_count() << "  build: " << build * 1.0e3 << " ms ("
+              << double( n ) / build / 1.0e6 << " M/s)  index size: " << double( index.bytes() ) / double( n ) << " bytes/row\n";
+
+    std::vector<std::uint64_t> selection( ( n + 63 ) / 64 );
+    for ( float threshold : { 3.5f, 2.5f, 1.0f, 0.0f } )
+    {
+        value_range const range = value_range::greater( float16_t{ threshold } );
+        int const repeats = 10;
+
+        std::size_t hits = 0;
+        start = clock::now();
+        for ( int r = 0; r != repeats; ++r )
+            hits = index.query( range, selection );
+        double const indexed = std::chrono::duration<double>( clock::now() - start ).count() / repeats;
+
+        std::size_t scanned_hits = 0;
+        start = clock::now();
+        for ( int r = 0; r != repeats; ++r )
+            scanned_hits = column.scan( range, 1 ).matches;
+        double const scan = std::chrono::duration<double>( clock::now() - start ).count() / repeats;
+
+        if ( hits != scanned_hits )
+        {
+            std::cerr << "mismatch: " << hits << " vs " << scanned_hits << "\n";
+            return 1;
+        }
+        std::cout << "x > " << threshold << "  selectivity: " << 100.0 * double( hits ) / double( n ) << "%  index: "
+                  << indexed * 1.0e3 << " ms  full scan: " << scan * 1.0e3 << " ms  speedup: " << scan / indexed << "x\n";
+    }
+    return 0;
+}
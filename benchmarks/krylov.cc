@@ -0,0 +1,113 @@
+#include "../float16_t.hpp"
+#include "../float16_t_krylov.hpp"
+#include "../float16_t_parallel.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <span>
+#include <vector>
+
+namespace
+{
+    struct csr
+    {
+        std::size_t n = 0;
+        std::vector<std::uint64_t> offsets{ 0 };
+        std::vector<std::uint32_t> columns;
+        std::vector<double> values;
+    };
+
+    // 2D Poisson on a g x g grid, with a convection term when nonsymmetric
+    csr poisson( std::size_t g, double convection )
+    {
+        csr m;
+        m.n = g * g;
+        for ( std::size_t i = 0; i != g; ++i )
+            for ( std::size_t j = 0; j != g; ++j )
+            {
+                auto const add = [&]( std::size_t r, std::size_t c, double v ) { m.columns.push_back( std::uint32_t( r * g + c ) ); m.values.push_back( v ); };
+                if ( i ) add( i - 1, j, -1.0 );
+                if ( j ) add( i, j - 1, -1.0 - convection );
+                add( i, j, 4.0 );
+                if ( j + 1 < g ) add( i, j + 1, -1.0 + convection );
+                if ( i + 1 < g ) add( i + 1, j, -1.0 );
+                m.offsets.push_back( m.values.size() );
+            }
+        return m;
+    }
+
+    // the baseline: the same rows-in-parallel SpMV over float values
+    void multiply32( csr const& m, std::vector<float> const& values, std::vector<float> const& x, std::vector<float>& y, std::size_t threads )
+    {
+        numeric::float16_t_private::parallel_for( 0, m.n, 4096, [&]( std::size_t first, std::size_t last )
+        {
+            for ( std::size_t i = first; i != last; ++i )
+            {
+                float sum = 0.0f;
+                for ( std::size_t k = m.offsets[i], e = m.offsets[i + 1]; k != e; ++k )
+                    sum += values[k] * x[m.columns[k]];
+                y[i] = sum;
+            }
+        }, threads );
+    }
+
+    void report( char const* name, numeric::krylov_result const& r, double seconds )
+    {
+        std::cout << name << seconds * 1.0e3 << " ms  " << r.iterations << " iterations  relative residual " << r.relative_residual
+                  << ( r.converged ? "" : ", not converged" ) << "\n";
+    }
+}
+
+// usage: bench_krylov [grid] [repeats] [threads]
+int main( int argc, char** argv )
+{
+    using clock = std::chrono::steady_clock;
+
+    std::size_t const g = argc > 1 ? std::strtoul( argv[1], nullptr, 10 ) : 512;
+    std::size_t const repeats = argc > 2 ? std::strtoul( argv[2], nullptr, 10 ) : 50;
+    std::size_t const threads = argc > 3 ? std::strtoul( argv[3], nullptr, 10 ) : 0;
+
+    csr const m = poisson( g, 0.0 );
+    numeric::half_csr_matrix const a{ m.n, m.n, m.offsets, m.columns, m.values };
+    std::vector<float> const values( m.values.begin(), m.values.end() );
+    std::vector<float> x( m.n, 1.0f ), y( m.n );
+    std::cout << "grid: " << g << " x " << g << "  nonzeros: " << a.nonzeros() << "\n";
+
+    auto start = clock::now();
+    for ( std::size_t r = 0; r != repeats; ++r ) multiply32( m, values, x, y, threads );
+    double const spmv32 = std::chrono::duration<double>( clock::now() - start ).count() / double( repeats );
+    std::size_t const bytes32 = m.values.size() * ( sizeof( float ) + sizeof( std::uint32_t ) ) + m.offsets.size() * sizeof( std::uint64_t );
+    std::cout << "float SpMV: " << spmv32 * 1.0e3 << " ms  " << double( bytes32 ) / spmv32 / 1.0e9 << " GB/s of matrix\n";
+
+    start = clock::now();
+    for ( std::size_t r = 0; r != repeats; ++r ) a.multiply( std::span<float const>{ x }, std::span<float>{ y }, threads );
+    double const spmv16 = std::chrono::duration<double>( clock::now() - start ).count() / double( repeats );
+    std::cout << "half SpMV:  " << spmv16 * 1.0e3 << " ms  " << double( a.bytes() ) / spmv16 / 1.0e9 << " GB/s of matrix  speedup: "
+              << spmv32 / spmv16 << "x\n";
+
+    // right-hand sides with the all-ones solution
+    std::vector<float> b( m.n );
+    a.multiply( std::span<float const>{ x }, std::span<float>{ b }, threads );
+    numeric::krylov_options options;
+    options.max_iterations = 20000;
+    options.tolerance = 1.0e-5;
+    options.threads = threads;
+
+    std::fill( x.begin(), x.end(), 0.0f );
+    start = clock::now();
+    auto const cg = numeric::conjugate_gradient( a, std::span<float const>{ b }, std::span<float>{ x }, options );
+    report( "CG:         ", cg, std::chrono::duration<double>( clock::now() - start ).count() );
+
+    csr const n = poisson( g, 0.5 );
+    numeric::half_csr_matrix const c{ n.n, n.n, n.offsets, n.columns, n.values };
+    std::fill( x.begin(), x.end(), 1.0f );
+    c.multiply( std::span<float const>{ x }, std::span<float>{ b }, threads );
+    std::fill( x.begin(), x.end(), 0.0f );
+    start = clock::now();
+    auto const gm = numeric::gmres( c, std::span<float const>{ b }, std::span<float>{ x }, options );
+    report( "GMRES(30):  ", gm, std::chrono::duration<double>( clock::now() - start ).count() );
+    return cg.converged && gm.converged ? 0 : 1;
+}
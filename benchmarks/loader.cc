@@ -0,0 +1,98 @@
+#include "../float16_t.hpp"
+#include "../float16_t_loader.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+    // evicts the file from the page cache so every run reads from the device (best effort)
+    void drop_cache( std::string const& path )
+    {
+        int const fd = ::open( path.c_str(), O_RDONLY );
+        if ( fd < 0 ) return;
+        ::fdatasync( fd );
+        ::posix_fadvise( fd, 0, 0, POSIX_FADV_DONTNEED );
+        ::close( fd );
+    }
+}
+
+// usage: bench_loader [elements] [chunk_kib] [queue_depth] [threads] [path]
+int main( int argc, char** argv )
+{
+    using numeric::float16_t;
+    using clock = std::chrono::steady_clock;
+
+    std::size_t const n = argc > 1 ? std::strtoul( argv[1], nullptr, 10 ) : ( std::size_t( 1 ) << 27 );
+    std::size_t const chunk = ( argc > 2 ? std::strtoul( argv[2], nullptr, 10 ) : 4096 ) * 1024;
+    std::size_t const depth = argc > 3 ? std::strtoul( argv[3], nullptr, 10 ) : 8;
+    std::size_t const threads = argc > 4 ? std::strtoul( argv[4], nullptr, 10 ) : 0;
+    std::string const path = argc > 5 ? argv[5] : "bench_loader.bin";
+
+    {
+        std::vector<float16_t> values( std::size_t( 1 ) << 20 );
+        std::mt19937 engine{ 42 };
+        std::normal_distribution<float> normal{ 0.0f, 1.0f };
+        for ( auto& v : values )
+            v = float16_t{ normal( engine ) };
+        std::FILE* file = std::fopen( path.c_str(), "wb" );
+        if ( !file )
+        {
+            std::cerr << "cannot create " << path << "\n";
+            return 1;
+        }
+        for ( std::size_t written = 0; written < n; written += values.size() )
+            std::fwrite( values.data(), sizeof( float16_t ), std::min( values.size(), n - written ), file );
+        std::fclose( file );
+    }
+
+    std::vector<float> out( n );
+    std::cout << "elements: " << n << " (" << double( n * sizeof( float16_t ) ) / 1.0e6 << " MB)  chunk: " << chunk / 1024
+              << " KiB  depth: " << depth << "\n";
+
+    // the baseline: read everything, then widen everything
+    drop_cache( path );
+    double read_seconds = 0.0, widen_seconds = 0.0;
+    {
+        std::vector<float16_t> raw( n );
+        auto start = clock::now();
+        int const fd = ::open( path.c_str(), O_RDONLY );
+        std::size_t done = 0;
+        while ( done < n * sizeof( float16_t ) )
+        {
+            ssize_t const r = ::pread( fd, reinterpret_cast<char*>( raw.data() ) + done, n * sizeof( float16_t ) - done, static_cast<off_t>( done ) );
+            if ( r <= 0 ) break;
+            done += static_cast<std::size_t>( r );
+        }
+        ::close( fd );
+        read_seconds = std::chrono::duration<double>( clock::now() - start ).count();
+        start = clock::now();
+        numeric::widen( raw.data(), out.data(), n );
+        widen_seconds = std::chrono::duration<double>( clock::now() - start ).count();
+    }
+    double const serial = read_seconds + widen_seconds;
+    std::cout << "serial      read: " << read_seconds * 1.0e3 << " ms  widen: " << widen_seconds * 1.0e3 << " ms  total: "
+              << serial * 1.0e3 << " ms (" << double( n * sizeof( float16_t ) ) / serial / 1.0e9 << " GB/s)\n";
+
+    for ( bool uring : { true, false } )
+    {
+        numeric::half_loader loader{ { chunk, depth, threads, uring } };
+        drop_cache( path );
+        auto const stats = loader.load( path, 0, out );
+        std::cout << ( stats.io_uring ? "io_uring    " : "pread       " ) << "wall: " << stats.wall_seconds * 1.0e3 << " ms ("
+                  << double( stats.bytes ) / stats.wall_seconds / 1.0e9 << " GB/s)  io: " << stats.io_seconds * 1.0e3
+                  << " ms  widen: " << stats.convert_seconds * 1.0e3 << " ms  overlap: " << 100.0 * stats.overlap()
+                  << "%  speedup vs serial: " << serial / stats.wall_seconds << "x\n";
+    }
+
+    std::remove( path.c_str() );
+    return 0;
+}
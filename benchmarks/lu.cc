@@ -0,0 +1,131 @@
+#include "../float16_t.hpp"
+#include "../float16_t_lu.hpp"
+#include "../float16_t_parallel.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    // the fp64 baseline: the same blocked right-looking partial pivoting LU, everything in double
+    void lu64( std::vector<double>& a, std::vector<std::size_t>& pivots, std::size_t n, std::size_t block, std::size_t threads )
+    {
+        for ( std::size_t k0 = 0; k0 < n; k0 += block )
+        {
+            std::size_t const k1 = std::min( n, k0 + block );
+            for ( std::size_t j = k0; j != k1; ++j )
+            {
+                std::size_t p = j;
+                for ( std::size_t i = j + 1; i != n; ++i )
+                    if ( std::abs( a[i * n + j] ) > std::abs( a[p * n + j] ) ) p = i;
+                if ( a[p * n + j] == 0.0 ) throw std::runtime_error( "singular" );
+                pivots[j] = p;
+                if ( p != j )
+                    std::swap_ranges( a.begin() + std::ptrdiff_t( j * n ), a.begin() + std::ptrdiff_t( j * n + n ), a.begin() + std::ptrdiff_t( p * n ) );
+                double const inverse = 1.0 / a[j * n + j];
+                for ( std::size_t i = j + 1; i != n; ++i )
+                {
+                    double const l = a[i * n + j] *= inverse;
+                    for ( std::size_t c = j + 1; c != k1; ++c )
+                        a[i * n + c] -= l * a[j * n + c];
+                }
+            }
+            for ( std::size_t j = k0 + 1; j < k1; ++j )
+                for ( std::size_t t = k0; t != j; ++t )
+                {
+                    double const l = a[j * n + t];
+                    for ( std::size_t c = k1; c != n; ++c )
+                        a[j * n + c] -= l * a[t * n + c];
+                }
+            numeric::float16_t_private::parallel_for( k1, n, 32, [&]( std::size_t first, std::size_t last )
+            {
+                for ( std::size_t c = k1; c < n; c += 1024 )
+                {
+                    std::size_t const e = std::min( n, c + 1024 );
+                    for ( std::size_t i = first; i != last; ++i )
+                        for ( std::size_t t = k0; t != k1; ++t )
+                        {
+                            double const l = a[i * n + t];
+                            for ( std::size_t j = c; j != e; ++j )
+                                a[i * n + j] -= l * a[t * n + j];
+                        }
+                }
+            }, threads );
+        }
+    }
+
+    void solve64( std::vector<double> const& lu, std::vector<std::size_t> const& pivots, std::size_t n, std::vector<double>& x )
+    {
+        for ( std::size_t i = 0; i != n; ++i ) std::swap( x[i], x[pivots[i]] );
+        for ( std::size_t i = 1; i < n; ++i )
+            for ( std::size_t j = 0; j != i; ++j ) x[i] -= lu[i * n + j] * x[j];
+        for ( std::size_t i = n; i-- > 0; )
+        {
+            for ( std::size_t j = i + 1; j != n; ++j ) x[i] -= lu[i * n + j] * x[j];
+            x[i] /= lu[i * n + i];
+        }
+    }
+
+    double max_error( std::vector<double> const& x, std::vector<double> const& truth )
+    {
+        double e = 0.0;
+        for ( std::size_t i = 0; i != x.size(); ++i ) e = std::max( e, std::abs( x[i] - truth[i] ) );
+        return e;
+    }
+}
+
+// usage: bench_lu [n] [block] [threads]
+int main( int argc, char** argv )
+{
+    using clock = std::chrono::steady_clock;
+
+    std::size_t const n = argc > 1 ? std::strtoul( argv[1], nullptr, 10 ) : 2048;
+    std::size_t const block = argc > 2 ? std::strtoul( argv[2], nullptr, 10 ) : 64;
+    std::size_t const threads = argc > 3 ? std::strtoul( argv[3], nullptr, 10 ) : 0;
+
+    // uniform entries with a diagonal shift, condition numbers in the tens
+    std::mt19937 engine{ 42 };
+    std::uniform_real_distribution<double> uniform{ -1.0, 1.0 };
+    std::vector<double> a( n * n ), truth( n ), b( n, 0.0 );
+    for ( std::size_t i = 0; i != n; ++i )
+        for ( std::size_t j = 0; j != n; ++j )
+            a[i * n + j] = uniform( engine ) + ( i == j ? 2.0 * std::sqrt( double( n ) ) : 0.0 );
+    for ( auto& t : truth ) t = uniform( engine );
+    for ( std::size_t i = 0; i != n; ++i )
+        for ( std::size_t j = 0; j != n; ++j )
+            b[i] += a[i * n + j] * truth[j];
+
+    std::cout << "n: " << n << "  block: " << block << "\n";
+
+    auto start = clock::now();
+    std::vector<double> lu = a;
+    std::vector<std::size_t> pivots( n );
+    lu64( lu, pivots, n, block, threads );
+    double const factor64 = std::chrono::duration<double>( clock::now() - start ).count();
+    start = clock::now();
+    std::vector<double> x64 = b;
+    solve64( lu, pivots, n, x64 );
+    double const solve_64 = std::chrono::duration<double>( clock::now() - start ).count();
+    std::cout << "fp64 LU      factor: " << factor64 * 1.0e3 << " ms  solve: " << solve_64 * 1.0e3 << " ms  factors: "
+              << double( n * n * sizeof( double ) ) / 1.0e6 << " MB  max error: " << max_error( x64, truth ) << "\n";
+
+    start = clock::now();
+    numeric::mixed_lu const mixed{ a, n, { block, threads } };
+    double const factor16 = std::chrono::duration<double>( clock::now() - start ).count();
+    start = clock::now();
+    std::vector<double> x16( n );
+    auto const result = mixed.refine( a, b, x16 );
+    double const solve16 = std::chrono::duration<double>( clock::now() - start ).count();
+    std::cout << "half LU + IR factor: " << factor16 * 1.0e3 << " ms  refine: " << solve16 * 1.0e3 << " ms ("
+              << result.iterations << " steps, backward error " << result.backward_error << ( result.converged ? "" : ", not converged" )
+              << ")  factors: " << double( mixed.bytes() ) / 1.0e6 << " MB  max error: " << max_error( x16, truth ) << "\n";
+    std::cout << "speedup: " << ( factor64 + solve_64 ) / ( factor16 + solve16 ) << "x\n";
+    return result.converged ? 0 : 1;
+}
@@ -0,0 +1,59 @@
+#include "../float16_t.hpp"
+#include "../float16_t_lut3d.hpp"
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// usage: bench_lut3d [width] [height] [repeats] [threads]
+int main( int argc, char** argv )
+{
+    using clock = std::chrono::steady_clock;
+
+    std::size_t const width = argc > 1 ? std::strtoul( argv[1], nullptr, 10 ) : 3840;
+    std::size_t const height = argc > 2 ? std::strtoul( argv[2], nullptr, 10 ) : 2160;
+    std::size_t const repeats = argc > 3 ? std::strtoul( argv[3], nullptr, 10 ) : 5;
+    std::size_t const threads = argc > 4 ? std::strtoul( argv[4], nullptr, 10 ) : 0;
+    std::size_t const pixels = width * height;
+
+    // scene-linear HDR pixels over +-6 stops around middle grey
+    std::mt19937 engine{ 42 };
+    std::uniform_real_distribution<float> stops{ -6.0f, 6.0f };
+    std::vector<numeric::float16_t> image( 4 * pixels ), out( image.size() );
+    for ( std::size_t i = 0; i != image.size(); ++i )
+        image[i] = numeric::float16_t{ i % 4 == 3 ? 1.0f : 0.18f * std::exp2( stops( engine ) ) };
+    auto const shaper = numeric::lut_shaper::log2( -8.0f, 8.0f );
+    std::cout << "image: " << width << " x " << height << "\n";
+
+    for ( std::size_t size : { 33, 65 } )
+    {
+        // a filmic-looking grade with some channel crosstalk
+        auto const lut = numeric::lut3d::from_function( size, []( float r, float g, float b )
+        {
+            auto const curve = []( float t ) { return t * t * ( 3.0f - 2.0f * t ); };
+            return std::array<float, 3>{ curve( 0.9f * r + 0.1f * g ), curve( g ), curve( 0.1f * g + 0.9f * b ) };
+        } );
+
+        auto start = clock::now();
+        for ( std::size_t r = 0; r != repeats; ++r )
+            for ( std::size_t p = 0; p != pixels; ++p )
+                numeric::float16_t_private::lut_pixel( lut, shaper, numeric::lut_interpolation::tetrahedral, image.data() + 4 * p, out.data() + 4 * p );
+        double const scalar = std::chrono::duration<double>( clock::now() - start ).count() / double( repeats );
+        std::cout << size << "^3 (" << double( lut.bytes() ) / 1.0e6 << " MB)  scalar tetrahedral, 1 thread: " << double( pixels ) / scalar / 1.0e6 << " Mpixel/s\n";
+
+        for ( auto interpolation : { numeric::lut_interpolation::tetrahedral, numeric::lut_interpolation::trilinear } )
+        {
+            start = clock::now();
+            for ( std::size_t r = 0; r != repeats; ++r )
+                numeric::apply_lut( lut, shaper, image, out, { interpolation, threads } );
+            double const seconds = std::chrono::duration<double>( clock::now() - start ).count() / double( repeats );
+            std::cout << size << "^3  apply_lut " << ( interpolation == numeric::lut_interpolation::tetrahedral ? "tetrahedral: " : "trilinear:   " )
+                      << double( pixels ) / seconds / 1.0e6 << " Mpixel/s  (" << scalar / seconds << "x)\n";
+        }
+    }
+    return 0;
+}
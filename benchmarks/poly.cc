@@ -0,0 +1,74 @@
+#include "../float16_t.hpp"
+#include "../float16_t_poly.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <span>
+#include <vector>
+
+namespace
+{
+    using clock = std::chrono::steady_clock;
+
+    template< typename Run >
+    double rate( std::size_t n, std::size_t repeats, Run const& run )
+    {
+        auto const start = clock::now();
+        for ( std::size_t r = 0; r != repeats; ++r ) run();
+        return double( n ) * double( repeats ) / std::chrono::duration<double>( clock::now() - start ).count() / 1.0e9;
+    }
+
+    template< std::size_t N >
+    void degree( std::vector<numeric::float16_t> const& in, std::vector<numeric::float16_t>& out, std::size_t repeats, std::size_t threads )
+    {
+        std::array<float, N> c;
+        for ( std::size_t k = 0; k != N; ++k ) c[k] = ( k % 2 ? -1.0f : 1.0f ) / float( k + 1 );
+        std::span<float const> const runtime{ c };
+        std::size_t const n = in.size();
+
+        // the baseline: one element at a time, converting through float16_t
+        double const naive = rate( n, repeats, [&]
+        {
+            for ( std::size_t i = 0; i != n; ++i )
+            {
+                float const x = float( in[i] );
+                float y = c[N - 1];
+                for ( std::size_t k = N - 1; k-- > 0; ) y = y * x + c[k];
+                out[i] = numeric::float16_t{ y };
+            }
+        } );
+        std::cout << "degree " << N - 1 << "  naive scalar, 1 thread: " << naive << " Gelem/s\n";
+        for ( auto scheme : { numeric::poly_scheme::horner, numeric::poly_scheme::estrin } )
+        {
+            char const* name = scheme == numeric::poly_scheme::horner ? "horner" : "estrin";
+            double const dynamic = rate( n, repeats, [&] { numeric::polyval( runtime, in, out, { scheme, threads } ); } );
+            double const fixed = rate( n, repeats, [&] { numeric::polyval( c, in, out, { scheme, threads } ); } );
+            std::cout << "          " << name << "  runtime degree: " << dynamic << " Gelem/s (" << dynamic / naive << "x)  compile-time degree: "
+                      << fixed << " Gelem/s (" << fixed / naive << "x)\n";
+        }
+        double const chebyshev = rate( n, repeats, [&] { numeric::chebval( c, in, out, -2.0f, 2.0f, threads ); } );
+        std::cout << "          clenshaw  compile-time degree: " << chebyshev << " Gelem/s (" << chebyshev / naive << "x)\n";
+    }
+}
+
+// usage: bench_poly [elements] [repeats] [threads]
+int main( int argc, char** argv )
+{
+    std::size_t const n = argc > 1 ? std::strtoul( argv[1], nullptr, 10 ) : std::size_t( 1 ) << 22;
+    std::size_t const repeats = argc > 2 ? std::strtoul( argv[2], nullptr, 10 ) : 5;
+    std::size_t const threads = argc > 3 ? std::strtoul( argv[3], nullptr, 10 ) : 0;
+
+    std::mt19937 engine{ 42 };
+    std::uniform_real_distribution<float> uniform{ -2.0f, 2.0f };
+    std::vector<numeric::float16_t> in( n ), out( n );
+    for ( auto& v : in ) v = numeric::float16_t{ uniform( engine ) };
+    std::cout << "elements: " << n << "\n";
+
+    degree<6>( in, out, repeats, threads );
+    degree<10>( in, out, repeats, threads );
+    degree<16>( in, out, repeats, threads );
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include "../float16_t.hpp"
+#include "../float16_t_ring.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using numeric::float16_t;
+    using clock = std::chrono::steady_clock;
+
+    constexpr std::size_t batch = 8;
+
+    std::int64_t now_ns()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>( clock::now().time_since_epoch() ).count();
+    }
+
+    // every block carries its push time in its first four halves, the consumer turns it into a latency
+    template< typename Ring >
+    void run( std::string const& name, std::size_t producers, std::size_t consumers, std::size_t block_size, std::size_t blocks )
+    {
+        Ring ring{ block_size, 1024 };
+        std::size_t const per_producer = blocks / producers;
+        std::size_t const total = per_producer * producers;
+        std::atomic<std::size_t> consumed{ 0 };
+        std::vector<std::vector<std::int64_t>> latencies( consumers );
+
+        auto const start = clock::now();
+        std::vector<std::thread> threads;
+        for ( std::size_t p = 0; p != producers; ++p )
+            threads.emplace_back( [&]
+            {
+                std::vector<float16_t> out( batch * block_size, float16_t{ 1.0f } );
+                for ( std::size_t sent = 0; sent < per_producer; )
+                {
+                    std::size_t const n = std::min( batch, per_producer - sent );
+                    std::int64_t const stamp = now_ns();
+                    for ( std::size_t b = 0; b != n; ++b )
+                        std::memcpy( out.data() + b * block_size, &stamp, sizeof( stamp ) );
+                    ring.push( std::span<float16_t const>{ out.data(), n * block_size } );
+                    sent += n;
+                }
+            } );
+        for ( std::size_t c = 0; c != consumers; ++c )
+            threads.emplace_back( [&, c]
+            {
+                std::vector<float16_t> in( batch * block_size );
+                auto& local = latencies[c];
+                local.reserve( total / consumers + batch );
+                while ( consumed.load( std::memory_order_relaxed ) < total )
+                {
+                    std::size_t const n = ring.try_pop( in );
+                    if ( n == 0 )
+                    {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    std::int64_t const arrival = now_ns();
+                    for ( std::size_t b = 0; b != n; ++b )
+                    {
+                        std::int64_t stamp;
+                        std::memcpy( &stamp, in.data() + b * block_size, sizeof( stamp ) );
+                        local.push_back( arrival - stamp );
+                    }
+                    consumed.fetch_add( n, std::memory_order_relaxed );
+                }
+            } );
+        for ( auto& t : threads )
+            t.join();
+        double const seconds = std::chrono::duration<double>( clock::now() - start ).count();
+
+        std::vector<std::int64_t> all;
+        for ( auto const& l : latencies )
+            all.insert( all.end(), l.begin(), l.end() );
+        std::sort( all.begin(), all.end() );
+        auto percentile = [&]( double q ) { return all.empty() ? 0.0 : double( all[std::size_t( q * double( all.size() - 1 ) )] ) * 1.0e-3; };
+
+        std::cout << name << "  " << producers << "x" << consumers << "  blocks: " << total << "  throughput: "
+                  << double( total ) / seconds / 1.0e6 << " M blocks/s, "
+                  << double( total * block_size * sizeof( float16_t ) ) / seconds / 1.0e9 << " GB/s  latency p50: "
+                  << percentile( 0.5 ) << " us  p99: " << percentile( 0.99 ) << " us  p99.9: " << percentile( 0.999 ) << " us\n";
+    }
+}
+
+// usage: bench_ring [producers] [consumers] [block_size] [blocks]
+int main( int argc, char** argv )
+{
+    std::size_t const producers = argc > 1 ? std::strtoul( argv[1], nullptr, 10 ) : 1;
+    std::size_t const consumers = argc > 2 ? std::strtoul( argv[2], nullptr, 10 ) : 1;
+    std::size_t const block_size = argc > 3 ? std::strtoul( argv[3], nullptr, 10 ) : 256;
+    std::size_t const blocks = argc > 4 ? std::strtoul( argv[4], nullptr, 10 ) : ( 1 << 22 );
+
+    if ( producers == 0 || consumers == 0 || block_size < 4 )
+    {
+        std::cerr << "need at least one producer and consumer and blocks of at least 4 halves\n";
+        return 1;
+    }
+
+    std::cout << "block: " << block_size << " halves (" << block_size * sizeof( numeric::float16_t ) << " bytes)\n";
+    if ( producers == 1 && consumers == 1 )
+        run<numeric::spsc_block_ring>( "spsc", 1, 1, block_size, blocks );
+    run<numeric::mpmc_block_ring>( "mpmc", producers, consumers, block_size, blocks );
+    return 0;
+}
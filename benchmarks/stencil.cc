@@ -0,0 +1,70 @@
+#include "../float16_t.hpp"
+#include "../float16_t_stencil.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+    std::vector<numeric::float16_t> random_grid( std::size_t cells )
+    {
+        std::mt19937 engine{ 42 };
+        std::uniform_real_distribution<float> uniform{ 0.0f, 1.0f };
+        std::vector<numeric::float16_t> grid( cells );
+        for ( auto& v : grid ) v = numeric::float16_t{ uniform( engine ) };
+        return grid;
+    }
+
+    // cell updates per second for each sweep depth; steps_per_sweep 1 is the plain one-pass-per-step baseline
+    template< typename Run >
+    void sweep_depths( char const* name, std::size_t cells, std::size_t steps, Run const& run )
+    {
+        double baseline = 0.0;
+        for ( std::size_t depth : { 1, 2, 4, 8 } )
+        {
+            auto const start = std::chrono::steady_clock::now();
+            run( depth );
+            double const seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+            double const rate = double( cells ) * double( steps ) / seconds;
+            if ( depth == 1 ) baseline = rate;
+            std::cout << name << "  steps per sweep: " << depth << "  " << rate / 1.0e9 << " Gcell-updates/s  ("
+                      << rate / baseline << "x)\n";
+        }
+    }
+}
+
+// usage: bench_stencil [n2d] [n3d] [steps] [threads]
+int main( int argc, char** argv )
+{
+    std::size_t const n2 = argc > 1 ? std::strtoul( argv[1], nullptr, 10 ) : 4096;
+    std::size_t const n3 = argc > 2 ? std::strtoul( argv[2], nullptr, 10 ) : 256;
+    std::size_t const steps = argc > 3 ? std::strtoul( argv[3], nullptr, 10 ) : 16;
+    std::size_t const threads = argc > 4 ? std::strtoul( argv[4], nullptr, 10 ) : 0;
+
+    auto grid = random_grid( n2 * n2 );
+    std::vector<numeric::float16_t> scratch( grid.size() );
+    std::cout << "2D grid: " << n2 << " x " << n2 << "  3D grid: " << n3 << "^3  steps: " << steps << "\n";
+    sweep_depths( "2D  5-point", n2 * n2, steps, [&]( std::size_t depth )
+    {
+        numeric::apply_stencil( numeric::stencil2d::five_point( 0.2f, 0.2f ), grid, scratch, n2, n2, steps, { depth, 0, 0, 0, threads } );
+    } );
+    sweep_depths( "2D  9-point", n2 * n2, steps, [&]( std::size_t depth )
+    {
+        numeric::apply_stencil( numeric::stencil2d::nine_point( 0.5f, 0.1f, 0.025f ), grid, scratch, n2, n2, steps, { depth, 0, 0, 0, threads } );
+    } );
+
+    grid = random_grid( n3 * n3 * n3 );
+    scratch.resize( grid.size() );
+    sweep_depths( "3D  7-point", n3 * n3 * n3, steps, [&]( std::size_t depth )
+    {
+        numeric::apply_stencil( numeric::stencil3d::seven_point( 0.4f, 0.1f ), grid, scratch, n3, n3, n3, steps, { depth, 0, 0, 0, threads } );
+    } );
+    sweep_depths( "3D 27-point", n3 * n3 * n3, steps, [&]( std::size_t depth )
+    {
+        numeric::apply_stencil( numeric::stencil3d::twenty_seven_point( 0.3f, 0.05f, 0.025f, 0.0125f ), grid, scratch, n3, n3, n3, steps, { depth, 0, 0, 0, threads } );
+    } );
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include "../float16_t.hpp"
+#include "../float16_t_table.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// usage: bench_table [elements] [repeats] [threads]
+int main( int argc, char** argv )
+{
+    using clock = std::chrono::steady_clock;
+    auto const seconds_since = []( clock::time_point start ) { return std::chrono::duration<double>( clock::now() - start ).count(); };
+
+    std::size_t const n = argc > 1 ? std::strtoul( argv[1], nullptr, 10 ) : std::size_t( 1 ) << 26;
+    std::size_t const repeats = argc > 2 ? std::strtoul( argv[2], nullptr, 10 ) : 5;
+    std::size_t const threads = argc > 3 ? std::strtoul( argv[3], nullptr, 10 ) : 0;
+
+    std::mt19937 engine{ 42 };
+    std::normal_distribution<float> normal{ 0.0f, 2.0f };
+    std::vector<numeric::float16_t> in( n ), out( n );
+    for ( auto& v : in ) v = numeric::float16_t{ normal( engine ) };
+
+    // a calibration-style curve: a soft clip followed by a gamma
+    auto const soft_clip = []( float x ) { return std::tanh( x ); };
+    auto const gamma = []( float x ) { return x < 0.0f ? -std::pow( -x, 1.0f / 2.2f ) : std::pow( x, 1.0f / 2.2f ); };
+
+    auto start = clock::now();
+    auto const clip = numeric::tabulate( soft_clip, threads );
+    auto const encode = numeric::tabulate( gamma, threads );
+    double const build = seconds_since( start ) / 2.0;
+    start = clock::now();
+    auto const fused = numeric::compose( clip, encode );
+    double const fuse = seconds_since( start );
+    std::cout << "elements: " << n << "  tabulate: " << build * 1.0e3 << " ms  compose: " << fuse * 1.0e3 << " ms\n";
+
+    start = clock::now();
+    for ( std::size_t r = 0; r != repeats; ++r )
+        for ( std::size_t i = 0; i != n; ++i )
+            out[i] = numeric::float16_t{ gamma( soft_clip( float( in[i] ) ) ) };
+    double const direct = seconds_since( start ) / double( repeats );
+    std::cout << "direct evaluation, 1 thread:  " << double( n ) / direct / 1.0e9 << " Gelem/s\n";
+
+    start = clock::now();
+    for ( std::size_t r = 0; r != repeats; ++r )
+        for ( std::size_t i = 0; i != n; ++i )
+            out[i] = fused( in[i] );
+    double const scalar = seconds_since( start ) / double( repeats );
+    std::cout << "scalar lookups, 1 thread:     " << double( n ) / scalar / 1.0e9 << " Gelem/s  (" << direct / scalar << "x)\n";
+
+    start = clock::now();
+    for ( std::size_t r = 0; r != repeats; ++r )
+        fused.apply( in, out, threads );
+    double const gathered = seconds_since( start ) / double( repeats );
+    std::cout << "half_table::apply:            " << double( n ) / gathered / 1.0e9 << " Gelem/s  (" << direct / gathered << "x, "
+              << scalar / gathered << "x over scalar lookups)\n";
+    return 0;
+}
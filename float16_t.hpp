@@ -11,6 +11,12 @@
 #include <cmath>
 #include <bitset>
 #include <type_traits>
+#include <cstddef>
+#include <functional>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
 
 #ifdef _MSC_VER
 #pragma warning( push )
@@ -940,6 +946,100 @@ namespace numeric
         return (std::uint16_t(f16)) & 0x8000;
     }
 
+    static_assert( sizeof(float16_t) == sizeof(std::uint16_t), "float16_t must be layout compatible with std::uint16_t." );
+
+    // neighbouring representable values, infinities and NaN are returned unchanged
+    constexpr inline float16_t next_down( float16_t f16 ) noexcept
+    {
+        std::uint16_t const bits = std::uint16_t(f16);
+        if ( (bits & 0x7fff) >= 0x7c00 && bits != 0x7c00 ) return f16; // nan and -inf
+        if ( bits == 0x0000 ) return float16_t{ static_cast<std::uint16_t>(0x8001) };
+        return float16_t{ static_cast<std::uint16_t>( (bits & 0x8000) ? bits + 1 : bits - 1 ) };
+    }
+
+    constexpr inline float16_t next_up( float16_t f16 ) noexcept
+    {
+        return -next_down( -f16 );
+    }
+
+    // directed conversions, the result brackets the input: round_down(x) <= x <= round_up(x)
+    constexpr inline float16_t round_down( float x ) noexcept
+    {
+        // out of range inputs are handled up front, float_to_half does not saturate them to infinity
+        if ( x > 65504.0f ) return fp16_max;
+        if ( x < -65504.0f ) return fp16_infinity_negative;
+        float16_t const f16{ x };
+        return float(f16) > x ? next_down( f16 ) : f16;
+    }
+
+    constexpr inline float16_t round_up( float x ) noexcept
+    {
+        if ( x > 65504.0f ) return fp16_infinity;
+        if ( x < -65504.0f ) return -fp16_max;
+        float16_t const f16{ x };
+        return float(f16) < x ? next_up( f16 ) : f16;
+    }
+
+    namespace float16_t_private
+    {
+        constexpr inline bool is_nan_bits( std::uint16_t bits ) noexcept
+        {
+            return (bits & 0x7fff) > 0x7c00;
+        }
+
+    }//namespace float16_t_private
+
+    // monotonic integer key: order_key(a) < order_key(b) whenever a < b, with -0 just below +0
+    // and NaNs beyond the infinities of their sign, so sorting and min/max can run on integers
+    constexpr inline std::uint16_t order_key( float16_t f16 ) noexcept
+    {
+        std::uint16_t const bits = std::uint16_t(f16);
+        return (bits & 0x8000) ? static_cast<std::uint16_t>(~bits) : static_cast<std::uint16_t>(bits | 0x8000);
+    }
+
+    constexpr inline float16_t from_order_key( std::uint16_t key ) noexcept
+    {
+        return float16_t{ static_cast<std::uint16_t>( (key & 0x8000) ? (key & 0x7fff) : static_cast<std::uint16_t>(~key) ) };
+    }
+
+    // bulk conversion, F16C is used when available (note the hardware path rounds ties to even, for every element)
+    inline void widen( float16_t const* src, float* dst, std::size_t n ) noexcept
+    {
+        std::size_t i = 0;
+#if defined(__F16C__)
+        for ( ; i + 8 <= n; i += 8 )
+        {
+            __m128i const h = _mm_loadu_si128( reinterpret_cast<__m128i const*>( src + i ) );
+            _mm256_storeu_ps( dst + i, _mm256_cvtph_ps( h ) );
+        }
+#endif
+        for ( ; i < n; ++i )
+            dst[i] = float( src[i] );
+    }
+
+    inline void narrow( float const* src, float16_t* dst, std::size_t n ) noexcept
+    {
+        std::size_t i = 0;
+#if defined(__F16C__)
+        for ( ; i + 8 <= n; i += 8 )
+        {
+            __m128i const h = _mm256_cvtps_ph( _mm256_loadu_ps( src + i ), _MM_FROUND_TO_NEAREST_INT );
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( dst + i ), h );
+        }
+        if ( i != n ) // the tail goes through a zero-padded vector too, so the rounding never depends on position
+        {
+            float padded[8] = {};
+            std::uint16_t bits[8];
+            for ( std::size_t k = 0; k != n - i; ++k ) padded[k] = src[i + k];
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( bits ), _mm256_cvtps_ph( _mm256_loadu_ps( padded ), _MM_FROUND_TO_NEAREST_INT ) );
+            for ( std::size_t k = 0; k != n - i; ++k ) dst[i + k] = float16_t{ bits[k] };
+            i = n;
+        }
+#endif
+        for ( ; i < n; ++i )
+            dst[i] = float16_t{ src[i] };
+    }
+
     //special functions not defined
     // assoc_laguerre, asso_legendre, hermite, legendre, laguerre, sph_bessel, sph_legendre, sph_neumann
     //
@@ -1003,6 +1103,15 @@ namespace std
         static constexpr std::float_round_style round_style = round_to_nearest;
     };
 
+    // operator == compares bit patterns, so does the hash: -0/+0 and distinct NaN payloads hash apart
+    template<> struct hash<numeric::float16_t>
+    {
+        std::size_t operator()( numeric::float16_t f16 ) const noexcept
+        {
+            return std::hash<std::uint16_t>{}( static_cast<std::uint16_t>( f16 ) );
+        }
+    };
+
     template<> inline constexpr bool is_floating_point_v<numeric::float16_t> = true;
     template<> inline constexpr bool is_arithmetic_v<numeric::float16_t> = true;
     template<> inline constexpr bool is_signed_v<numeric::float16_t> = true;
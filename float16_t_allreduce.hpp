@@ -0,0 +1,313 @@
+#ifndef FLOAT16_T_ALLREDUCE_HPP_INCLUDED_OIUSDFLKJ3498SDFLKJ3409UFSDLKJ340FSDLKJ
+#define FLOAT16_T_ALLREDUCE_HPP_INCLUDED_OIUSDFLKJ3498SDFLKJ3409UFSDLKJ340FSDLKJ
+//
+// shared-memory all-reduce of float16_t buffers among processes on one linux host
+//
+#ifndef __linux__
+#error "float16_t_allreduce.hpp requires linux (shm_open, mmap and futex)"
+#endif
+
+#include "float16_t.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <algorithm>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace numeric
+{
+    namespace float16_t_private
+    {
+        using shm_clock = std::chrono::steady_clock;
+
+        // sleeps while *addr == expected (or until woken), false once `deadline` has passed
+        inline bool futex_wait_until( std::atomic<std::uint32_t>* addr, std::uint32_t expected, shm_clock::time_point deadline ) noexcept
+        {
+            auto const left = std::chrono::duration_cast<std::chrono::nanoseconds>( deadline - shm_clock::now() ).count();
+            if ( left <= 0 ) return false;
+            timespec const timeout{ static_cast<time_t>( left / 1000000000 ), static_cast<long>( left % 1000000000 ) };
+            // shared (non-private) futex, the word lives in memory mapped by several processes
+            syscall( SYS_futex, reinterpret_cast<std::uint32_t*>( addr ), FUTEX_WAIT, expected, &timeout, nullptr, 0 );
+            return true;
+        }
+
+        [[noreturn]] inline void shm_timeout( char const* what )
+        {
+            throw std::system_error( ETIMEDOUT, std::generic_category(), std::string{ "shm_allreduce: " } + what );
+        }
+
+        inline void futex_wake_all( std::atomic<std::uint32_t>* addr ) noexcept
+        {
+            syscall( SYS_futex, reinterpret_cast<std::uint32_t*>( addr ), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0 );
+        }
+
+        struct alignas(64) shm_allreduce_header
+        {
+            alignas(64) std::atomic<std::uint32_t> arrived;
+            alignas(64) std::atomic<std::uint32_t> generation;
+            // attach handshake: ranks other than 0 count themselves in `attached` and wait for `released`
+            // to move; rank 0 sets `abandoned` on a stale segment left behind by a crashed run
+            alignas(64) std::atomic<std::uint32_t> attached;
+            alignas(64) std::atomic<std::uint32_t> released;
+            std::atomic<std::uint32_t> abandoned;
+        };
+
+        inline void shm_retry_pause() noexcept
+        {
+            usleep( 1000 );
+        }
+
+        static_assert( std::atomic<std::uint32_t>::is_always_lock_free, "futex words must be lock free" );
+
+    }//namespace float16_t_private
+
+    //
+    // every participating process constructs an instance with the same `name`, `world` and `capacity`
+    // and a distinct `rank` in [0, world), then calls `allreduce` collectively. the constructors return
+    // once all ranks are attached; a segment left under `name` by a crashed run is replaced, not reused.
+    // attaching and every barrier throw std::system_error( ETIMEDOUT ) after `timeout`, so a peer that died
+    // or never started fails the job instead of hanging it.
+    //
+    // the segment holds one staging slot of `capacity` halves per rank. a call copies the local data
+    // into the own slot, reduce-scatters (rank r sums chunk r over all slots in fp32, starting from its
+    // ring neighbour, and stores it back as half) and all-gathers the reduced chunks. buffers larger
+    // than `capacity` are processed in pieces.
+    //
+    class shm_allreduce
+    {
+    public:
+        shm_allreduce( std::string const& name, std::size_t rank, std::size_t world, std::size_t capacity,
+                       std::chrono::milliseconds timeout = std::chrono::minutes( 5 ) )
+            : rank_{ rank }, world_{ world }, capacity_{ capacity }, timeout_{ timeout }
+        {
+            if ( world == 0 || rank >= world || capacity == 0 )
+                throw std::invalid_argument( "shm_allreduce: invalid rank/world/capacity" );
+            if ( capacity > ( SIZE_MAX - sizeof( float16_t_private::shm_allreduce_header ) ) / sizeof( float16_t ) / world )
+                throw std::invalid_argument( "shm_allreduce: world * capacity too large" );
+
+            bytes_ = sizeof( float16_t_private::shm_allreduce_header ) + world * capacity * sizeof( float16_t );
+            void* const p = rank == 0 ? create( name ) : attach( name );
+            header_ = static_cast<float16_t_private::shm_allreduce_header*>( p );
+            slots_ = reinterpret_cast<float16_t*>( static_cast<char*>( p ) + sizeof( float16_t_private::shm_allreduce_header ) );
+        }
+
+        shm_allreduce( shm_allreduce const& ) = delete;
+        shm_allreduce& operator = ( shm_allreduce const& ) = delete;
+
+        ~shm_allreduce()
+        {
+            munmap( header_, bytes_ );
+        }
+
+        std::size_t rank() const noexcept { return rank_; }
+        std::size_t world() const noexcept { return world_; }
+
+        // in-place sum over all ranks, every rank must pass the same size
+        void allreduce( std::span<float16_t> data )
+        {
+            for ( std::size_t pos = 0; pos < data.size(); pos += capacity_ )
+                allreduce_piece( data.subspan( pos, std::min( capacity_, data.size() - pos ) ) );
+        }
+
+        // generation counting barrier on a shared futex word
+        void barrier()
+        {
+            auto& h = *header_;
+            std::uint32_t const gen = h.generation.load( std::memory_order_acquire );
+            if ( h.arrived.fetch_add( 1, std::memory_order_acq_rel ) + 1 == world_ )
+            {
+                h.arrived.store( 0, std::memory_order_relaxed );
+                h.generation.fetch_add( 1, std::memory_order_release );
+                float16_t_private::futex_wake_all( &h.generation );
+                return;
+            }
+            for ( int spin = 0; spin != 4096; ++spin )
+                if ( h.generation.load( std::memory_order_acquire ) != gen )
+                    return;
+            auto const deadline = float16_t_private::shm_clock::now() + timeout_;
+            while ( h.generation.load( std::memory_order_acquire ) == gen )
+                if ( !float16_t_private::futex_wait_until( &h.generation, gen, deadline ) )
+                    float16_t_private::shm_timeout( "barrier timed out" );
+        }
+
+    private:
+        // rank 0 retires any segment a crashed run left under `name`, creates a zero filled one (the initial
+        // state of the barrier and of the handshake), waits for the other ranks and then drops the name
+        void* create( std::string const& name )
+        {
+            int const stale = shm_open( name.c_str(), O_RDWR, 0600 );
+            if ( stale >= 0 )
+            {
+                struct stat st;
+                if ( fstat( stale, &st ) == 0 && std::size_t( st.st_size ) >= sizeof( float16_t_private::shm_allreduce_header ) )
+                {
+                    void* const q = mmap( nullptr, sizeof( float16_t_private::shm_allreduce_header ), PROT_READ | PROT_WRITE, MAP_SHARED, stale, 0 );
+                    if ( q != MAP_FAILED )
+                    {
+                        // ranks that already attached to it see `released` move, find `abandoned` and reopen the name
+                        auto& h = *static_cast<float16_t_private::shm_allreduce_header*>( q );
+                        h.abandoned.store( 1 );
+                        h.released.fetch_add( 1 );
+                        float16_t_private::futex_wake_all( &h.released );
+                        munmap( q, sizeof( float16_t_private::shm_allreduce_header ) );
+                    }
+                }
+                close( stale );
+                shm_unlink( name.c_str() );
+            }
+
+            int const fd = shm_open( name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600 );
+            if ( fd < 0 )
+                throw std::system_error( errno, std::generic_category(), "shm_open" );
+            if ( ftruncate( fd, static_cast<off_t>( bytes_ ) ) != 0 )
+            {
+                int const err = errno;
+                close( fd );
+                shm_unlink( name.c_str() );
+                throw std::system_error( err, std::generic_category(), "ftruncate" );
+            }
+            void* const p = mmap( nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+            int const err = errno;
+            close( fd );
+            if ( p == MAP_FAILED )
+            {
+                shm_unlink( name.c_str() );
+                throw std::system_error( err, std::generic_category(), "mmap" );
+            }
+
+            auto& h = *static_cast<float16_t_private::shm_allreduce_header*>( p );
+            auto const deadline = float16_t_private::shm_clock::now() + timeout_;
+            for ( std::uint32_t n = h.attached.load(); n != world_ - 1; n = h.attached.load() )
+                if ( !float16_t_private::futex_wait_until( &h.attached, n, deadline ) )
+                {
+                    shm_unlink( name.c_str() );
+                    munmap( p, bytes_ );
+                    float16_t_private::shm_timeout( "not every rank attached" );
+                }
+            // everybody is attached, the name is no longer needed
+            shm_unlink( name.c_str() );
+            h.released.fetch_add( 1 );
+            float16_t_private::futex_wake_all( &h.released );
+            return p;
+        }
+
+        // the other ranks open the name once rank 0 has created and sized it, and count on a segment only
+        // when rank 0 of this run releases them from it
+        void* attach( std::string const& name )
+        {
+            auto const deadline = float16_t_private::shm_clock::now() + timeout_;
+            for ( ;; float16_t_private::shm_retry_pause() )
+            {
+                if ( float16_t_private::shm_clock::now() > deadline )
+                    float16_t_private::shm_timeout( "rank 0 did not create the segment" );
+                int const fd = shm_open( name.c_str(), O_RDWR, 0600 );
+                if ( fd < 0 )
+                {
+                    if ( errno == ENOENT )
+                        continue;
+                    throw std::system_error( errno, std::generic_category(), "shm_open" );
+                }
+                struct stat st;
+                if ( fstat( fd, &st ) != 0 || std::size_t( st.st_size ) < bytes_ )
+                {
+                    close( fd );
+                    continue;
+                }
+                void* const p = mmap( nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+                int const err = errno;
+                close( fd );
+                if ( p == MAP_FAILED )
+                    throw std::system_error( err, std::generic_category(), "mmap" );
+
+                // `released` is read before `abandoned`: rank 0 sets `abandoned` before it moves `released`
+                auto& h = *static_cast<float16_t_private::shm_allreduce_header*>( p );
+                std::uint32_t const released = h.released.load();
+                if ( h.abandoned.load() == 0 )
+                {
+                    h.attached.fetch_add( 1 );
+                    float16_t_private::futex_wake_all( &h.attached );
+                    while ( h.released.load() == released )
+                        if ( !float16_t_private::futex_wait_until( &h.released, released, deadline ) )
+                        {
+                            munmap( p, bytes_ );
+                            float16_t_private::shm_timeout( "rank 0 did not release the ranks" );
+                        }
+                    if ( h.abandoned.load() == 0 )
+                        return p;
+                }
+                munmap( p, bytes_ );
+            }
+        }
+
+        float16_t* slot( std::size_t r ) const noexcept
+        {
+            return slots_ + r * capacity_;
+        }
+
+        void allreduce_piece( std::span<float16_t> data )
+        {
+            std::size_t const n = data.size();
+            std::copy( data.begin(), data.end(), slot( rank_ ) );
+            barrier();
+
+            // reduce-scatter: this rank owns chunk `rank_`, nobody else reads that chunk of its slot,
+            // so the result can be written back into the slot without another barrier
+            std::size_t const chunk = ( n + world_ - 1 ) / world_;
+            std::size_t const first = std::min( n, rank_ * chunk );
+            std::size_t const last = std::min( n, first + chunk );
+
+            constexpr std::size_t block = 1024;
+            float acc[block];
+            float tmp[block];
+            for ( std::size_t b = first; b < last; b += block )
+            {
+                std::size_t const m = std::min( block, last - b );
+                widen( slot( rank_ ) + b, acc, m );
+                for ( std::size_t step = 1; step != world_; ++step )
+                {
+                    widen( slot( ( rank_ + step ) % world_ ) + b, tmp, m );
+                    for ( std::size_t i = 0; i != m; ++i )
+                        acc[i] += tmp[i];
+                }
+                narrow( acc, slot( rank_ ) + b, m );
+            }
+            barrier();
+
+            // all-gather
+            for ( std::size_t r = 0; r != world_; ++r )
+            {
+                std::size_t const f = std::min( n, r * chunk );
+                std::size_t const l = std::min( n, f + chunk );
+                std::copy( slot( r ) + f, slot( r ) + l, data.begin() + f );
+            }
+            // slots may be overwritten by the next call only after everybody has gathered
+            barrier();
+        }
+
+        std::size_t rank_;
+        std::size_t world_;
+        std::size_t capacity_;
+        std::chrono::milliseconds timeout_;
+        std::size_t bytes_;
+        float16_t_private::shm_allreduce_header* header_;
+        float16_t* slots_;
+    };
+
+}//namespace numeric
+
+#endif
@@ -0,0 +1,216 @@
+#ifndef FLOAT16_T_ARROW_HPP_INCLUDED_SDFLKJ3409SDFLKJ3409SDFLKJSDF09U34LKJSDFLKJ
+#define FLOAT16_T_ARROW_HPP_INCLUDED_SDFLKJ3409SDFLKJ3409SDFLKJSDF09U34LKJSDFLKJ
+//
+// zero-copy exchange of float16_t columns through the Apache Arrow C data interface (format "e")
+// https://arrow.apache.org/docs/format/CDataInterface.html
+//
+#include "float16_t.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+extern "C"
+{
+// the ABI structs are copied verbatim from the specification, the guard lets them coexist with arrow's own headers
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema
+{
+    const char* format;
+    const char* name;
+    const char* metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema** children;
+    struct ArrowSchema* dictionary;
+    void ( *release )( struct ArrowSchema* );
+    void* private_data;
+};
+
+struct ArrowArray
+{
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void** buffers;
+    struct ArrowArray** children;
+    struct ArrowArray* dictionary;
+    void ( *release )( struct ArrowArray* );
+    void* private_data;
+};
+
+#endif // ARROW_C_DATA_INTERFACE
+}
+
+namespace numeric
+{
+    namespace float16_t_private
+    {
+        struct arrow_array_private
+        {
+            std::shared_ptr<void const> owner;
+            const void* buffers[2];
+        };
+
+        struct arrow_schema_private
+        {
+            std::string name;
+        };
+
+        inline void arrow_release_array( ArrowArray* array )
+        {
+            delete static_cast<arrow_array_private*>( array->private_data );
+            array->release = nullptr;
+        }
+
+        inline void arrow_release_schema( ArrowSchema* schema )
+        {
+            delete static_cast<arrow_schema_private*>( schema->private_data );
+            schema->release = nullptr;
+        }
+
+        inline std::int64_t count_nulls( std::uint8_t const* validity, std::size_t length ) noexcept
+        {
+            std::size_t valid = 0;
+            std::size_t const bytes = length / 8;
+            for ( std::size_t i = 0; i != bytes; ++i )
+                valid += std::popcount( validity[i] );
+            if ( length % 8 )
+                valid += std::popcount( static_cast<std::uint8_t>( validity[bytes] & ( ( 1u << ( length % 8 ) ) - 1 ) ) );
+            return static_cast<std::int64_t>( length - valid );
+        }
+
+    }//namespace float16_t_private
+
+    //
+    // fills `array` and `schema` with a HALF_FLOAT column pointing straight at `values`.
+    // `validity` is an optional LSB-ordered bitmap (bit set means valid) of at least (size + 7) / 8 bytes.
+    // `owner` keeps both buffers alive until the consumer calls the release callback.
+    //
+    inline void export_arrow( std::span<float16_t const> values, std::span<std::uint8_t const> validity,
+                              std::shared_ptr<void const> owner, ArrowArray* array, ArrowSchema* schema,
+                              std::string const& name = "" )
+    {
+        if ( !validity.empty() && validity.size() < ( values.size() + 7 ) / 8 )
+            throw std::invalid_argument( "export_arrow: validity bitmap too short" );
+
+        auto array_private = std::make_unique<float16_t_private::arrow_array_private>();
+        auto schema_private = std::make_unique<float16_t_private::arrow_schema_private>();
+        array_private->owner = std::move( owner );
+        array_private->buffers[0] = validity.empty() ? nullptr : validity.data();
+        array_private->buffers[1] = values.data();
+        schema_private->name = name;
+
+        array->length = static_cast<std::int64_t>( values.size() );
+        array->null_count = validity.empty() ? 0 : float16_t_private::count_nulls( validity.data(), values.size() );
+        array->offset = 0;
+        array->n_buffers = 2;
+        array->n_children = 0;
+        array->buffers = array_private->buffers;
+        array->children = nullptr;
+        array->dictionary = nullptr;
+        array->release = &float16_t_private::arrow_release_array;
+        array->private_data = array_private.release();
+
+        schema->format = "e";
+        schema->name = schema_private->name.c_str();
+        schema->metadata = nullptr;
+        schema->flags = validity.empty() ? 0 : ARROW_FLAG_NULLABLE;
+        schema->n_children = 0;
+        schema->children = nullptr;
+        schema->dictionary = nullptr;
+        schema->release = &float16_t_private::arrow_release_schema;
+        schema->private_data = schema_private.release();
+    }
+
+    //
+    // takes ownership of an exported HALF_FLOAT array (the source struct is marked released, as the
+    // specification requires for moves) and exposes its values without copying.
+    // the producer's release callback runs when this object is destroyed.
+    //
+    class arrow_float16_array
+    {
+    public:
+        arrow_float16_array( ArrowArray* array, ArrowSchema const* schema )
+        {
+            if ( !array || !array->release )
+                throw std::invalid_argument( "arrow_float16_array: array is released" );
+            if ( schema && ( !schema->format || std::strcmp( schema->format, "e" ) != 0 ) )
+                throw std::invalid_argument( "arrow_float16_array: schema format is not \"e\" (half float)" );
+            if ( array->n_buffers != 2 || array->n_children != 0 || array->length < 0 || array->offset < 0 )
+                throw std::invalid_argument( "arrow_float16_array: not a primitive half float array" );
+            if ( array->length > 0 && !array->buffers[1] )
+                throw std::invalid_argument( "arrow_float16_array: missing data buffer" );
+
+            array_ = *array;
+            array->release = nullptr;
+        }
+
+        arrow_float16_array( arrow_float16_array const& ) = delete;
+        arrow_float16_array& operator = ( arrow_float16_array const& ) = delete;
+
+        arrow_float16_array( arrow_float16_array&& other ) noexcept : array_{ other.array_ }
+        {
+            other.array_.release = nullptr;
+        }
+
+        arrow_float16_array& operator = ( arrow_float16_array&& other ) noexcept
+        {
+            if ( this != &other )
+            {
+                reset();
+                array_ = other.array_;
+                other.array_.release = nullptr;
+            }
+            return *this;
+        }
+
+        ~arrow_float16_array()
+        {
+            reset();
+        }
+
+        std::span<float16_t const> values() const noexcept
+        {
+            if ( !array_.release || array_.length == 0 ) return {};
+            return { static_cast<float16_t const*>( array_.buffers[1] ) + array_.offset, static_cast<std::size_t>( array_.length ) };
+        }
+
+        std::size_t size() const noexcept { return array_.release ? static_cast<std::size_t>( array_.length ) : 0; }
+        std::int64_t null_count() const noexcept { return array_.null_count; }
+
+        bool valid( std::size_t i ) const noexcept
+        {
+            auto const* bitmap = static_cast<std::uint8_t const*>( array_.buffers[0] );
+            if ( !bitmap ) return true;
+            std::size_t const bit = i + static_cast<std::size_t>( array_.offset );
+            return ( bitmap[bit / 8] >> ( bit % 8 ) ) & 1;
+        }
+
+    private:
+        void reset() noexcept
+        {
+            if ( array_.release )
+                array_.release( &array_ );
+        }
+
+        ArrowArray array_{};
+    };
+
+}//namespace numeric
+
+#endif
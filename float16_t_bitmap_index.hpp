@@ -0,0 +1,260 @@
+#ifndef FLOAT16_T_BITMAP_INDEX_HPP_INCLUDED_LSKDJF0394USDFLKJ3049USDFLKJ3049USDFLKJ
+#define FLOAT16_T_BITMAP_INDEX_HPP_INCLUDED_LSKDJF0394USDFLKJ3049USDFLKJ3049USDFLKJ
+//
+// bitmap index over an immutable float16_t column. rows are bucketed by the high bits of their
+// order key and every bucket keeps a roaring-style bitmap of its rows (65536-row containers stored
+// as sorted arrays when sparse, plain bitmaps when dense). a range query ORs the buckets it covers
+// and refines the two edge buckets against the values with the SIMD compare of float16_t_column.hpp;
+// ranges covering a large share of the rows are answered by that compare alone.
+//
+#include "float16_t.hpp"
+#include "float16_t_column.hpp"
+#include "float16_t_parallel.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace numeric
+{
+    namespace float16_t_private
+    {
+        // rows sharing row >> 16, converted from array to bitmap beyond 4096 entries
+        struct roaring_container
+        {
+            static constexpr std::size_t array_limit = 4096;
+
+            std::uint64_t key = 0;
+            std::uint32_t cardinality = 0;
+            std::vector<std::uint16_t> array;
+            std::vector<std::uint64_t> bits;
+
+            // rows must arrive in increasing order
+            void add( std::uint16_t low )
+            {
+                ++cardinality;
+                if ( bits.empty() )
+                {
+                    array.push_back( low );
+                    if ( array.size() <= array_limit ) return;
+                    bits.assign( 1024, 0 );
+                    for ( auto a : array )
+                        bits[a >> 6] |= std::uint64_t( 1 ) << ( a & 63 );
+                    array.clear();
+                    array.shrink_to_fit();
+                    return;
+                }
+                bits[low >> 6] |= std::uint64_t( 1 ) << ( low & 63 );
+            }
+
+            std::size_t bytes() const noexcept
+            {
+                return sizeof( *this ) + array.capacity() * sizeof( std::uint16_t ) + bits.capacity() * sizeof( std::uint64_t );
+            }
+        };
+
+        struct roaring_bitmap
+        {
+            std::vector<roaring_container> containers;
+
+            void add( std::size_t row )
+            {
+                std::uint64_t const key = row >> 16;
+                if ( containers.empty() || containers.back().key != key )
+                {
+                    containers.emplace_back();
+                    containers.back().key = key;
+                }
+                containers.back().add( static_cast<std::uint16_t>( row ) );
+            }
+
+            std::size_t cardinality() const noexcept
+            {
+                std::size_t n = 0;
+                for ( auto const& c : containers ) n += c.cardinality;
+                return n;
+            }
+
+            // `words` bounds the last, possibly partial, container
+            void or_into( std::uint64_t* selection, std::size_t words ) const
+            {
+                for ( auto const& c : containers )
+                {
+                    std::uint64_t* const out = selection + c.key * 1024;
+                    if ( c.bits.empty() )
+                        for ( auto a : c.array )
+                            out[a >> 6] |= std::uint64_t( 1 ) << ( a & 63 );
+                    else
+                        for ( std::size_t w = 0, n = std::min<std::size_t>( 1024, words - c.key * 1024 ); w != n; ++w )
+                            out[w] |= c.bits[w];
+                }
+            }
+        };
+
+        // rows per build task, a multiple of the container span so tasks own whole containers
+        constexpr inline std::size_t bitmap_index_grain = std::size_t( 1 ) << 18;
+
+        // queries touching more than 1/16 of the rows fall back to a full scan
+        constexpr inline std::size_t bitmap_index_scan_ratio = 16;
+
+    }//namespace float16_t_private
+
+    class float16_bitmap_index
+    {
+    public:
+        //
+        // copies `values` and buckets them on the top `bucket_bits` (1..16) bits of the order key,
+        // i.e. 2^bucket_bits buckets; row ranges are indexed in parallel on `threads`
+        //
+        explicit float16_bitmap_index( std::span<float16_t const> values, unsigned bucket_bits = 8, std::size_t threads = 0 )
+            : values_( values.begin(), values.end() ), shift_{ 16 - bucket_bits }
+        {
+            if ( bucket_bits < 1 || bucket_bits > 16 )
+                throw std::invalid_argument( "float16_bitmap_index: bucket_bits must be in [1, 16]" );
+
+            std::size_t const buckets = std::size_t( 1 ) << bucket_bits;
+            std::size_t const grain = float16_t_private::bitmap_index_grain;
+            std::size_t const tasks = ( values_.size() + grain - 1 ) / grain;
+            std::vector<std::vector<float16_t_private::roaring_bitmap>> partial( tasks );
+
+            float16_t_private::parallel_for( 0, tasks, 1, [&]( std::size_t first, std::size_t last )
+            {
+                for ( std::size_t t = first; t != last; ++t )
+                {
+                    auto& local = partial[t];
+                    local.resize( buckets );
+                    std::size_t const end = std::min( values_.size(), ( t + 1 ) * grain );
+                    for ( std::size_t row = t * grain; row != end; ++row )
+                        local[order_key( values_[row] ) >> shift_].add( row );
+                }
+            }, threads );
+
+            // tasks cover increasing row ranges, so appending keeps every bucket sorted by container key
+            buckets_.resize( buckets );
+            cardinality_.resize( buckets );
+            for ( std::size_t b = 0; b != buckets; ++b )
+            {
+                std::size_t count = 0;
+                for ( auto const& local : partial ) count += local[b].containers.size();
+                buckets_[b].containers.reserve( count );
+                for ( auto& local : partial )
+                    for ( auto& c : local[b].containers )
+                        buckets_[b].containers.push_back( std::move( c ) );
+                cardinality_[b] = buckets_[b].cardinality();
+            }
+        }
+
+        std::size_t size() const noexcept { return values_.size(); }
+        std::size_t bucket_count() const noexcept { return buckets_.size(); }
+        std::size_t bucket_cardinality( std::size_t bucket ) const noexcept { return cardinality_[bucket]; }
+
+        // memory held by the bitmaps (not counting the value copy)
+        std::size_t bytes() const noexcept
+        {
+            std::size_t n = 0;
+            for ( auto const& b : buckets_ )
+                for ( auto const& c : b.containers )
+                    n += c.bytes();
+            return n;
+        }
+
+        //
+        // writes one bit per row (LSB first, (size() + 63) / 64 words) for the rows whose value is in `range`
+        // and returns the number of matches
+        //
+        std::size_t query( value_range const& range, std::span<std::uint64_t> selection ) const
+        {
+            std::size_t const words = ( values_.size() + 63 ) / 64;
+            if ( selection.size() < words )
+                throw std::invalid_argument( "float16_bitmap_index::query: selection too small" );
+
+            std::uint64_t* const out = selection.data();
+            std::fill_n( out, words, 0 );
+            if ( range.empty() || values_.empty() )
+                return 0;
+
+            std::size_t const first = range.lo_key >> shift_;
+            std::size_t const last = range.hi_key >> shift_;
+            std::size_t const mask = ( std::size_t( 1 ) << shift_ ) - 1;
+
+            // visiting a row through the bitmaps costs far more than comparing it in a sequential scan,
+            // wide ranges are cheaper to answer from the values
+            std::size_t touched = 0;
+            for ( std::size_t b = first; b <= last; ++b )
+                touched += cardinality_[b];
+            if ( touched > values_.size() / float16_t_private::bitmap_index_scan_ratio )
+            {
+                std::size_t count = 0;
+                for ( std::size_t w = 0; w != words; ++w )
+                {
+                    out[w] = float16_t_private::match_word( values_.data() + w * 64, std::min<std::size_t>( 64, values_.size() - w * 64 ), range );
+                    count += static_cast<std::size_t>( std::popcount( out[w] ) );
+                }
+                return count;
+            }
+
+            for ( std::size_t b = first; b <= last; ++b )
+            {
+                bool const covers_low = b != first || ( range.lo_key & mask ) == 0;
+                bool const covers_high = b != last || ( range.hi_key & mask ) == mask;
+                if ( covers_low && covers_high )
+                    buckets_[b].or_into( out, words );
+                else
+                    refine( buckets_[b], range, out );
+            }
+
+            std::size_t count = 0;
+            for ( std::size_t w = 0; w != words; ++w )
+                count += static_cast<std::size_t>( std::popcount( out[w] ) );
+            return count;
+        }
+
+        std::vector<std::uint64_t> query( value_range const& range ) const
+        {
+            std::vector<std::uint64_t> selection( ( values_.size() + 63 ) / 64 );
+            query( range, selection );
+            return selection;
+        }
+
+        std::size_t count( value_range const& range ) const
+        {
+            std::vector<std::uint64_t> selection( ( values_.size() + 63 ) / 64 );
+            return query( range, selection );
+        }
+
+    private:
+        // only the rows of this bucket are compared: one by one in sparse containers, 64 at a time in dense ones
+        void refine( float16_t_private::roaring_bitmap const& bucket, value_range const& range, std::uint64_t* out ) const
+        {
+            for ( auto const& c : bucket.containers )
+            {
+                std::size_t const base = c.key * 65536;
+                if ( c.bits.empty() )
+                {
+                    for ( auto a : c.array )
+                        out[( base + a ) / 64] |= std::uint64_t( range.contains( values_[base + a] ) ) << ( a & 63 );
+                    continue;
+                }
+                for ( std::size_t w = 0; w != 1024; ++w )
+                {
+                    if ( !c.bits[w] ) continue;
+                    std::size_t const row = base + w * 64;
+                    std::size_t const n = std::min<std::size_t>( 64, values_.size() - row );
+                    out[row / 64] |= c.bits[w] & float16_t_private::match_word( values_.data() + row, n, range );
+                }
+            }
+        }
+
+        std::vector<float16_t> values_;
+        unsigned shift_;
+        std::vector<float16_t_private::roaring_bitmap> buckets_;
+        std::vector<std::size_t> cardinality_;
+    };
+
+}//namespace numeric
+
+#endif
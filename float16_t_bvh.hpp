@@ -0,0 +1,546 @@
+#ifndef FLOAT16_T_BVH_HPP_INCLUDED_SDLKFJ3409USDFLKJ3498UDSFLKJ3049USDFLKJ34SDF
+#define FLOAT16_T_BVH_HPP_INCLUDED_SDLKFJ3409USDFLKJ3498UDSFLKJ3049USDFLKJ34SDF
+//
+// 4-wide bounding volume hierarchy whose child boxes are stored as conservatively rounded float16_t,
+// one node is exactly one 64 byte cache line (a float node of the same arity needs 112 bytes)
+//
+#include "float16_t.hpp"
+#include "float16_t_parallel.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace numeric
+{
+    struct aabb
+    {
+        std::array<float, 3> min{ std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+        std::array<float, 3> max{ std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest() };
+
+        void grow( aabb const& other ) noexcept
+        {
+            for ( int a = 0; a != 3; ++a )
+            {
+                min[a] = std::min( min[a], other.min[a] );
+                max[a] = std::max( max[a], other.max[a] );
+            }
+        }
+
+        void grow( std::array<float, 3> const& p ) noexcept
+        {
+            for ( int a = 0; a != 3; ++a )
+            {
+                min[a] = std::min( min[a], p[a] );
+                max[a] = std::max( max[a], p[a] );
+            }
+        }
+
+        bool empty() const noexcept
+        {
+            return min[0] > max[0] || min[1] > max[1] || min[2] > max[2];
+        }
+
+        float half_area() const noexcept
+        {
+            if ( empty() ) return 0.0f;
+            float const dx = max[0] - min[0];
+            float const dy = max[1] - min[1];
+            float const dz = max[2] - min[2];
+            return dx * dy + dy * dz + dz * dx;
+        }
+
+        bool overlaps( aabb const& other ) const noexcept
+        {
+            for ( int a = 0; a != 3; ++a )
+                if ( min[a] > other.max[a] || max[a] < other.min[a] )
+                    return false;
+            return true;
+        }
+    };
+
+    struct ray
+    {
+        std::array<float, 3> origin{};
+        std::array<float, 3> direction{ 0.0f, 0.0f, 1.0f };
+        float t_min = 0.0f;
+        float t_max = std::numeric_limits<float>::max();
+    };
+
+    // structure of arrays over the 4 children so that one F16C conversion widens one coordinate of all of them
+    struct alignas(64) bvh4_node
+    {
+        float16_t min_x[4], min_y[4], min_z[4];
+        float16_t max_x[4], max_y[4], max_z[4];
+        std::uint32_t child[4];
+    };
+
+    static_assert( sizeof( bvh4_node ) == 64, "bvh4_node must fill exactly one cache line" );
+
+    namespace float16_t_private
+    {
+        constexpr inline std::uint32_t bvh_empty_child = 0xffffffffu;
+        constexpr inline std::uint32_t bvh_leaf_flag = 0x80000000u;
+        constexpr inline std::uint32_t bvh_leaf_count_bits = 4;
+        constexpr inline std::uint32_t bvh_max_leaf_size = ( 1u << bvh_leaf_count_bits ) - 1;
+        constexpr inline std::size_t bvh_bins = 16;
+        constexpr inline std::size_t bvh_parallel_threshold = 1 << 14;
+
+        struct bvh_build_node
+        {
+            aabb box;
+            std::unique_ptr<bvh_build_node> left;
+            std::unique_ptr<bvh_build_node> right;
+            std::uint32_t first = 0;
+            std::uint32_t count = 0;
+        };
+
+        struct bvh_bin
+        {
+            aabb box;
+            std::size_t count = 0;
+        };
+
+        class bvh_builder
+        {
+        public:
+            bvh_builder( std::span<aabb const> boxes, std::vector<std::uint32_t>& indices, std::size_t threads )
+                : boxes_{ boxes }, indices_{ indices }, threads_{ threads ? threads : hardware_threads() }
+            {
+                centroids_.resize( boxes.size() );
+                for ( std::size_t i = 0; i != boxes.size(); ++i )
+                    for ( int a = 0; a != 3; ++a )
+                        centroids_[i][a] = 0.5f * ( boxes[i].min[a] + boxes[i].max[a] );
+            }
+
+            std::unique_ptr<bvh_build_node> build( std::size_t first, std::size_t last, std::size_t depth ) const
+            {
+                auto node = std::make_unique<bvh_build_node>();
+                aabb centroid_box;
+                for ( std::size_t i = first; i != last; ++i )
+                {
+                    node->box.grow( boxes_[indices_[i]] );
+                    centroid_box.grow( centroids_[indices_[i]] );
+                }
+
+                std::size_t const count = last - first;
+                node->first = static_cast<std::uint32_t>( first );
+                node->count = static_cast<std::uint32_t>( count );
+                if ( count <= 2 )
+                    return node;
+
+                int axis = 0;
+                std::size_t split_bin = 0;
+                float const leaf_cost = static_cast<float>( count );
+                float best_cost = std::numeric_limits<float>::max();
+                float const parent_area = std::max( node->box.half_area(), std::numeric_limits<float>::min() );
+
+                for ( int a = 0; a != 3; ++a )
+                {
+                    float const extent = centroid_box.max[a] - centroid_box.min[a];
+                    if ( extent <= 0.0f )
+                        continue;
+                    auto const bins = bin( first, last, a, centroid_box.min[a], bvh_bins / extent );
+
+                    // sweep from the right to get the right-hand areas, then from the left to evaluate
+                    std::array<float, bvh_bins> right_area{};
+                    std::array<std::size_t, bvh_bins> right_count{};
+                    aabb acc;
+                    std::size_t cnt = 0;
+                    for ( std::size_t b = bvh_bins - 1; b != 0; --b )
+                    {
+                        acc.grow( bins[b].box );
+                        cnt += bins[b].count;
+                        right_area[b] = acc.half_area();
+                        right_count[b] = cnt;
+                    }
+                    acc = aabb{};
+                    cnt = 0;
+                    for ( std::size_t b = 0; b + 1 != bvh_bins; ++b )
+                    {
+                        acc.grow( bins[b].box );
+                        cnt += bins[b].count;
+                        if ( cnt == 0 || right_count[b+1] == 0 )
+                            continue;
+                        // unit traversal cost and unit intersection cost per primitive
+                        float const cost = 1.0f + ( acc.half_area() * cnt + right_area[b+1] * right_count[b+1] ) / parent_area;
+                        if ( cost < best_cost )
+                        {
+                            best_cost = cost;
+                            axis = a;
+                            split_bin = b;
+                        }
+                    }
+                }
+
+                std::size_t mid = first;
+                if ( best_cost == std::numeric_limits<float>::max() )
+                {
+                    // all centroids coincide
+                    if ( count <= bvh_max_leaf_size )
+                        return node;
+                    mid = first + count / 2;
+                }
+                else
+                {
+                    if ( leaf_cost <= best_cost && count <= bvh_max_leaf_size )
+                        return node;
+                    float const origin = centroid_box.min[axis];
+                    float const scale = bvh_bins / ( centroid_box.max[axis] - origin );
+                    auto const it = std::partition( indices_.begin() + first, indices_.begin() + last, [&]( std::uint32_t i )
+                    {
+                        return bin_of( centroids_[i][axis], origin, scale ) <= split_bin;
+                    } );
+                    mid = static_cast<std::size_t>( it - indices_.begin() );
+                }
+
+                // large subtrees near the root are built concurrently, their index ranges are disjoint
+                if ( count >= bvh_parallel_threshold && ( std::size_t{ 1 } << depth ) < threads_ )
+                {
+                    auto left = std::async( std::launch::async, [&, first, mid, depth] { return build( first, mid, depth + 1 ); } );
+                    node->right = build( mid, last, depth + 1 );
+                    node->left = left.get();
+                }
+                else
+                {
+                    node->left = build( first, mid, depth + 1 );
+                    node->right = build( mid, last, depth + 1 );
+                }
+                return node;
+            }
+
+        private:
+            static std::size_t bin_of( float c, float origin, float scale ) noexcept
+            {
+                auto const b = static_cast<std::size_t>( std::max( 0.0f, ( c - origin ) * scale ) );
+                return std::min( b, bvh_bins - 1 );
+            }
+
+            std::array<bvh_bin, bvh_bins> bin( std::size_t first, std::size_t last, int axis, float origin, float scale ) const
+            {
+                auto const fill = [&]( std::size_t b, std::size_t e )
+                {
+                    std::array<bvh_bin, bvh_bins> bins{};
+                    for ( std::size_t i = b; i != e; ++i )
+                    {
+                        auto& bn = bins[bin_of( centroids_[indices_[i]][axis], origin, scale )];
+                        bn.box.grow( boxes_[indices_[i]] );
+                        ++bn.count;
+                    }
+                    return bins;
+                };
+
+                if ( last - first < bvh_parallel_threshold )
+                    return fill( first, last );
+
+                // per-thread partial bins merged afterwards
+                std::size_t const parts = threads_;
+                std::size_t const step = ( last - first + parts - 1 ) / parts;
+                std::vector<std::array<bvh_bin, bvh_bins>> partial( parts );
+                parallel_for( 0, parts, 1, [&]( std::size_t pb, std::size_t pe )
+                {
+                    for ( std::size_t p = pb; p != pe; ++p )
+                    {
+                        std::size_t const b = std::min( last, first + p * step );
+                        partial[p] = fill( b, std::min( last, b + step ) );
+                    }
+                }, threads_ );
+
+                std::array<bvh_bin, bvh_bins> bins{};
+                for ( auto const& part : partial )
+                    for ( std::size_t b = 0; b != bvh_bins; ++b )
+                    {
+                        bins[b].box.grow( part[b].box );
+                        bins[b].count += part[b].count;
+                    }
+                return bins;
+            }
+
+            std::span<aabb const> boxes_;
+            std::vector<std::uint32_t>& indices_;
+            std::vector<std::array<float, 3>> centroids_;
+            std::size_t threads_;
+        };
+
+    }//namespace float16_t_private
+
+    class bvh4
+    {
+    public:
+        bvh4() = default;
+
+        // binned SAH build over the primitive bounds, `threads` 0 for hardware concurrency
+        explicit bvh4( std::span<aabb const> boxes, std::size_t threads = 0 )
+        {
+            if ( boxes.empty() )
+                return;
+            if ( boxes.size() >= ( std::size_t{ 1 } << ( 31 - float16_t_private::bvh_leaf_count_bits ) ) )
+                throw std::length_error( "bvh4: too many primitives" );
+
+            indices_.resize( boxes.size() );
+            for ( std::size_t i = 0; i != boxes.size(); ++i )
+                indices_[i] = static_cast<std::uint32_t>( i );
+
+            float16_t_private::bvh_builder builder{ boxes, indices_, threads };
+            auto root = builder.build( 0, boxes.size(), 0 );
+            bounds_ = root->box;
+
+            if ( !root->left )
+            {
+                // a single leaf still needs a node holding its box
+                nodes_.emplace_back();
+                float16_t_private::bvh_build_node const* only[1] = { root.get() };
+                fill_node( 0, only, 1 );
+            }
+            else
+                collapse( *root, 1 );
+        }
+
+        std::span<bvh4_node const> nodes() const noexcept { return nodes_; }
+        std::span<std::uint32_t const> primitive_indices() const noexcept { return indices_; }
+        aabb const& bounds() const noexcept { return bounds_; }
+
+        //
+        // calls on_primitive( primitive_index, t_max ) for each primitive in a leaf whose box the ray hits,
+        // the callback may shrink t_max (closest hit) to prune the rest of the traversal
+        //
+        template< typename Func >
+        void intersect( ray const& r, Func&& on_primitive ) const
+        {
+            if ( nodes_.empty() ) return;
+
+            float inv[3];
+            for ( int a = 0; a != 3; ++a )
+            {
+                float const d = r.direction[a];
+                float const tiny = 1.0e-30f;
+                inv[a] = 1.0f / ( std::abs( d ) > tiny ? d : ( d < 0.0f ? -tiny : tiny ) );
+            }
+            float t_max = r.t_max;
+
+            traversal_stack storage{ depth_ };
+            std::uint32_t* const stack = storage.data;
+            std::size_t top = 0;
+            stack[top++] = 0;
+            while ( top )
+            {
+                bvh4_node const& node = nodes_[stack[--top]];
+                float t_near[4];
+                unsigned const hits = slab_test( node, r.origin.data(), inv, r.t_min, t_max, t_near );
+
+                // hit children sorted far to near
+                std::uint32_t order[4];
+                unsigned n = 0;
+                for ( unsigned c = 0; c != 4; ++c )
+                    if ( hits & ( 1u << c ) )
+                    {
+                        unsigned k = n++;
+                        while ( k && t_near[order[k-1]] < t_near[c] )
+                        {
+                            order[k] = order[k-1];
+                            --k;
+                        }
+                        order[k] = c;
+                    }
+
+                // leaves nearest first, so a closest-hit callback shrinks t_max before the farther ones are
+                // reached; then the inner children still in range, far first so that the nearest is popped next
+                for ( unsigned k = n; k-- > 0; )
+                {
+                    std::uint32_t const child = node.child[order[k]];
+                    if ( ( child & float16_t_private::bvh_leaf_flag ) && t_near[order[k]] <= t_max )
+                        visit_leaf( child, t_max, on_primitive );
+                }
+                for ( unsigned k = 0; k != n; ++k )
+                {
+                    std::uint32_t const child = node.child[order[k]];
+                    if ( !( child & float16_t_private::bvh_leaf_flag ) && t_near[order[k]] <= t_max )
+                        stack[top++] = child;
+                }
+            }
+        }
+
+        // calls on_primitive( primitive_index ) for each primitive in a leaf whose box overlaps `query`
+        template< typename Func >
+        void intersect( aabb const& query, Func&& on_primitive ) const
+        {
+            if ( nodes_.empty() ) return;
+
+            traversal_stack storage{ depth_ };
+            std::uint32_t* const stack = storage.data;
+            std::size_t top = 0;
+            stack[top++] = 0;
+            while ( top )
+            {
+                bvh4_node const& node = nodes_[stack[--top]];
+                for ( unsigned c = 0; c != 4; ++c )
+                {
+                    std::uint32_t const child = node.child[c];
+                    if ( child == float16_t_private::bvh_empty_child )
+                        continue;
+                    aabb const box = child_box( node, c );
+                    if ( !box.overlaps( query ) )
+                        continue;
+                    if ( child & float16_t_private::bvh_leaf_flag )
+                    {
+                        std::uint32_t const first = ( child & ~float16_t_private::bvh_leaf_flag ) >> float16_t_private::bvh_leaf_count_bits;
+                        std::uint32_t const count = child & float16_t_private::bvh_max_leaf_size;
+                        for ( std::uint32_t i = first; i != first + count; ++i )
+                            on_primitive( indices_[i] );
+                    }
+                    else
+                        stack[top++] = child;
+                }
+            }
+        }
+
+        static aabb child_box( bvh4_node const& node, unsigned c ) noexcept
+        {
+            aabb box;
+            box.min = { float( node.min_x[c] ), float( node.min_y[c] ), float( node.min_z[c] ) };
+            box.max = { float( node.max_x[c] ), float( node.max_y[c] ), float( node.max_z[c] ) };
+            return box;
+        }
+
+    private:
+        template< typename Func >
+        void visit_leaf( std::uint32_t child, float& t_max, Func& on_primitive ) const
+        {
+            std::uint32_t const first = ( child & ~float16_t_private::bvh_leaf_flag ) >> float16_t_private::bvh_leaf_count_bits;
+            std::uint32_t const count = child & float16_t_private::bvh_max_leaf_size;
+            for ( std::uint32_t i = first; i != first + count; ++i )
+                on_primitive( indices_[i], t_max );
+        }
+
+        // returns a 4 bit mask of the children hit within [t_min, t_max]
+        static unsigned slab_test( bvh4_node const& node, float const* o, float const* inv, float t_min, float t_max, float* t_near ) noexcept
+        {
+            unsigned valid = 0;
+            for ( unsigned c = 0; c != 4; ++c )
+                valid |= ( node.child[c] != float16_t_private::bvh_empty_child ) << c;
+#if defined(__F16C__)
+            auto const load = []( float16_t const* h ) { return _mm_cvtph_ps( _mm_loadl_epi64( reinterpret_cast<__m128i const*>( h ) ) ); };
+            __m128 const ox = _mm_set1_ps( o[0] ), oy = _mm_set1_ps( o[1] ), oz = _mm_set1_ps( o[2] );
+            __m128 const ix = _mm_set1_ps( inv[0] ), iy = _mm_set1_ps( inv[1] ), iz = _mm_set1_ps( inv[2] );
+            __m128 const t0x = _mm_mul_ps( _mm_sub_ps( load( node.min_x ), ox ), ix );
+            __m128 const t1x = _mm_mul_ps( _mm_sub_ps( load( node.max_x ), ox ), ix );
+            __m128 const t0y = _mm_mul_ps( _mm_sub_ps( load( node.min_y ), oy ), iy );
+            __m128 const t1y = _mm_mul_ps( _mm_sub_ps( load( node.max_y ), oy ), iy );
+            __m128 const t0z = _mm_mul_ps( _mm_sub_ps( load( node.min_z ), oz ), iz );
+            __m128 const t1z = _mm_mul_ps( _mm_sub_ps( load( node.max_z ), oz ), iz );
+            __m128 const tn = _mm_max_ps( _mm_max_ps( _mm_min_ps( t0x, t1x ), _mm_min_ps( t0y, t1y ) ), _mm_max_ps( _mm_min_ps( t0z, t1z ), _mm_set1_ps( t_min ) ) );
+            __m128 const tf = _mm_min_ps( _mm_min_ps( _mm_max_ps( t0x, t1x ), _mm_max_ps( t0y, t1y ) ), _mm_min_ps( _mm_max_ps( t0z, t1z ), _mm_set1_ps( t_max ) ) );
+            _mm_storeu_ps( t_near, tn );
+            return static_cast<unsigned>( _mm_movemask_ps( _mm_cmple_ps( tn, tf ) ) ) & valid;
+#else
+            unsigned hits = 0;
+            for ( unsigned c = 0; c != 4; ++c )
+            {
+                aabb const box = child_box( node, c );
+                float tn = t_min;
+                float tf = t_max;
+                for ( int a = 0; a != 3; ++a )
+                {
+                    float const t0 = ( box.min[a] - o[a] ) * inv[a];
+                    float const t1 = ( box.max[a] - o[a] ) * inv[a];
+                    tn = std::max( tn, std::min( t0, t1 ) );
+                    tf = std::min( tf, std::max( t0, t1 ) );
+                }
+                t_near[c] = tn;
+                hits |= ( tn <= tf ) << c;
+            }
+            return hits & valid;
+#endif
+        }
+
+        void fill_node( std::size_t index, float16_t_private::bvh_build_node const* const* children, std::size_t n, std::size_t depth = 1 )
+        {
+            for ( std::size_t c = 0; c != 4; ++c )
+            {
+                std::uint32_t child = float16_t_private::bvh_empty_child;
+                aabb box;
+                box.min = { 0.0f, 0.0f, 0.0f };
+                box.max = { 0.0f, 0.0f, 0.0f };
+                if ( c < n )
+                {
+                    box = children[c]->box;
+                    if ( children[c]->left )
+                        child = collapse( *children[c], depth + 1 );
+                    else
+                        child = float16_t_private::bvh_leaf_flag | ( children[c]->first << float16_t_private::bvh_leaf_count_bits ) | children[c]->count;
+                }
+                // collapse() may have reallocated the node array
+                bvh4_node& node = nodes_[index];
+                node.child[c] = child;
+                node.min_x[c] = round_down( box.min[0] );
+                node.min_y[c] = round_down( box.min[1] );
+                node.min_z[c] = round_down( box.min[2] );
+                node.max_x[c] = round_up( box.max[0] );
+                node.max_y[c] = round_up( box.max[1] );
+                node.max_z[c] = round_up( box.max[2] );
+            }
+        }
+
+        // turns a binary build node into a 4-wide node by repeatedly opening the largest inner child
+        std::uint32_t collapse( float16_t_private::bvh_build_node const& root, std::size_t depth )
+        {
+            depth_ = std::max( depth_, depth );
+            std::size_t const index = nodes_.size();
+            nodes_.emplace_back();
+
+            float16_t_private::bvh_build_node const* children[4] = { root.left.get(), root.right.get(), nullptr, nullptr };
+            std::size_t n = 2;
+            while ( n < 4 )
+            {
+                std::size_t best = 4;
+                float best_area = -1.0f;
+                for ( std::size_t c = 0; c != n; ++c )
+                    if ( children[c]->left && children[c]->box.half_area() > best_area )
+                    {
+                        best = c;
+                        best_area = children[c]->box.half_area();
+                    }
+                if ( best == 4 )
+                    break;
+                auto const* opened = children[best];
+                children[best] = opened->left.get();
+                children[n++] = opened->right.get();
+            }
+
+            fill_node( index, children, n, depth );
+            return static_cast<std::uint32_t>( index );
+        }
+
+        // traversal stack holding at most 3 pending siblings per level plus the current node
+        struct traversal_stack
+        {
+            explicit traversal_stack( std::size_t depth )
+            {
+                if ( 3 * depth + 1 > sizeof( local ) / sizeof( local[0] ) )
+                {
+                    heap.resize( 3 * depth + 1 );
+                    data = heap.data();
+                }
+            }
+
+            std::uint32_t local[192];
+            std::vector<std::uint32_t> heap;
+            std::uint32_t* data = local;
+        };
+
+        std::vector<bvh4_node> nodes_;
+        std::vector<std::uint32_t> indices_;
+        aabb bounds_;
+        std::size_t depth_ = 1;
+    };
+
+}//namespace numeric
+
+#endif
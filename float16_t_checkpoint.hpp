@@ -0,0 +1,362 @@
+#ifndef FLOAT16_T_CHECKPOINT_HPP_INCLUDED_SDFLKJ3049USDFLKJ0349USDLFKJ3049USDFLKJSD
+#define FLOAT16_T_CHECKPOINT_HPP_INCLUDED_SDFLKJ3049USDFLKJ0349USDLFKJ3049USDFLKJSD
+//
+// background checkpointing of float16_t tensors. save() snapshots the tensors into one of a few preallocated
+// file images (so the caller may keep mutating its buffers right away) and queues the image to a dedicated
+// writer thread, which pwrites it in large aligned pieces to a temporary file, batches the fsyncs of
+// back-to-back checkpoints, and renames each file into place before fulfilling its future.
+// files are safetensors with the data section 4096-aligned, safetensors_reader maps them for restore.
+//
+#include "float16_t.hpp"
+#include "float16_t_parallel.hpp"
+#include "float16_t_safetensors.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <set>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace numeric
+{
+    struct checkpoint_options
+    {
+        std::size_t buffers = 2;                             // snapshots that may be queued or in flight at once
+        std::size_t write_bytes = std::size_t( 8 ) << 20;    // bytes per pwrite, rounded up to a multiple of 4096
+        std::size_t sync_batch = 4;                          // most files written before their fsyncs are issued
+        bool direct_io = false;                              // O_DIRECT, silently dropped where the file system refuses it
+        std::size_t threads = 0;                             // threads copying the snapshot, 0 means all hardware threads
+    };
+
+    struct checkpoint_tensor
+    {
+        std::string name;
+        std::vector<std::int64_t> shape;
+        std::span<float16_t const> data;
+    };
+
+    namespace float16_t_private
+    {
+        constexpr inline std::size_t checkpoint_alignment = 4096;
+        constexpr inline std::size_t checkpoint_copy_grain = std::size_t( 1 ) << 20;
+
+        // a growable 4096-aligned byte buffer holding one complete file
+        class checkpoint_image
+        {
+        public:
+            std::byte* data() const noexcept { return data_.get(); }
+
+            void reserve( std::size_t bytes )
+            {
+                if ( bytes <= capacity_ ) return;
+                data_.reset( static_cast<std::byte*>( ::operator new[]( bytes, std::align_val_t{ checkpoint_alignment } ) ) );
+                capacity_ = bytes;
+            }
+
+        private:
+            struct aligned_free
+            {
+                void operator()( std::byte* p ) const noexcept { ::operator delete[]( p, std::align_val_t{ checkpoint_alignment } ); }
+            };
+
+            std::unique_ptr<std::byte[], aligned_free> data_;
+            std::size_t capacity_ = 0;
+        };
+
+        // every queued file gets its own temporary name, so back-to-back saves to one path never share it
+        inline std::string temporary_name( std::string const& path )
+        {
+            static std::atomic<std::uint64_t> sequence{ 0 };
+            return path + ".tmp." + std::to_string( ::getpid() ) + "." + std::to_string( sequence.fetch_add( 1, std::memory_order_relaxed ) );
+        }
+
+        inline std::string parent_directory( std::string const& path )
+        {
+            std::size_t const slash = path.find_last_of( '/' );
+            if ( slash == std::string::npos ) return ".";
+            return slash == 0 ? "/" : path.substr( 0, slash );
+        }
+
+    }//namespace float16_t_private
+
+    class checkpoint_writer
+    {
+    public:
+        explicit checkpoint_writer( checkpoint_options const& options = {} ) : options_{ options }, images_( options.buffers )
+        {
+            if ( options_.buffers == 0 || options_.sync_batch == 0 )
+                throw std::invalid_argument( "checkpoint_writer: buffers and sync_batch must be positive" );
+            std::size_t const a = float16_t_private::checkpoint_alignment;
+            options_.write_bytes = std::max( a, ( options_.write_bytes + a - 1 ) / a * a );
+            for ( std::size_t i = 0; i != images_.size(); ++i )
+                free_.push_back( i );
+            thread_ = std::thread{ [this] { run(); } };
+        }
+
+        checkpoint_writer( checkpoint_writer const& ) = delete;
+        checkpoint_writer& operator = ( checkpoint_writer const& ) = delete;
+
+        // finishes every queued checkpoint
+        ~checkpoint_writer()
+        {
+            {
+                std::lock_guard lock{ mutex_ };
+                stop_ = true;
+            }
+            queued_.notify_all();
+            thread_.join();
+        }
+
+        //
+        // copies the tensors into a free snapshot buffer, waiting for one if all are still being written, and
+        // queues the file; the future becomes ready once `path` is durable, or carries the I/O error
+        //
+        std::future<void> save( std::string const& path, std::vector<checkpoint_tensor> const& tensors,
+                                std::map<std::string, std::string> const& metadata = {} )
+        {
+            std::vector<safetensors_tensor> layout;
+            layout.reserve( tensors.size() );
+            for ( auto const& t : tensors )
+            {
+                layout.push_back( { t.name, "F16", t.shape, 0, 0 } );
+                if ( float16_t_private::element_count( t.shape ) != t.data.size() )
+                    throw std::invalid_argument( "checkpoint_writer: tensor " + t.name + " size does not match its shape" );
+            }
+            std::string const header = float16_t_private::safetensors_header( layout, metadata, float16_t_private::checkpoint_alignment );
+            std::size_t const bytes = header.size() + static_cast<std::size_t>( layout.empty() ? 0 : layout.back().end );
+            std::size_t const padded = ( bytes + float16_t_private::checkpoint_alignment - 1 ) / float16_t_private::checkpoint_alignment * float16_t_private::checkpoint_alignment;
+
+            std::size_t slot;
+            {
+                std::unique_lock lock{ mutex_ };
+                released_.wait( lock, [&] { return !free_.empty(); } );
+                slot = free_.back();
+                free_.pop_back();
+            }
+
+            auto& image = images_[slot];
+            try { image.reserve( padded ); }
+            catch ( ... )
+            {
+                release( slot );
+                throw;
+            }
+            std::byte* const base = image.data();
+            std::memcpy( base, header.data(), header.size() );
+            std::memset( base + bytes, 0, padded - bytes );
+
+            // the snapshot: flat pieces of every tensor, copied in parallel
+            float16_t_private::parallel_for( 0, bytes - header.size(), float16_t_private::checkpoint_copy_grain, [&]( std::size_t first, std::size_t last )
+            {
+                for ( std::size_t i = 0; i != layout.size() && first < last; ++i )
+                {
+                    std::size_t const b = static_cast<std::size_t>( layout[i].begin ), e = static_cast<std::size_t>( layout[i].end );
+                    if ( e <= first || b >= last ) continue;
+                    std::size_t const from = std::max( b, first ), to = std::min( e, last );
+                    std::memcpy( base + header.size() + from, reinterpret_cast<std::byte const*>( tensors[i].data.data() ) + ( from - b ), to - from );
+                }
+            }, options_.threads );
+
+            job j{ path, slot, bytes, {} };
+            std::future<void> done = j.done.get_future();
+            {
+                std::lock_guard lock{ mutex_ };
+                jobs_.push_back( std::move( j ) );
+            }
+            queued_.notify_one();
+            return done;
+        }
+
+        // blocks until every checkpoint saved so far is durable (or failed)
+        void wait()
+        {
+            std::unique_lock lock{ mutex_ };
+            idle_.wait( lock, [&] { return jobs_.empty() && !busy_; } );
+        }
+
+    private:
+        struct job
+        {
+            std::string path;
+            std::size_t slot = 0;
+            std::size_t bytes = 0;
+            std::promise<void> done;
+        };
+
+        // written, not yet synced
+        struct written
+        {
+            int fd;
+            std::string temporary;
+            std::string path;
+            std::promise<void> done;
+        };
+
+        void release( std::size_t slot )
+        {
+            {
+                std::lock_guard lock{ mutex_ };
+                free_.push_back( slot );
+            }
+            released_.notify_one();
+        }
+
+        void run()
+        {
+            std::vector<written> unsynced;
+            for ( ;; )
+            {
+                job j;
+                {
+                    std::unique_lock lock{ mutex_ };
+                    if ( jobs_.empty() )
+                    {
+                        busy_ = false;
+                        idle_.notify_all();
+                    }
+                    queued_.wait( lock, [&] { return !jobs_.empty() || stop_; } );
+                    if ( jobs_.empty() ) break;
+                    j = std::move( jobs_.front() );
+                    jobs_.pop_front();
+                    busy_ = true;
+                }
+
+                std::string temporary = float16_t_private::temporary_name( j.path );
+                try
+                {
+                    int const fd = write_file( temporary, images_[j.slot].data(), j.bytes );
+                    unsynced.push_back( { fd, std::move( temporary ), std::move( j.path ), std::move( j.done ) } );
+                }
+                catch ( ... )
+                {
+                    j.done.set_exception( std::current_exception() );
+                }
+                release( j.slot );
+
+                bool more;
+                {
+                    std::lock_guard lock{ mutex_ };
+                    more = !jobs_.empty();
+                }
+                if ( !more || unsynced.size() >= options_.sync_batch )
+                    sync( unsynced );
+            }
+            sync( unsynced );
+            std::lock_guard lock{ mutex_ };
+            busy_ = false;
+            idle_.notify_all();
+        }
+
+        // pwrites the image in write_bytes pieces and returns the open descriptor
+        int write_file( std::string const& path, std::byte const* data, std::size_t bytes )
+        {
+            int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+            bool direct = false;
+#ifdef O_DIRECT
+            if ( options_.direct_io ) { flags |= O_DIRECT; direct = true; }
+#endif
+            int fd = ::open( path.c_str(), flags, 0644 );
+#ifdef O_DIRECT
+            if ( fd < 0 && direct && errno == EINVAL )
+            {
+                direct = false;
+                fd = ::open( path.c_str(), flags & ~O_DIRECT, 0644 );
+            }
+#endif
+            if ( fd < 0 )
+                throw std::system_error( errno, std::generic_category(), "checkpoint_writer: open " + path );
+
+            // direct writes must cover whole blocks, the zero padding past `bytes` is truncated afterwards
+            std::size_t const a = float16_t_private::checkpoint_alignment;
+            std::size_t const total = direct ? ( bytes + a - 1 ) / a * a : bytes;
+            for ( std::size_t done = 0; done < total; )
+            {
+                ssize_t const r = ::pwrite( fd, data + done, std::min( options_.write_bytes, total - done ), static_cast<off_t>( done ) );
+                if ( r < 0 && errno == EINTR ) continue;
+                if ( r <= 0 )
+                {
+                    int const err = r < 0 ? errno : EIO;
+                    ::close( fd );
+                    ::unlink( path.c_str() );
+                    throw std::system_error( err, std::generic_category(), "checkpoint_writer: pwrite " + path );
+                }
+                done += static_cast<std::size_t>( r );
+            }
+            if ( total != bytes && ::ftruncate( fd, static_cast<off_t>( bytes ) ) != 0 )
+            {
+                int const err = errno;
+                ::close( fd );
+                ::unlink( path.c_str() );
+                throw std::system_error( err, std::generic_category(), "checkpoint_writer: ftruncate " + path );
+            }
+            return fd;
+        }
+
+        // one round of fsyncs for the batch, then the renames and a single fsync per directory
+        static void sync( std::vector<written>& batch )
+        {
+            std::set<std::string> directories;
+            for ( auto& w : batch )
+            {
+                int err = ::fsync( w.fd ) == 0 ? 0 : errno;
+                ::close( w.fd );
+                if ( err == 0 && ::rename( w.temporary.c_str(), w.path.c_str() ) != 0 )
+                    err = errno;
+                if ( err )
+                {
+                    ::unlink( w.temporary.c_str() );
+                    w.done.set_exception( std::make_exception_ptr( std::system_error( err, std::generic_category(), "checkpoint_writer: " + w.path ) ) );
+                    w.fd = -1;
+                    continue;
+                }
+                directories.insert( float16_t_private::parent_directory( w.path ) );
+            }
+            for ( auto const& d : directories )
+            {
+                int const fd = ::open( d.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC );
+                if ( fd >= 0 )
+                {
+                    ::fsync( fd );
+                    ::close( fd );
+                }
+            }
+            for ( auto& w : batch )
+                if ( w.fd >= 0 ) w.done.set_value();
+            batch.clear();
+        }
+
+        checkpoint_options options_;
+        std::vector<float16_t_private::checkpoint_image> images_;
+        std::vector<std::size_t> free_;
+        std::deque<job> jobs_;
+        bool busy_ = false;
+        bool stop_ = false;
+        std::mutex mutex_;
+        std::condition_variable queued_, released_, idle_;
+        std::thread thread_;
+    };
+
+}//namespace numeric
+
+#endif
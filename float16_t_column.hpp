@@ -0,0 +1,310 @@
+#ifndef FLOAT16_T_COLUMN_HPP_INCLUDED_SDLKFJ3049USDFLKJ3049USDLFKJ3094USDLFKJSDF
+#define FLOAT16_T_COLUMN_HPP_INCLUDED_SDLKFJ3049USDFLKJ3049USDLFKJ3094USDLFKJSDF
+//
+// append-only float16_t column split into fixed size blocks, each block carries a zone map
+// (min/max order key, null and NaN counts) computed at ingest. range scans skip or fully accept
+// blocks from their zone map and compare the remaining ones 32 values at a time on the order key.
+//
+#include "float16_t.hpp"
+#include "float16_t_parallel.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__AVX512BW__)
+#include <immintrin.h>
+#endif
+
+namespace numeric
+{
+    //
+    // inclusive range of order keys, NaNs never fall inside and a zero bound covers both -0 and +0
+    //
+    struct value_range
+    {
+        std::uint16_t lo_key = 1;
+        std::uint16_t hi_key = 0;
+
+        bool empty() const noexcept { return lo_key > hi_key; }
+
+        bool contains( float16_t f16 ) const noexcept
+        {
+            std::uint16_t const k = order_key( f16 );
+            return k >= lo_key && k <= hi_key;
+        }
+
+        static value_range between( float16_t lo, float16_t hi ) noexcept
+        {
+            if ( float16_t_private::is_nan_bits( std::uint16_t( lo ) ) || float16_t_private::is_nan_bits( std::uint16_t( hi ) ) )
+                return {};
+            return { lowest_key( lo ), highest_key( hi ) };
+        }
+
+        static value_range equal( float16_t v ) noexcept { return between( v, v ); }
+        static value_range greater_equal( float16_t v ) noexcept { return between( v, fp16_infinity ); }
+        static value_range less_equal( float16_t v ) noexcept { return between( fp16_infinity_negative, v ); }
+
+        static value_range greater( float16_t v ) noexcept
+        {
+            value_range r = greater_equal( v );
+            if ( !r.empty() ) r.lo_key = static_cast<std::uint16_t>( highest_key( v ) + 1 );
+            return r;
+        }
+
+        static value_range less( float16_t v ) noexcept
+        {
+            value_range r = less_equal( v );
+            if ( !r.empty() ) r.hi_key = static_cast<std::uint16_t>( lowest_key( v ) - 1 );
+            return r;
+        }
+
+    private:
+        static std::uint16_t lowest_key( float16_t v ) noexcept
+        {
+            return ( std::uint16_t( v ) & 0x7fff ) == 0 ? order_key( fp16_zero_negative ) : order_key( v );
+        }
+
+        static std::uint16_t highest_key( float16_t v ) noexcept
+        {
+            return ( std::uint16_t( v ) & 0x7fff ) == 0 ? order_key( fp16_zero ) : order_key( v );
+        }
+    };
+
+    struct zone_map
+    {
+        std::uint16_t min_key = 0xffff;    // over valid, non-NaN values
+        std::uint16_t max_key = 0;
+        std::size_t null_count = 0;
+        std::size_t nan_count = 0;
+        std::size_t size = 0;
+
+        bool has_values() const noexcept { return min_key <= max_key; }
+        float16_t min() const noexcept { return from_order_key( min_key ); }
+        float16_t max() const noexcept { return from_order_key( max_key ); }
+    };
+
+    struct scan_result
+    {
+        std::vector<std::uint64_t> selection;  // one bit per row, LSB first
+        std::size_t matches = 0;
+        std::size_t blocks_skipped = 0;        // rejected by their zone map
+        std::size_t blocks_accepted = 0;       // entirely inside the range, no compare needed
+        std::size_t blocks_scanned = 0;
+
+        bool selected( std::size_t row ) const noexcept { return ( selection[row / 64] >> ( row % 64 ) ) & 1; }
+    };
+
+    namespace float16_t_private
+    {
+        // signed 16-bit compare on order_key ^ 0x8000, which is bits ^ 0x7fff for negatives and bits otherwise
+        inline std::uint64_t match_word( float16_t const* values, std::size_t n, value_range const& range ) noexcept
+        {
+            std::uint64_t word = 0;
+            std::size_t i = 0;
+#if defined(__AVX512BW__)
+            __m512i const lo = _mm512_set1_epi16( static_cast<short>( range.lo_key ) );
+            __m512i const hi = _mm512_set1_epi16( static_cast<short>( range.hi_key ) );
+            for ( ; i + 32 <= n; i += 32 )
+            {
+                __m512i const v = _mm512_loadu_si512( values + i );
+                __m512i const key = _mm512_xor_si512( v, _mm512_or_si512( _mm512_srai_epi16( v, 15 ), _mm512_set1_epi16( static_cast<short>( 0x8000 ) ) ) );
+                __mmask32 const m = _mm512_mask_cmple_epu16_mask( _mm512_cmpge_epu16_mask( key, lo ), key, hi );
+                word |= std::uint64_t( m ) << i;
+            }
+#elif defined(__AVX2__)
+            __m256i const lo = _mm256_set1_epi16( static_cast<short>( range.lo_key ^ 0x8000 ) );
+            __m256i const hi = _mm256_set1_epi16( static_cast<short>( range.hi_key ^ 0x8000 ) );
+            auto const outside = [&]( __m256i v )
+            {
+                __m256i const key = _mm256_xor_si256( v, _mm256_srli_epi16( _mm256_srai_epi16( v, 15 ), 1 ) );
+                return _mm256_or_si256( _mm256_cmpgt_epi16( lo, key ), _mm256_cmpgt_epi16( key, hi ) );
+            };
+            for ( ; i + 32 <= n; i += 32 )
+            {
+                __m256i const a = outside( _mm256_loadu_si256( reinterpret_cast<__m256i const*>( values + i ) ) );
+                __m256i const b = outside( _mm256_loadu_si256( reinterpret_cast<__m256i const*>( values + i + 16 ) ) );
+                // packs interleaves 128-bit lanes, the permute restores element order
+                __m256i const packed = _mm256_permute4x64_epi64( _mm256_packs_epi16( a, b ), 0xd8 );
+                std::uint32_t const m = ~static_cast<std::uint32_t>( _mm256_movemask_epi8( packed ) );
+                word |= std::uint64_t( m ) << i;
+            }
+#endif
+            for ( ; i < n; ++i )
+                word |= std::uint64_t( range.contains( values[i] ) ) << i;
+            return word;
+        }
+
+        inline void update_zone( zone_map& zone, float16_t const* values, std::uint64_t const* validity, std::size_t first, std::size_t n ) noexcept
+        {
+            std::uint16_t lo = zone.min_key, hi = zone.max_key;
+            for ( std::size_t i = 0; i != n; ++i )
+            {
+                std::size_t const row = first + i;
+                if ( validity && !( ( validity[row / 64] >> ( row % 64 ) ) & 1 ) )
+                {
+                    ++zone.null_count;
+                    continue;
+                }
+                std::uint16_t const bits = std::uint16_t( values[row] );
+                if ( is_nan_bits( bits ) )
+                {
+                    ++zone.nan_count;
+                    continue;
+                }
+                std::uint16_t const k = order_key( values[row] );
+                lo = std::min( lo, k );
+                hi = std::max( hi, k );
+            }
+            zone.min_key = lo;
+            zone.max_key = hi;
+            zone.size += n;
+        }
+
+    }//namespace float16_t_private
+
+    class float16_column
+    {
+    public:
+        // the block size is rounded up to a multiple of 64 so blocks own whole selection words
+        explicit float16_column( std::size_t block_size = 65536 )
+            : block_size_{ std::max<std::size_t>( ( block_size + 63 ) / 64 * 64, 64 ) } { }
+
+        //
+        // appends `values`; `validity` is an optional LSB-ordered bitmap (bit set means valid) of at least
+        // (values.size() + 7) / 8 bytes, as in arrow
+        //
+        void append( std::span<float16_t const> values, std::span<std::uint8_t const> validity = {} )
+        {
+            if ( !validity.empty() && validity.size() < ( values.size() + 7 ) / 8 )
+                throw std::invalid_argument( "float16_column::append: validity bitmap too short" );
+
+            std::size_t const first = values_.size();
+            values_.insert( values_.end(), values.begin(), values.end() );
+
+            bool has_nulls = !validity_.empty();
+            if ( !validity.empty() && !has_nulls )
+                for ( std::size_t i = 0; i != values.size() && !has_nulls; ++i )
+                    has_nulls = !( ( validity[i / 8] >> ( i % 8 ) ) & 1 );
+            if ( has_nulls )
+            {
+                // materialized on the first null, everything before it is valid
+                if ( validity_.empty() )
+                {
+                    validity_.assign( ( first + 63 ) / 64, ~std::uint64_t( 0 ) );
+                    if ( first % 64 )
+                        validity_.back() &= ( std::uint64_t( 1 ) << ( first % 64 ) ) - 1;
+                }
+                validity_.resize( ( values_.size() + 63 ) / 64, 0 );
+                for ( std::size_t i = 0; i != values.size(); ++i )
+                {
+                    bool const valid = validity.empty() || ( ( validity[i / 8] >> ( i % 8 ) ) & 1 );
+                    std::size_t const row = first + i;
+                    validity_[row / 64] |= std::uint64_t( valid ) << ( row % 64 );
+                }
+            }
+
+            for ( std::size_t row = first; row != values_.size(); )
+            {
+                std::size_t const block = row / block_size_;
+                if ( block == zones_.size() )
+                    zones_.emplace_back();
+                std::size_t const n = std::min( values_.size(), ( block + 1 ) * block_size_ ) - row;
+                float16_t_private::update_zone( zones_[block], values_.data(), validity_.empty() ? nullptr : validity_.data(), row, n );
+                row += n;
+            }
+        }
+
+        std::size_t size() const noexcept { return values_.size(); }
+        std::size_t block_size() const noexcept { return block_size_; }
+        std::span<zone_map const> zones() const noexcept { return zones_; }
+        std::span<float16_t const> values() const noexcept { return values_; }
+        float16_t operator[]( std::size_t row ) const noexcept { return values_[row]; }
+
+        bool valid( std::size_t row ) const noexcept
+        {
+            return validity_.empty() || ( ( validity_[row / 64] >> ( row % 64 ) ) & 1 );
+        }
+
+        //
+        // selects the valid rows whose value lies in `range`, blocks are distributed over `threads`
+        // (0 means all hardware threads)
+        //
+        scan_result scan( value_range const& range, std::size_t threads = 0 ) const
+        {
+            scan_result result;
+            result.selection.assign( ( values_.size() + 63 ) / 64, 0 );
+            if ( range.empty() || values_.empty() )
+            {
+                result.blocks_skipped = zones_.size();
+                return result;
+            }
+
+            enum : std::uint8_t { skipped, accepted, scanned };
+            std::vector<std::uint8_t> outcome( zones_.size() );
+            std::vector<std::size_t> matches( zones_.size() );
+
+            float16_t_private::parallel_for( 0, zones_.size(), 1, [&]( std::size_t first_block, std::size_t last_block )
+            {
+                for ( std::size_t b = first_block; b != last_block; ++b )
+                {
+                    zone_map const& zone = zones_[b];
+                    std::size_t const row = b * block_size_;
+                    std::uint64_t* const words = result.selection.data() + row / 64;
+                    std::size_t const word_count = ( zone.size + 63 ) / 64;
+
+                    if ( !zone.has_values() || zone.max_key < range.lo_key || zone.min_key > range.hi_key )
+                    {
+                        outcome[b] = skipped;
+                        continue;
+                    }
+
+                    if ( zone.null_count == 0 && zone.nan_count == 0 && range.lo_key <= zone.min_key && zone.max_key <= range.hi_key )
+                    {
+                        std::fill_n( words, word_count, ~std::uint64_t( 0 ) );
+                        if ( zone.size % 64 )
+                            words[word_count - 1] = ( std::uint64_t( 1 ) << ( zone.size % 64 ) ) - 1;
+                        outcome[b] = accepted;
+                        matches[b] = zone.size;
+                        continue;
+                    }
+
+                    std::size_t count = 0;
+                    for ( std::size_t w = 0; w != word_count; ++w )
+                    {
+                        std::size_t const n = std::min<std::size_t>( 64, zone.size - w * 64 );
+                        std::uint64_t word = float16_t_private::match_word( values_.data() + row + w * 64, n, range );
+                        if ( !validity_.empty() )
+                            word &= validity_[row / 64 + w];
+                        words[w] = word;
+                        count += static_cast<std::size_t>( std::popcount( word ) );
+                    }
+                    outcome[b] = scanned;
+                    matches[b] = count;
+                }
+            }, threads );
+
+            for ( std::size_t b = 0; b != zones_.size(); ++b )
+            {
+                result.matches += matches[b];
+                result.blocks_skipped += outcome[b] == skipped;
+                result.blocks_accepted += outcome[b] == accepted;
+                result.blocks_scanned += outcome[b] == scanned;
+            }
+            return result;
+        }
+
+    private:
+        std::size_t block_size_;
+        std::vector<float16_t> values_;
+        std::vector<std::uint64_t> validity_;  // empty until the first null
+        std::vector<zone_map> zones_;
+    };
+
+}//namespace numeric
+
+#endif
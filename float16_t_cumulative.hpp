@@ -0,0 +1,342 @@
+#ifndef FLOAT16_T_CUMULATIVE_HPP_INCLUDED_SLDKFJ3049USDFLKJ3049USDFLKJ3049USDFLKJ
+#define FLOAT16_T_CUMULATIVE_HPP_INCLUDED_SLDKFJ3049USDFLKJ3049USDFLKJ3049USDFLKJ
+//
+// prefix scans over float16_t arrays: inclusive and exclusive scans, cumsum, cumprod and cummax.
+// sums and products are carried in fp32 and written as half or float; the maximum is taken on the
+// order key, which is exact and lets any NaN propagate. large inputs use a two-level scan: every
+// thread reduces its block, block offsets are scanned serially, then every block is scanned with its
+// offset. within a block, vectors of 8 (fp32) or 16 (keys) elements are scanned in registers.
+//
+#include "float16_t.hpp"
+#include "float16_t_parallel.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__) && defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+namespace numeric
+{
+    enum class scan_op
+    {
+        sum,
+        product,
+        max
+    };
+
+    namespace float16_t_private
+    {
+        constexpr inline std::size_t scan_grain = 1 << 16;
+
+        template< scan_op Op >
+        constexpr float scan_identity() noexcept
+        {
+            return Op == scan_op::product ? 1.0f : 0.0f;
+        }
+
+        template< scan_op Op >
+        inline float scan_combine( float a, float b ) noexcept
+        {
+            if constexpr ( Op == scan_op::product ) return a * b;
+            else return a + b;
+        }
+
+        // NaNs map to the top key, so they win every max and stay in the scan
+        inline std::uint16_t max_key( float16_t f16 ) noexcept
+        {
+            return is_nan_bits( std::uint16_t( f16 ) ) ? std::uint16_t( 0xffff ) : order_key( f16 );
+        }
+
+        // saturates like the F16C path, the core conversion does not beyond fp16_max;
+        // in range values go through narrow so ties round to even in tails too
+        template< typename Out >
+        inline Out scan_output( float x ) noexcept
+        {
+            if constexpr ( std::is_same_v<Out, float16_t> )
+            {
+                if ( x > 65504.0f ) return x < 65520.0f ? fp16_max : fp16_infinity;
+                if ( x < -65504.0f ) return x > -65520.0f ? fp16_min : fp16_infinity_negative;
+                float16_t h;
+                narrow( &x, &h, 1 );
+                return h;
+            }
+            else
+                return x;
+        }
+
+        template< typename Out >
+        inline void store_key( Out* out, std::uint16_t key ) noexcept
+        {
+            if constexpr ( std::is_same_v<Out, float16_t> ) *out = from_order_key( key );
+            else *out = float( from_order_key( key ) );
+        }
+
+#if defined(__AVX2__) && defined(__F16C__)
+        template< scan_op Op >
+        inline __m256 scan_combine8( __m256 a, __m256 b ) noexcept
+        {
+            if constexpr ( Op == scan_op::product ) return _mm256_mul_ps( a, b );
+            else return _mm256_add_ps( a, b );
+        }
+
+        // in-register inclusive scan of 8 floats: two shifts inside each 128-bit lane, then the low lane's total into the high lane
+        template< scan_op Op >
+        inline __m256 scan8( __m256 x ) noexcept
+        {
+            __m256 const identity = _mm256_set1_ps( scan_identity<Op>() );
+            __m256 t = _mm256_castsi256_ps( _mm256_slli_si256( _mm256_castps_si256( x ), 4 ) );
+            x = scan_combine8<Op>( x, _mm256_blend_ps( t, identity, 0x11 ) );
+            t = _mm256_castsi256_ps( _mm256_slli_si256( _mm256_castps_si256( x ), 8 ) );
+            x = scan_combine8<Op>( x, _mm256_blend_ps( t, identity, 0x33 ) );
+            t = _mm256_shuffle_ps( _mm256_permute2f128_ps( x, x, 0x00 ), _mm256_permute2f128_ps( x, x, 0x00 ), 0xff );
+            return scan_combine8<Op>( x, _mm256_blend_ps( t, identity, 0x0f ) );
+        }
+
+        template< typename Out >
+        inline void store8( Out* out, __m256 v ) noexcept
+        {
+            if constexpr ( std::is_same_v<Out, float16_t> )
+                _mm_storeu_si128( reinterpret_cast<__m128i*>( out ), _mm256_cvtps_ph( v, _MM_FROUND_TO_NEAREST_INT ) );
+            else
+                _mm256_storeu_ps( out, v );
+        }
+
+        inline __m256i keys16( __m256i bits ) noexcept
+        {
+            __m256i const key = _mm256_xor_si256( bits, _mm256_or_si256( _mm256_srai_epi16( bits, 15 ), _mm256_set1_epi16( static_cast<short>( 0x8000 ) ) ) );
+            __m256i const nan = _mm256_cmpgt_epi16( _mm256_and_si256( bits, _mm256_set1_epi16( 0x7fff ) ), _mm256_set1_epi16( 0x7c00 ) );
+            return _mm256_or_si256( key, nan );
+        }
+
+        // inclusive max-scan of 16 unsigned keys, 0 is the identity so zero-filling shifts are fine
+        inline __m256i scan16_max( __m256i x ) noexcept
+        {
+            x = _mm256_max_epu16( x, _mm256_slli_si256( x, 2 ) );
+            x = _mm256_max_epu16( x, _mm256_slli_si256( x, 4 ) );
+            x = _mm256_max_epu16( x, _mm256_slli_si256( x, 8 ) );
+            __m256i const top = _mm256_unpackhi_epi64( _mm256_shufflehi_epi16( x, 0xff ), _mm256_shufflehi_epi16( x, 0xff ) );
+            return _mm256_max_epu16( x, _mm256_permute2x128_si256( top, top, 0x08 ) );
+        }
+
+        template< typename Out >
+        inline void store16_keys( Out* out, __m256i key ) noexcept
+        {
+            __m256i const bits = _mm256_xor_si256( key, _mm256_or_si256( _mm256_andnot_si256( _mm256_srai_epi16( key, 15 ), _mm256_set1_epi16( -1 ) ),
+                                                                          _mm256_set1_epi16( static_cast<short>( 0x8000 ) ) ) );
+            if constexpr ( std::is_same_v<Out, float16_t> )
+                _mm256_storeu_si256( reinterpret_cast<__m256i*>( out ), bits );
+            else
+            {
+                _mm256_storeu_ps( out, _mm256_cvtph_ps( _mm256_castsi256_si128( bits ) ) );
+                _mm256_storeu_ps( out + 8, _mm256_cvtph_ps( _mm256_extracti128_si256( bits, 1 ) ) );
+            }
+        }
+#endif
+
+        template< scan_op Op >
+        float reduce_block( float16_t const* in, std::size_t n ) noexcept
+        {
+            float acc = scan_identity<Op>();
+            std::size_t i = 0;
+#if defined(__AVX2__) && defined(__F16C__)
+            __m256 vacc = _mm256_set1_ps( scan_identity<Op>() );
+            for ( ; i + 8 <= n; i += 8 )
+                vacc = scan_combine8<Op>( vacc, _mm256_cvtph_ps( _mm_loadu_si128( reinterpret_cast<__m128i const*>( in + i ) ) ) );
+            alignas( 32 ) float lanes[8];
+            _mm256_store_ps( lanes, vacc );
+            for ( float l : lanes ) acc = scan_combine<Op>( acc, l );
+#endif
+            for ( ; i < n; ++i )
+                acc = scan_combine<Op>( acc, float( in[i] ) );
+            return acc;
+        }
+
+        inline std::uint16_t reduce_block_max( float16_t const* in, std::size_t n ) noexcept
+        {
+            std::uint16_t acc = 0;
+            std::size_t i = 0;
+#if defined(__AVX2__) && defined(__F16C__)
+            __m256i vacc = _mm256_setzero_si256();
+            for ( ; i + 16 <= n; i += 16 )
+                vacc = _mm256_max_epu16( vacc, keys16( _mm256_loadu_si256( reinterpret_cast<__m256i const*>( in + i ) ) ) );
+            alignas( 32 ) std::uint16_t lanes[16];
+            _mm256_store_si256( reinterpret_cast<__m256i*>( lanes ), vacc );
+            for ( auto l : lanes ) acc = std::max( acc, l );
+#endif
+            for ( ; i < n; ++i )
+                acc = std::max( acc, max_key( in[i] ) );
+            return acc;
+        }
+
+        // scans one block starting from `carry`, returns the carry after the block
+        template< scan_op Op, bool Exclusive, typename Out >
+        float scan_block( float16_t const* in, Out* out, std::size_t n, float carry ) noexcept
+        {
+            std::size_t i = 0;
+#if defined(__AVX2__) && defined(__F16C__)
+            __m256 c = _mm256_set1_ps( carry );
+            for ( ; i + 8 <= n; i += 8 )
+            {
+                __m256 const x = _mm256_cvtph_ps( _mm_loadu_si128( reinterpret_cast<__m128i const*>( in + i ) ) );
+                __m256 const s = scan_combine8<Op>( c, scan8<Op>( x ) );
+                if constexpr ( Exclusive )
+                    store8( out + i, _mm256_blend_ps( _mm256_permutevar8x32_ps( s, _mm256_setr_epi32( 0, 0, 1, 2, 3, 4, 5, 6 ) ), c, 0x01 ) );
+                else
+                    store8( out + i, s );
+                c = _mm256_permutevar8x32_ps( s, _mm256_set1_epi32( 7 ) );
+            }
+            carry = _mm256_cvtss_f32( c );
+#endif
+            for ( ; i < n; ++i )
+            {
+                float const next = scan_combine<Op>( carry, float( in[i] ) );
+                out[i] = scan_output<Out>( Exclusive ? carry : next );
+                carry = next;
+            }
+            return carry;
+        }
+
+        template< bool Exclusive, typename Out >
+        std::uint16_t scan_block_max( float16_t const* in, Out* out, std::size_t n, std::uint16_t carry ) noexcept
+        {
+            std::size_t i = 0;
+#if defined(__AVX2__) && defined(__F16C__)
+            __m256i c = _mm256_set1_epi16( static_cast<short>( carry ) );
+            for ( ; i + 16 <= n; i += 16 )
+            {
+                __m256i const s = _mm256_max_epu16( c, scan16_max( keys16( _mm256_loadu_si256( reinterpret_cast<__m256i const*>( in + i ) ) ) ) );
+                if constexpr ( Exclusive )
+                {
+                    // shift up one element across the 128-bit lanes, the carry enters at element 0
+                    __m256i const shifted = _mm256_alignr_epi8( s, _mm256_permute2x128_si256( s, s, 0x08 ), 14 );
+                    store16_keys( out + i, _mm256_insert_epi16( shifted, static_cast<short>( _mm256_extract_epi16( c, 0 ) ), 0 ) );
+                }
+                else
+                    store16_keys( out + i, s );
+                c = _mm256_set1_epi16( static_cast<short>( _mm256_extract_epi16( s, 15 ) ) );
+            }
+            carry = static_cast<std::uint16_t>( _mm256_extract_epi16( c, 0 ) );
+#endif
+            for ( ; i < n; ++i )
+            {
+                std::uint16_t const next = std::max( carry, max_key( in[i] ) );
+                store_key( out + i, Exclusive ? carry : next );
+                carry = next;
+            }
+            return carry;
+        }
+
+        template< bool Exclusive, typename Out >
+        void prefix_scan( std::span<float16_t const> in, std::span<Out> out, scan_op op, std::size_t threads )
+        {
+            static_assert( std::is_same_v<Out, float> || std::is_same_v<Out, float16_t>, "output must be float or float16_t" );
+            if ( out.size() < in.size() )
+                throw std::invalid_argument( "prefix scan: output too small" );
+
+            std::size_t const n = in.size();
+            std::size_t const max_threads = threads ? threads : hardware_threads();
+            std::size_t const workers = std::max<std::size_t>( 1, std::min( max_threads, ( n + scan_grain - 1 ) / scan_grain ) );
+            std::size_t const step = ( n + workers - 1 ) / std::max<std::size_t>( workers, 1 );
+
+            auto const run = [&]< scan_op Op >()
+            {
+                if ( workers == 1 )
+                {
+                    scan_block<Op, Exclusive>( in.data(), out.data(), n, scan_identity<Op>() );
+                    return;
+                }
+                std::vector<float> carry( workers, scan_identity<Op>() );
+                parallel_for( 0, workers, 1, [&]( std::size_t first, std::size_t last )
+                {
+                    for ( std::size_t w = first; w != last; ++w )
+                        if ( w * step < n )
+                            carry[w] = reduce_block<Op>( in.data() + w * step, std::min( step, n - w * step ) );
+                }, workers );
+                float acc = scan_identity<Op>();
+                for ( auto& c : carry )
+                    c = std::exchange( acc, scan_combine<Op>( acc, c ) );
+                parallel_for( 0, workers, 1, [&]( std::size_t first, std::size_t last )
+                {
+                    for ( std::size_t w = first; w != last; ++w )
+                        if ( w * step < n )
+                            scan_block<Op, Exclusive>( in.data() + w * step, out.data() + w * step, std::min( step, n - w * step ), carry[w] );
+                }, workers );
+            };
+
+            switch ( op )
+            {
+                case scan_op::sum: run.template operator()<scan_op::sum>(); return;
+                case scan_op::product: run.template operator()<scan_op::product>(); return;
+                case scan_op::max: break;
+            }
+
+            // exclusive max starts from -inf, which NaN-free inputs never go below
+            std::uint16_t const identity = Exclusive ? order_key( fp16_infinity_negative ) : 0;
+            if ( workers == 1 )
+            {
+                scan_block_max<Exclusive>( in.data(), out.data(), n, identity );
+                return;
+            }
+            std::vector<std::uint16_t> carry( workers, identity );
+            parallel_for( 0, workers, 1, [&]( std::size_t first, std::size_t last )
+            {
+                for ( std::size_t w = first; w != last; ++w )
+                    if ( w * step < n )
+                        carry[w] = reduce_block_max( in.data() + w * step, std::min( step, n - w * step ) );
+            }, workers );
+            std::uint16_t acc = identity;
+            for ( auto& c : carry )
+                c = std::exchange( acc, std::max( acc, c ) );
+            parallel_for( 0, workers, 1, [&]( std::size_t first, std::size_t last )
+            {
+                for ( std::size_t w = first; w != last; ++w )
+                    if ( w * step < n )
+                        scan_block_max<Exclusive>( in.data() + w * step, out.data() + w * step, std::min( step, n - w * step ), carry[w] );
+            }, workers );
+        }
+
+    }//namespace float16_t_private
+
+    // out[i] = in[0] op ... op in[i]; `out` may be float or float16_t
+    template< typename Out >
+    void inclusive_scan( std::span<float16_t const> in, std::span<Out> out, scan_op op = scan_op::sum, std::size_t threads = 0 )
+    {
+        float16_t_private::prefix_scan<false>( in, out, op, threads );
+    }
+
+    // out[i] = identity op in[0] op ... op in[i-1], the identity being 0, 1 or -inf
+    template< typename Out >
+    void exclusive_scan( std::span<float16_t const> in, std::span<Out> out, scan_op op = scan_op::sum, std::size_t threads = 0 )
+    {
+        float16_t_private::prefix_scan<true>( in, out, op, threads );
+    }
+
+    template< typename Out >
+    void cumsum( std::span<float16_t const> in, std::span<Out> out, std::size_t threads = 0 )
+    {
+        numeric::inclusive_scan( in, out, scan_op::sum, threads );
+    }
+
+    template< typename Out >
+    void cumprod( std::span<float16_t const> in, std::span<Out> out, std::size_t threads = 0 )
+    {
+        numeric::inclusive_scan( in, out, scan_op::product, threads );
+    }
+
+    template< typename Out >
+    void cummax( std::span<float16_t const> in, std::span<Out> out, std::size_t threads = 0 )
+    {
+        numeric::inclusive_scan( in, out, scan_op::max, threads );
+    }
+
+}//namespace numeric
+
+#endif
@@ -0,0 +1,237 @@
+#ifndef FLOAT16_T_DICTIONARY_HPP_INCLUDED_SDFLKJ3049SDFLKJ3094USDFLKJ3049USDFLKJSD
+#define FLOAT16_T_DICTIONARY_HPP_INCLUDED_SDFLKJ3049SDFLKJ3094USDFLKJ3049USDFLKJSD
+//
+// dictionary + bit-packing codec for low-cardinality float16_t columns.
+// distinct values are found with an 8 KB presence bitmap (one bit per half pattern), the dictionary
+// lists them in bit-pattern order, and indices are packed LSB first at the minimal width.
+// encode_column() keeps the raw halves whenever they are not larger than the dictionary form.
+//
+#include "float16_t.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace numeric
+{
+    enum class half_encoding : std::uint8_t
+    {
+        raw,
+        dictionary
+    };
+
+    struct encoded_halves
+    {
+        half_encoding encoding = half_encoding::raw;
+        std::size_t size = 0;
+        unsigned bit_width = 0;                // index width, 0 when the dictionary has a single entry
+        std::vector<float16_t> values;         // the raw halves, or the dictionary
+        std::vector<std::uint8_t> packed;      // bit-packed indices, followed by 8 bytes of padding
+
+        // payload size, excluding the padding
+        std::size_t bytes() const noexcept
+        {
+            return values.size() * sizeof( float16_t ) + ( size * bit_width + 7 ) / 8;
+        }
+    };
+
+    namespace float16_t_private
+    {
+        struct presence_bitmap
+        {
+            std::array<std::uint64_t, 1024> bits{};   // 8 KB
+            std::array<std::uint16_t, 1024> rank{};   // distinct values before each word
+
+            std::size_t build( std::span<float16_t const> values ) noexcept
+            {
+                for ( auto v : values )
+                {
+                    std::uint16_t const b = std::uint16_t( v );
+                    bits[b >> 6] |= std::uint64_t( 1 ) << ( b & 63 );
+                }
+                std::size_t count = 0;
+                for ( std::size_t w = 0; w != bits.size(); ++w )
+                {
+                    rank[w] = static_cast<std::uint16_t>( count );
+                    count += static_cast<std::size_t>( std::popcount( bits[w] ) );
+                }
+                return count;
+            }
+
+            std::uint32_t index( std::uint16_t b ) const noexcept
+            {
+                return rank[b >> 6] + static_cast<std::uint32_t>( std::popcount( bits[b >> 6] & ( ( std::uint64_t( 1 ) << ( b & 63 ) ) - 1 ) ) );
+            }
+        };
+
+        inline std::uint32_t unpack_index( std::uint8_t const* packed, std::size_t i, unsigned width ) noexcept
+        {
+            std::size_t const bit = i * width;
+            std::uint32_t word;
+            std::memcpy( &word, packed + bit / 8, sizeof( word ) );
+            return ( word >> ( bit % 8 ) ) & ( ( std::uint32_t( 1 ) << width ) - 1 );
+        }
+
+#if defined(__AVX2__)
+        // eight consecutive indices: gather 32 bits at each byte offset, then shift and mask
+        inline __m256i unpack_indices8( std::uint8_t const* packed, std::size_t i, unsigned width ) noexcept
+        {
+            std::size_t const first_bit = i * width;
+            std::uint8_t const* base = packed + first_bit / 8;
+            __m256i const bit = _mm256_add_epi32( _mm256_set1_epi32( static_cast<int>( first_bit % 8 ) ),
+                                                  _mm256_mullo_epi32( _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 ), _mm256_set1_epi32( static_cast<int>( width ) ) ) );
+            __m256i const word = _mm256_i32gather_epi32( reinterpret_cast<int const*>( base ), _mm256_srli_epi32( bit, 3 ), 1 );
+            __m256i const mask = _mm256_set1_epi32( static_cast<int>( ( 1u << width ) - 1 ) );
+            return _mm256_and_si256( _mm256_srlv_epi32( word, _mm256_and_si256( bit, _mm256_set1_epi32( 7 ) ) ), mask );
+        }
+#endif
+
+        inline void check_decode( encoded_halves const& enc, std::size_t out )
+        {
+            if ( out < enc.size )
+                throw std::invalid_argument( "decode_column: output too small" );
+            if ( enc.encoding == half_encoding::raw ? enc.values.size() != enc.size
+                                                    : ( enc.bit_width > 16 || enc.packed.size() < ( enc.size * enc.bit_width + 7 ) / 8 + 8 ||
+                                                        ( enc.size && enc.values.empty() ) ) )
+                throw std::invalid_argument( "decode_column: malformed encoding" );
+        }
+
+        // every index representable at the packed width resolves, entries past the dictionary read as zero
+        template< typename T >
+        std::vector<T> padded_dictionary( encoded_halves const& enc )
+        {
+            std::vector<T> dictionary( std::max( enc.values.size(), std::size_t( 1 ) << enc.bit_width ), T{} );
+            for ( std::size_t d = 0; d != enc.values.size(); ++d )
+            {
+                if constexpr ( std::is_same_v<T, float> )
+                    dictionary[d] = float( enc.values[d] );
+                else
+                    dictionary[d] = static_cast<T>( std::uint16_t( enc.values[d] ) );
+            }
+            return dictionary;
+        }
+
+    }//namespace float16_t_private
+
+    // dictionary-encodes `values` regardless of the resulting size
+    inline encoded_halves encode_dictionary( std::span<float16_t const> values )
+    {
+        auto presence = std::make_unique<float16_t_private::presence_bitmap>();
+        std::size_t const distinct = presence->build( values );
+
+        encoded_halves enc;
+        enc.encoding = half_encoding::dictionary;
+        enc.size = values.size();
+        enc.bit_width = distinct > 1 ? static_cast<unsigned>( std::bit_width( distinct - 1 ) ) : 0;
+        enc.values.reserve( distinct );
+        for ( std::size_t w = 0; w != presence->bits.size(); ++w )
+            for ( std::uint64_t bits = presence->bits[w]; bits; bits &= bits - 1 )
+                enc.values.push_back( float16_t{ static_cast<std::uint16_t>( w * 64 + static_cast<std::size_t>( std::countr_zero( bits ) ) ) } );
+
+        enc.packed.assign( ( values.size() * enc.bit_width + 7 ) / 8 + 8, 0 );
+        if ( enc.bit_width == 0 )
+            return enc;
+
+        // accumulate whole bytes in a 64-bit register
+        std::uint64_t acc = 0;
+        unsigned filled = 0;
+        std::uint8_t* out = enc.packed.data();
+        for ( auto v : values )
+        {
+            acc |= std::uint64_t( presence->index( std::uint16_t( v ) ) ) << filled;
+            filled += enc.bit_width;
+            while ( filled >= 8 )
+            {
+                *out++ = static_cast<std::uint8_t>( acc );
+                acc >>= 8;
+                filled -= 8;
+            }
+        }
+        if ( filled )
+            *out = static_cast<std::uint8_t>( acc );
+        return enc;
+    }
+
+    // picks the smaller of the dictionary and raw forms
+    inline encoded_halves encode_column( std::span<float16_t const> values )
+    {
+        encoded_halves enc = encode_dictionary( values );
+        if ( enc.bytes() < values.size() * sizeof( float16_t ) )
+            return enc;
+        encoded_halves raw;
+        raw.size = values.size();
+        raw.values.assign( values.begin(), values.end() );
+        return raw;
+    }
+
+    inline void decode_column( encoded_halves const& enc, std::span<float16_t> out )
+    {
+        float16_t_private::check_decode( enc, out.size() );
+        if ( enc.encoding == half_encoding::raw )
+        {
+            std::copy( enc.values.begin(), enc.values.end(), out.begin() );
+            return;
+        }
+        if ( enc.bit_width == 0 )
+        {
+            std::fill_n( out.begin(), enc.size, enc.size ? enc.values[0] : float16_t{} );
+            return;
+        }
+
+        // held in 32-bit lanes so it can be gathered, results are packed back to halves
+        std::vector<std::int32_t> const lanes = float16_t_private::padded_dictionary<std::int32_t>( enc );
+        std::size_t i = 0;
+#if defined(__AVX2__)
+        for ( ; i + 16 <= enc.size; i += 16 )
+        {
+            __m256i const a = _mm256_i32gather_epi32( lanes.data(), float16_t_private::unpack_indices8( enc.packed.data(), i, enc.bit_width ), 4 );
+            __m256i const b = _mm256_i32gather_epi32( lanes.data(), float16_t_private::unpack_indices8( enc.packed.data(), i + 8, enc.bit_width ), 4 );
+            __m256i const h = _mm256_permute4x64_epi64( _mm256_packus_epi32( a, b ), 0xd8 );
+            _mm256_storeu_si256( reinterpret_cast<__m256i*>( out.data() + i ), h );
+        }
+#endif
+        for ( ; i < enc.size; ++i )
+            out[i] = float16_t{ static_cast<std::uint16_t>( lanes[float16_t_private::unpack_index( enc.packed.data(), i, enc.bit_width )] ) };
+    }
+
+    inline void decode_column( encoded_halves const& enc, std::span<float> out )
+    {
+        float16_t_private::check_decode( enc, out.size() );
+        if ( enc.encoding == half_encoding::raw )
+        {
+            widen( enc.values.data(), out.data(), enc.size );
+            return;
+        }
+
+        if ( enc.bit_width == 0 )
+        {
+            std::fill_n( out.begin(), enc.size, enc.size ? float( enc.values[0] ) : 0.0f );
+            return;
+        }
+
+        std::vector<float> const dictionary = float16_t_private::padded_dictionary<float>( enc );
+
+        std::size_t i = 0;
+#if defined(__AVX2__)
+        for ( ; i + 8 <= enc.size; i += 8 )
+            _mm256_storeu_ps( out.data() + i, _mm256_i32gather_ps( dictionary.data(), float16_t_private::unpack_indices8( enc.packed.data(), i, enc.bit_width ), 4 ) );
+#endif
+        for ( ; i < enc.size; ++i )
+            out[i] = dictionary[float16_t_private::unpack_index( enc.packed.data(), i, enc.bit_width )];
+    }
+
+}//namespace numeric
+
+#endif
@@ -0,0 +1,295 @@
+#ifndef FLOAT16_T_DLPACK_HPP_INCLUDED_LKJSDF0934USDFLKJ3049USDFLKJ3094USDFLKJSDF
+#define FLOAT16_T_DLPACK_HPP_INCLUDED_LKJSDF0934USDFLKJ3049USDFLKJ3094USDFLKJSDF
+//
+// zero-copy exchange of float16_t tensors as DLPack DLManagedTensor (kDLFloat, 16 bits, 1 lane)
+// https://dmlc.github.io/dlpack/latest/c_api.html
+//
+#include "float16_t.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// the real dlpack.h when it is around (or already included), otherwise the subset of it used here
+#if !defined(DLPACK_DLPACK_H_) && defined(__has_include)
+#if __has_include(<dlpack/dlpack.h>)
+#include <dlpack/dlpack.h>
+#endif
+#endif
+
+#if !defined(DLPACK_DLPACK_H_) && !defined(FLOAT16_T_DLPACK_SUBSET_DEFINED)
+#define FLOAT16_T_DLPACK_SUBSET_DEFINED
+extern "C"
+{
+
+typedef enum
+{
+    kDLCPU = 1,
+    kDLCUDA = 2,
+    kDLCUDAHost = 3,
+    kDLOpenCL = 4,
+    kDLVulkan = 7,
+    kDLMetal = 8,
+    kDLVPI = 9,
+    kDLROCM = 10,
+    kDLROCMHost = 11,
+    kDLExtDev = 12,
+    kDLCUDAManaged = 13,
+    kDLOneAPI = 14,
+    kDLWebGPU = 15,
+    kDLHexagon = 16,
+} DLDeviceType;
+
+typedef struct
+{
+    DLDeviceType device_type;
+    int32_t device_id;
+} DLDevice;
+
+typedef enum
+{
+    kDLInt = 0U,
+    kDLUInt = 1U,
+    kDLFloat = 2U,
+    kDLOpaqueHandle = 3U,
+    kDLBfloat = 4U,
+    kDLComplex = 5U,
+    kDLBool = 6U,
+} DLDataTypeCode;
+
+typedef struct
+{
+    uint8_t code;
+    uint8_t bits;
+    uint16_t lanes;
+} DLDataType;
+
+typedef struct
+{
+    void* data;
+    DLDevice device;
+    int32_t ndim;
+    DLDataType dtype;
+    int64_t* shape;
+    int64_t* strides;
+    uint64_t byte_offset;
+} DLTensor;
+
+typedef struct DLManagedTensor
+{
+    DLTensor dl_tensor;
+    void* manager_ctx;
+    void ( *deleter )( struct DLManagedTensor* self );
+} DLManagedTensor;
+}
+#endif
+
+namespace numeric
+{
+    namespace float16_t_private
+    {
+        struct dlpack_context
+        {
+            DLManagedTensor managed;
+            std::vector<std::int64_t> shape;
+            std::vector<std::int64_t> strides;
+            std::shared_ptr<void> owner;
+        };
+
+        inline void dlpack_delete( DLManagedTensor* self )
+        {
+            delete static_cast<dlpack_context*>( self->manager_ctx );
+        }
+
+        inline std::vector<std::int64_t> compact_strides( std::span<std::int64_t const> shape )
+        {
+            std::vector<std::int64_t> strides( shape.size() );
+            std::int64_t s = 1;
+            for ( std::size_t d = shape.size(); d-- != 0; )
+            {
+                strides[d] = s;
+                s *= shape[d];
+            }
+            return strides;
+        }
+
+    }//namespace float16_t_private
+
+    //
+    // wraps `data` as a CPU DLManagedTensor without copying. `strides` are in elements, empty for
+    // compact row-major. `owner` is kept alive until the consumer calls the deleter.
+    //
+    inline DLManagedTensor* to_dlpack( float16_t* data, std::vector<std::int64_t> shape,
+                                       std::vector<std::int64_t> strides, std::shared_ptr<void> owner )
+    {
+        if ( !strides.empty() && strides.size() != shape.size() )
+            throw std::invalid_argument( "to_dlpack: strides and shape differ in rank" );
+        for ( auto extent : shape )
+            if ( extent < 0 )
+                throw std::invalid_argument( "to_dlpack: negative extent" );
+
+        auto ctx = std::make_unique<float16_t_private::dlpack_context>();
+        ctx->shape = std::move( shape );
+        ctx->strides = strides.empty() ? float16_t_private::compact_strides( ctx->shape ) : std::move( strides );
+        ctx->owner = std::move( owner );
+
+        DLTensor& t = ctx->managed.dl_tensor;
+        t.data = data;
+        t.device = DLDevice{ kDLCPU, 0 };
+        t.ndim = static_cast<std::int32_t>( ctx->shape.size() );
+        t.dtype = DLDataType{ kDLFloat, 16, 1 };
+        t.shape = ctx->shape.data();
+        t.strides = ctx->strides.data();
+        t.byte_offset = 0;
+        ctx->managed.manager_ctx = ctx.get();
+        ctx->managed.deleter = &float16_t_private::dlpack_delete;
+        return &ctx.release()->managed;
+    }
+
+    //
+    // takes ownership of a CPU half tensor produced elsewhere and views its data in place,
+    // the producer's deleter runs when this object is destroyed
+    //
+    class dlpack_float16_tensor
+    {
+    public:
+        explicit dlpack_float16_tensor( DLManagedTensor* managed ) : managed_{ managed }
+        {
+            if ( !managed )
+                throw std::invalid_argument( "dlpack_float16_tensor: null tensor" );
+            DLTensor const& t = managed->dl_tensor;
+            DLDataType const dt = t.dtype;
+            if ( dt.code != kDLFloat || dt.bits != 16 || dt.lanes != 1 )
+            {
+                release();
+                throw std::invalid_argument( "dlpack_float16_tensor: dtype is not float16" );
+            }
+            if ( t.device.device_type != kDLCPU && t.device.device_type != kDLCUDAHost && t.device.device_type != kDLROCMHost )
+            {
+                release();
+                throw std::invalid_argument( "dlpack_float16_tensor: tensor is not host accessible" );
+            }
+            if ( t.byte_offset % sizeof( float16_t ) != 0 )
+            {
+                release();
+                throw std::invalid_argument( "dlpack_float16_tensor: misaligned byte offset" );
+            }
+            if ( t.ndim < 0 || ( t.ndim > 0 && !t.shape ) )
+            {
+                release();
+                throw std::invalid_argument( "dlpack_float16_tensor: invalid shape" );
+            }
+            std::span<std::int64_t const> const shape{ t.shape, static_cast<std::size_t>( t.ndim ) };
+            if ( std::any_of( shape.begin(), shape.end(), []( std::int64_t extent ) { return extent < 0; } ) )
+            {
+                release();
+                throw std::invalid_argument( "dlpack_float16_tensor: negative extent" );
+            }
+            // a null strides pointer means compact row-major
+            try
+            {
+                strides_ = t.strides ? std::vector<std::int64_t>( t.strides, t.strides + t.ndim ) : float16_t_private::compact_strides( shape );
+            }
+            catch ( ... )
+            {
+                release();
+                throw;
+            }
+        }
+
+        dlpack_float16_tensor( dlpack_float16_tensor const& ) = delete;
+        dlpack_float16_tensor& operator = ( dlpack_float16_tensor const& ) = delete;
+
+        dlpack_float16_tensor( dlpack_float16_tensor&& other ) noexcept
+            : managed_{ std::exchange( other.managed_, nullptr ) }, strides_{ std::move( other.strides_ ) } { }
+
+        dlpack_float16_tensor& operator = ( dlpack_float16_tensor&& other ) noexcept
+        {
+            if ( this != &other )
+            {
+                release();
+                managed_ = std::exchange( other.managed_, nullptr );
+                strides_ = std::move( other.strides_ );
+            }
+            return *this;
+        }
+
+        ~dlpack_float16_tensor()
+        {
+            release();
+        }
+
+        float16_t* data() const noexcept
+        {
+            DLTensor const& t = managed_->dl_tensor;
+            return reinterpret_cast<float16_t*>( static_cast<char*>( t.data ) + t.byte_offset );
+        }
+
+        std::span<std::int64_t const> shape() const noexcept
+        {
+            DLTensor const& t = managed_->dl_tensor;
+            return { t.shape, static_cast<std::size_t>( t.ndim ) };
+        }
+
+        std::span<std::int64_t const> strides() const noexcept { return strides_; }
+
+        std::size_t size() const noexcept
+        {
+            std::size_t n = 1;
+            for ( auto extent : shape() )
+                n *= static_cast<std::size_t>( extent );
+            return n;
+        }
+
+        bool is_contiguous() const noexcept
+        {
+            auto const compact = float16_t_private::compact_strides( shape() );
+            auto const sh = shape();
+            for ( std::size_t d = 0; d != sh.size(); ++d )
+                if ( sh[d] != 1 && strides_[d] != compact[d] )
+                    return false;
+            return true;
+        }
+
+        // the whole tensor as one flat range, only meaningful when is_contiguous()
+        std::span<float16_t> values() const
+        {
+            if ( !is_contiguous() )
+                throw std::logic_error( "dlpack_float16_tensor: tensor is not contiguous" );
+            return { data(), size() };
+        }
+
+        float16_t& operator[]( std::span<std::int64_t const> index ) const noexcept
+        {
+            std::int64_t offset = 0;
+            for ( std::size_t d = 0; d != index.size(); ++d )
+                offset += index[d] * strides_[d];
+            return data()[offset];
+        }
+
+        // hands the tensor back out (e.g. to another consumer), this object no longer owns it
+        DLManagedTensor* release_managed() noexcept
+        {
+            return std::exchange( managed_, nullptr );
+        }
+
+    private:
+        void release() noexcept
+        {
+            if ( managed_ && managed_->deleter )
+                managed_->deleter( managed_ );
+            managed_ = nullptr;
+        }
+
+        DLManagedTensor* managed_ = nullptr;
+        std::vector<std::int64_t> strides_;
+    };
+
+}//namespace numeric
+
+#endif
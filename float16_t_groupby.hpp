@@ -0,0 +1,179 @@
+#ifndef FLOAT16_T_GROUPBY_HPP_INCLUDED_SDLFKJ3049USDFLKJ3049USDFLKJ3409USDFLKJSDF
+#define FLOAT16_T_GROUPBY_HPP_INCLUDED_SDLFKJ3049USDFLKJ3049USDFLKJ3409USDFLKJSDF
+//
+// group-by aggregation keyed on float16_t: there are only 65536 possible keys, so the groups live in a
+// direct-addressed table indexed by the key bits instead of a hash map. large inputs are aggregated into
+// per-thread tables which are then merged in parallel, slot range by slot range.
+//
+#include "float16_t.hpp"
+#include "float16_t_parallel.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace numeric
+{
+    struct group_by_options
+    {
+        bool merge_signed_zeros = false;   // -0 and +0 form one group, keyed +0
+        bool merge_nans = false;           // every NaN payload forms one group, keyed fp16_nan
+        std::size_t threads = 0;           // 0 means all hardware threads
+    };
+
+    struct group_stats
+    {
+        std::uint64_t count = 0;
+        double sum = 0.0;
+        float min = std::numeric_limits<float>::max();
+        float max = std::numeric_limits<float>::lowest();
+
+        double mean() const noexcept { return count ? sum / double( count ) : 0.0; }
+
+        void add( float v ) noexcept
+        {
+            ++count;
+            sum += v;
+            min = v < min ? v : min;
+            max = v > max ? v : max;
+        }
+
+        void merge( group_stats const& other ) noexcept
+        {
+            count += other.count;
+            sum += other.sum;
+            min = other.min < min ? other.min : min;
+            max = other.max > max ? other.max : max;
+        }
+    };
+
+    namespace float16_t_private
+    {
+        constexpr inline std::size_t group_by_slots = 65536;
+        constexpr inline std::size_t group_by_grain = 1 << 16;   // rows per thread before another table pays off
+        constexpr inline std::size_t group_by_chunk = 512;       // half values widened at a time
+
+        inline std::uint16_t group_key( std::uint16_t bits, group_by_options const& options ) noexcept
+        {
+            if ( options.merge_signed_zeros && ( bits & 0x7fff ) == 0 ) return 0;
+            if ( options.merge_nans && is_nan_bits( bits ) ) return std::uint16_t( fp16_nan );
+            return bits;
+        }
+
+        template< typename T >
+        void aggregate_rows( group_stats* table, float16_t const* keys, T const* values, std::size_t n, group_by_options const& options )
+        {
+            if constexpr ( std::is_same_v<T, float16_t> )
+            {
+                float buffer[group_by_chunk];
+                for ( std::size_t first = 0; first < n; first += group_by_chunk )
+                {
+                    std::size_t const m = std::min( n - first, group_by_chunk );
+                    widen( values + first, buffer, m );
+                    for ( std::size_t i = 0; i != m; ++i )
+                        table[group_key( std::uint16_t( keys[first + i] ), options )].add( buffer[i] );
+                }
+            }
+            else
+            {
+                for ( std::size_t i = 0; i != n; ++i )
+                    table[group_key( std::uint16_t( keys[i] ), options )].add( values[i] );
+            }
+        }
+
+    }//namespace float16_t_private
+
+    class float16_group_by
+    {
+    public:
+        explicit float16_group_by( group_by_options options = {} )
+            : options_{ options }, table_( float16_t_private::group_by_slots ) { }
+
+        // aggregates values[i] into the group of keys[i]; values may be float or float16_t
+        template< typename T >
+        void add( std::span<float16_t const> keys, std::span<T const> values )
+        {
+            static_assert( std::is_same_v<T, float> || std::is_same_v<T, float16_t>, "values must be float or float16_t" );
+            if ( keys.size() != values.size() )
+                throw std::invalid_argument( "float16_group_by::add: keys and values differ in length" );
+
+            std::size_t const n = keys.size();
+            std::size_t const max_threads = options_.threads ? options_.threads : float16_t_private::hardware_threads();
+            std::size_t const workers = std::min( max_threads, ( n + float16_t_private::group_by_grain - 1 ) / float16_t_private::group_by_grain );
+            if ( workers <= 1 )
+            {
+                float16_t_private::aggregate_rows( table_.data(), keys.data(), values.data(), n, options_ );
+                return;
+            }
+
+            // one private table per worker, so the hot loop has no sharing at all
+            std::size_t const step = ( n + workers - 1 ) / workers;
+            std::vector<std::vector<group_stats>> partial( workers );
+            float16_t_private::parallel_for( 0, workers, 1, [&]( std::size_t first, std::size_t last )
+            {
+                for ( std::size_t w = first; w != last; ++w )
+                {
+                    partial[w].resize( float16_t_private::group_by_slots );
+                    std::size_t const b = w * step;
+                    std::size_t const e = std::min( n, b + step );
+                    if ( b < e )
+                        float16_t_private::aggregate_rows( partial[w].data(), keys.data() + b, values.data() + b, e - b, options_ );
+                }
+            }, workers );
+
+            float16_t_private::parallel_for( 0, float16_t_private::group_by_slots, 4096, [&]( std::size_t first, std::size_t last )
+            {
+                for ( auto const& p : partial )
+                    for ( std::size_t s = first; s != last; ++s )
+                        if ( p[s].count ) table_[s].merge( p[s] );
+            }, workers );
+        }
+
+        void add( std::span<float16_t const> keys, std::span<float const> values ) { add<float>( keys, values ); }
+        void add( std::span<float16_t const> keys, std::span<float16_t const> values ) { add<float16_t>( keys, values ); }
+
+        // merges another aggregation, e.g. one built over a different partition
+        void merge( float16_group_by const& other ) noexcept
+        {
+            for ( std::size_t s = 0; s != float16_t_private::group_by_slots; ++s )
+                if ( other.table_[s].count ) table_[s].merge( other.table_[s] );
+        }
+
+        // the group `key` falls into, after the canonicalization selected in the options
+        group_stats const& operator[]( float16_t key ) const noexcept
+        {
+            return table_[float16_t_private::group_key( std::uint16_t( key ), options_ )];
+        }
+
+        std::size_t groups() const noexcept
+        {
+            return static_cast<std::size_t>( std::count_if( table_.begin(), table_.end(), []( group_stats const& g ) { return g.count != 0; } ) );
+        }
+
+        // visits the non-empty groups as func( key, stats ) in ascending key order (-NaN, -inf, ..., -0, +0, ..., +inf, +NaN)
+        template< typename Func >
+        void for_each( Func const& func ) const
+        {
+            for ( std::size_t k = 0; k != float16_t_private::group_by_slots; ++k )
+            {
+                float16_t const key = from_order_key( static_cast<std::uint16_t>( k ) );
+                group_stats const& g = table_[std::uint16_t( key )];
+                if ( g.count ) func( key, g );
+            }
+        }
+
+        void clear() noexcept { std::fill( table_.begin(), table_.end(), group_stats{} ); }
+
+    private:
+        group_by_options options_;
+        std::vector<group_stats> table_;
+    };
+
+}//namespace numeric
+
+#endif
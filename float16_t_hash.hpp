@@ -0,0 +1,296 @@
+#ifndef FLOAT16_T_HASH_HPP_INCLUDED_SDLFKJ3049USDFLKJ0394USDLFKJ3049USDLFKJ3049U
+#define FLOAT16_T_HASH_HPP_INCLUDED_SDLFKJ3049USDFLKJ0394USDLFKJ3049USDLFKJ3049U
+//
+// fast non-cryptographic 128/64-bit content hashes of float16_t buffers, for deduplication and integrity checks.
+// the input is cut into leaves of hash_leaf_size halves, each leaf is hashed with an XXH3-style multiply-
+// accumulate over 64-byte stripes (AVX-512 / AVX2 / scalar give identical results), and the leaf digests
+// are combined in a binary tree whose shape depends on the length only, so the result does not depend on
+// the number of threads. optionally -0 hashes as +0 and every NaN as the canonical quiet NaN.
+//
+#include "float16_t.hpp"
+#include "float16_t_parallel.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__AVX512BW__)
+#include <immintrin.h>
+#endif
+
+namespace numeric
+{
+    struct digest128
+    {
+        std::uint64_t lo = 0;
+        std::uint64_t hi = 0;
+
+        friend bool operator == ( digest128 const&, digest128 const& ) = default;
+    };
+
+    struct hash_options
+    {
+        bool canonical_zero = false;   // -0 hashes as +0
+        bool canonical_nan = false;    // every NaN hashes as fp16_nan
+        std::uint64_t seed = 0;
+        std::size_t threads = 0;       // 0 means all hardware threads
+    };
+
+    // halves per leaf of the hash tree
+    constexpr inline std::size_t hash_leaf_size = std::size_t( 1 ) << 15;
+
+    namespace float16_t_private
+    {
+        constexpr inline std::size_t hash_stripe = 32;          // halves per stripe, 8 lanes of 64 bits
+        constexpr inline std::size_t hash_scramble_every = 16;  // stripes between accumulator scrambles
+
+        constexpr inline std::uint64_t hash_prime32_1 = 0x9e3779b1ull;
+        constexpr inline std::uint64_t hash_prime32_2 = 0x85ebca77ull;
+        constexpr inline std::uint64_t hash_prime32_3 = 0xc2b2ae3dull;
+        constexpr inline std::uint64_t hash_prime64_1 = 0x9e3779b185ebca87ull;
+        constexpr inline std::uint64_t hash_prime64_2 = 0xc2b2ae3d27d4eb4full;
+        constexpr inline std::uint64_t hash_prime64_3 = 0x165667b19e3779f9ull;
+        constexpr inline std::uint64_t hash_prime64_4 = 0x85ebca77c2b2ae63ull;
+        constexpr inline std::uint64_t hash_prime64_5 = 0x27d4eb2f165667c5ull;
+
+        constexpr inline std::uint64_t hash_secret[24] =
+        {
+            0xbe4ba423396cfeb8ull, 0x1cad21f72c81017cull, 0xdb979083e96dd4deull, 0x1f67b3b7a4a44072ull,
+            0x78e5c0cc4ee679cbull, 0x2172ffcc7dd05a82ull, 0x8e2443f7744608b8ull, 0x4c263a81e69035e0ull,
+            0xcb00c391bb52283cull, 0xa32e531b8b65d088ull, 0x4ef90da297486471ull, 0xd8acdea946ef1938ull,
+            0x3f349ce33f76faa8ull, 0x1d4f0bc7c7bbdcf9ull, 0x3159b4cd4be0518aull, 0x647378d9c97e9fc8ull,
+            0xc3ebd33483acc5eaull, 0xeb6313faffa081c5ull, 0x49daf0b751dd0d17ull, 0x9e68d429265516d3ull,
+            0xfca1477d58be162bull, 0xce31d07ad1b8f88full, 0x280416958f3acb45ull, 0x7e404bbbcafbd7afull,
+        };
+
+        struct hash_keys
+        {
+            std::uint64_t accumulate[8];
+            std::uint64_t scramble[8];
+            std::uint64_t finish[8];
+
+            explicit hash_keys( std::uint64_t seed ) noexcept
+            {
+                for ( std::size_t i = 0; i != 8; ++i )
+                {
+                    accumulate[i] = hash_secret[i] + ( i % 2 ? 0 - seed : seed );
+                    scramble[i] = hash_secret[8 + i] ^ ( seed * hash_prime64_2 );
+                    finish[i] = hash_secret[16 + i] + seed;
+                }
+            }
+        };
+
+        inline std::uint64_t hash_fold( std::uint64_t a, std::uint64_t b ) noexcept
+        {
+            unsigned __int128 const p = static_cast<unsigned __int128>( a ) * b;
+            return static_cast<std::uint64_t>( p ) ^ static_cast<std::uint64_t>( p >> 64 );
+        }
+
+        inline std::uint64_t hash_avalanche( std::uint64_t h ) noexcept
+        {
+            h ^= h >> 37;
+            h *= 0x165667919e3779f9ull;
+            return h ^ ( h >> 32 );
+        }
+
+        template< bool Zero, bool Nan >
+        inline std::uint16_t hash_canonical( std::uint16_t bits ) noexcept
+        {
+            if constexpr ( Zero ) if ( ( bits & 0x7fff ) == 0 ) return 0;
+            if constexpr ( Nan ) if ( is_nan_bits( bits ) ) return std::uint16_t( fp16_nan );
+            return bits;
+        }
+
+        //
+        // accumulates `stripes` stripes of `p` into acc, scrambling after every hash_scramble_every-th stripe
+        // counted from `first` (the index of the first stripe within its leaf)
+        //
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized" // gcc 12 trips over _mm512_undefined_epi32 in the AVX-512 intrinsics
+#endif
+        template< bool Zero, bool Nan >
+        void hash_stripes( std::uint64_t* acc, float16_t const* p, std::size_t stripes, std::size_t first, hash_keys const& keys ) noexcept
+        {
+#if defined(__AVX512BW__)
+            __m512i a = _mm512_loadu_si512( acc );
+            __m512i const key = _mm512_loadu_si512( keys.accumulate );
+            __m512i const scramble = _mm512_loadu_si512( keys.scramble );
+            __m512i const prime = _mm512_set1_epi64( static_cast<long long>( hash_prime32_1 ) );
+            for ( std::size_t s = 0; s != stripes; ++s )
+            {
+                __m512i d = _mm512_loadu_si512( p + s * hash_stripe );
+                if constexpr ( Zero || Nan )
+                {
+                    __m512i const magnitude = _mm512_and_si512( d, _mm512_set1_epi16( 0x7fff ) );
+                    if constexpr ( Zero )
+                        d = _mm512_mask_mov_epi16( d, _mm512_cmpeq_epi16_mask( magnitude, _mm512_setzero_si512() ), _mm512_setzero_si512() );
+                    if constexpr ( Nan )
+                        d = _mm512_mask_mov_epi16( d, _mm512_cmpgt_epu16_mask( magnitude, _mm512_set1_epi16( 0x7c00 ) ), _mm512_set1_epi16( 0x7e00 ) );
+                }
+                __m512i const dk = _mm512_xor_si512( d, key );
+                a = _mm512_add_epi64( a, _mm512_shuffle_epi32( d, _MM_PERM_BADC ) );
+                a = _mm512_add_epi64( a, _mm512_mul_epu32( dk, _mm512_srli_epi64( dk, 32 ) ) );
+                if ( ( first + s + 1 ) % hash_scramble_every == 0 )
+                {
+                    a = _mm512_xor_si512( _mm512_xor_si512( a, _mm512_srli_epi64( a, 47 ) ), scramble );
+                    a = _mm512_add_epi64( _mm512_mul_epu32( a, prime ), _mm512_slli_epi64( _mm512_mul_epu32( _mm512_srli_epi64( a, 32 ), prime ), 32 ) );
+                }
+            }
+            _mm512_storeu_si512( acc, a );
+#elif defined(__AVX2__)
+            __m256i a[2], key[2], scramble[2];
+            for ( int h = 0; h != 2; ++h )
+            {
+                a[h] = _mm256_loadu_si256( reinterpret_cast<__m256i const*>( acc + 4 * h ) );
+                key[h] = _mm256_loadu_si256( reinterpret_cast<__m256i const*>( keys.accumulate + 4 * h ) );
+                scramble[h] = _mm256_loadu_si256( reinterpret_cast<__m256i const*>( keys.scramble + 4 * h ) );
+            }
+            __m256i const prime = _mm256_set1_epi64x( static_cast<long long>( hash_prime32_1 ) );
+            for ( std::size_t s = 0; s != stripes; ++s )
+            {
+                bool const scrambled = ( first + s + 1 ) % hash_scramble_every == 0;
+                for ( int h = 0; h != 2; ++h )
+                {
+                    __m256i d = _mm256_loadu_si256( reinterpret_cast<__m256i const*>( p + s * hash_stripe + 16 * h ) );
+                    if constexpr ( Zero || Nan )
+                    {
+                        __m256i const magnitude = _mm256_and_si256( d, _mm256_set1_epi16( 0x7fff ) );
+                        if constexpr ( Zero )
+                            d = _mm256_andnot_si256( _mm256_cmpeq_epi16( magnitude, _mm256_setzero_si256() ), d );
+                        if constexpr ( Nan )
+                            d = _mm256_blendv_epi8( d, _mm256_set1_epi16( 0x7e00 ), _mm256_cmpgt_epi16( magnitude, _mm256_set1_epi16( 0x7c00 ) ) );
+                    }
+                    __m256i const dk = _mm256_xor_si256( d, key[h] );
+                    a[h] = _mm256_add_epi64( a[h], _mm256_shuffle_epi32( d, 0x4e ) );
+                    a[h] = _mm256_add_epi64( a[h], _mm256_mul_epu32( dk, _mm256_srli_epi64( dk, 32 ) ) );
+                    if ( scrambled )
+                    {
+                        a[h] = _mm256_xor_si256( _mm256_xor_si256( a[h], _mm256_srli_epi64( a[h], 47 ) ), scramble[h] );
+                        a[h] = _mm256_add_epi64( _mm256_mul_epu32( a[h], prime ), _mm256_slli_epi64( _mm256_mul_epu32( _mm256_srli_epi64( a[h], 32 ), prime ), 32 ) );
+                    }
+                }
+            }
+            for ( int h = 0; h != 2; ++h )
+                _mm256_storeu_si256( reinterpret_cast<__m256i*>( acc + 4 * h ), a[h] );
+#else
+            for ( std::size_t s = 0; s != stripes; ++s )
+            {
+                std::uint16_t bits[hash_stripe];
+                std::memcpy( bits, p + s * hash_stripe, sizeof( bits ) );
+                for ( auto& b : bits )
+                    b = hash_canonical<Zero, Nan>( b );
+                std::uint64_t lanes[8];
+                std::memcpy( lanes, bits, sizeof( lanes ) );
+                for ( std::size_t i = 0; i != 8; ++i )
+                {
+                    std::uint64_t const dk = lanes[i] ^ keys.accumulate[i];
+                    acc[i ^ 1] += lanes[i];
+                    acc[i] += ( dk & 0xffffffffull ) * ( dk >> 32 );
+                }
+                if ( ( first + s + 1 ) % hash_scramble_every == 0 )
+                    for ( std::size_t i = 0; i != 8; ++i )
+                        acc[i] = ( acc[i] ^ ( acc[i] >> 47 ) ^ keys.scramble[i] ) * hash_prime32_1;
+            }
+#endif
+        }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+        template< bool Zero, bool Nan >
+        digest128 hash_leaf( float16_t const* p, std::size_t n, hash_keys const& keys ) noexcept
+        {
+            std::uint64_t acc[8] = { hash_prime32_3, hash_prime64_1, hash_prime64_2, hash_prime64_3,
+                                     hash_prime64_4, hash_prime32_2, hash_prime64_5, hash_prime32_1 };
+            std::size_t const full = n / hash_stripe;
+            hash_stripes<Zero, Nan>( acc, p, full, 0, keys );
+            if ( std::size_t const rest = n % hash_stripe; rest )
+            {
+                // zero padded, the length below tells [x] from [x, +0]
+                float16_t tail[hash_stripe];
+                std::memset( tail, 0, sizeof( tail ) );
+                std::memcpy( tail, p + full * hash_stripe, rest * sizeof( float16_t ) );
+                hash_stripes<Zero, Nan>( acc, tail, 1, full, keys );
+            }
+
+            std::uint64_t const bytes = n * sizeof( float16_t );
+            std::uint64_t lo = bytes * hash_prime64_1;
+            std::uint64_t hi = ~( bytes * hash_prime64_2 );
+            for ( std::size_t i = 0; i != 4; ++i )
+            {
+                lo += hash_fold( acc[2 * i] ^ keys.finish[2 * i], acc[2 * i + 1] ^ keys.finish[2 * i + 1] );
+                hi += hash_fold( acc[2 * i] ^ keys.finish[( 2 * i + 3 ) % 8], acc[2 * i + 1] ^ keys.finish[( 2 * i + 6 ) % 8] );
+            }
+            return { hash_avalanche( lo ), hash_avalanche( hi ) };
+        }
+
+    }//namespace float16_t_private
+
+    // an inner node of the hash tree; order matters, combine( a, b ) != combine( b, a )
+    inline digest128 hash_combine( digest128 left, digest128 right ) noexcept
+    {
+        using namespace float16_t_private;
+        std::uint64_t const lo = ( hash_fold( left.lo ^ hash_secret[3], right.hi ^ hash_secret[12] ) + std::rotl( left.hi, 17 ) ) ^ right.lo;
+        std::uint64_t const hi = ( hash_fold( left.hi ^ hash_secret[21], right.lo ^ hash_secret[6] ) + std::rotl( right.hi, 29 ) ) ^ left.lo;
+        return { hash_avalanche( lo + hash_prime64_4 ), hash_avalanche( hi ^ hash_prime64_5 ) };
+    }
+
+    namespace float16_t_private
+    {
+        // the digest of leaves [first, last): the left subtree takes the largest power of two below the count
+        inline digest128 hash_tree( std::vector<digest128> const& leaves, std::size_t first, std::size_t last ) noexcept
+        {
+            std::size_t const n = last - first;
+            if ( n == 1 ) return leaves[first];
+            std::size_t const left = std::bit_floor( n - 1 );
+            return hash_combine( hash_tree( leaves, first, first + left ), hash_tree( leaves, first + left, last ) );
+        }
+
+    }//namespace float16_t_private
+
+    //
+    // hashes `values` leaf by leaf on up to `threads` threads. for a length of a * hash_leaf_size with a
+    // power of two a, content_hash128( x ++ y ) == hash_combine( content_hash128( x ), content_hash128( y ) )
+    // for any non-empty y no longer than x, which lets shards be hashed separately
+    //
+    inline digest128 content_hash128( std::span<float16_t const> values, hash_options const& options = {} )
+    {
+        float16_t_private::hash_keys const keys{ options.seed };
+        std::size_t const n = values.size();
+        std::size_t const leaves = n ? ( n + hash_leaf_size - 1 ) / hash_leaf_size : 1;
+
+        auto const leaf = [&]( std::size_t i )
+        {
+            float16_t const* const p = values.data() + i * hash_leaf_size;
+            std::size_t const m = std::min( hash_leaf_size, n - i * hash_leaf_size );
+            if ( options.canonical_zero && options.canonical_nan ) return float16_t_private::hash_leaf<true, true>( p, m, keys );
+            if ( options.canonical_zero ) return float16_t_private::hash_leaf<true, false>( p, m, keys );
+            if ( options.canonical_nan ) return float16_t_private::hash_leaf<false, true>( p, m, keys );
+            return float16_t_private::hash_leaf<false, false>( p, m, keys );
+        };
+        if ( leaves == 1 )
+            return leaf( 0 );
+
+        std::vector<digest128> digests( leaves );
+        float16_t_private::parallel_for( 0, leaves, 8, [&]( std::size_t first, std::size_t last )
+        {
+            for ( std::size_t i = first; i != last; ++i )
+                digests[i] = leaf( i );
+        }, options.threads );
+        return float16_t_private::hash_tree( digests, 0, leaves );
+    }
+
+    // the low half of the 128-bit digest
+    inline std::uint64_t content_hash64( std::span<float16_t const> values, hash_options const& options = {} )
+    {
+        return content_hash128( values, options ).lo;
+    }
+
+}//namespace numeric
+
+#endif
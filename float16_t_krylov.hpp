@@ -0,0 +1,387 @@
+#ifndef FLOAT16_T_KRYLOV_HPP_INCLUDED_SDLKFJ3049USDFLKJ0394USDLFKJ3049USDLFKJ304
+#define FLOAT16_T_KRYLOV_HPP_INCLUDED_SDLKFJ3049USDFLKJ0394USDLFKJ3049USDLFKJ304
+//
+// Krylov solvers over a CSR matrix whose values are stored as float16_t, halving the matrix traffic of float
+// storage in the bandwidth-bound SpMV. values are multiplied by a power-of-two scale on the way in so the
+// largest lands at 2^14 (no overflow past fp16_max, most of the range above the subnormals); the SpMV widens
+// them on the fly and accumulates in the vector precision (float or double). dot products are done in fp64
+// over fixed chunks, so results do not depend on the thread count. the solvers work on the stored matrix.
+//   conjugate_gradient: symmetric positive definite systems, with periodic residual replacement
+//   gmres: restarted GMRES(m) with modified Gram-Schmidt and Givens rotations
+//
+#include "float16_t.hpp"
+#include "float16_t_parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+namespace numeric
+{
+    struct krylov_options
+    {
+        std::size_t max_iterations = 1000;   // matrix-vector products
+        double tolerance = 1.0e-6;           // on ||b - A x|| / ||b||
+        std::size_t restart = 30;            // GMRES basis size
+        std::size_t replace_every = 50;      // CG steps between recomputations of the true residual
+        std::size_t threads = 0;             // 0 means all hardware threads
+    };
+
+    struct krylov_result
+    {
+        std::size_t iterations = 0;
+        double relative_residual = 0.0;      // of the returned x, recomputed from b - A x
+        bool converged = false;
+        bool breakdown = false;              // CG met p'Ap <= 0, the matrix is not positive definite
+    };
+
+    namespace float16_t_private
+    {
+        constexpr inline std::size_t krylov_grain = 16384;        // vector elements per task and per dot product partial
+        constexpr inline std::size_t krylov_row_grain = 4096;     // matrix rows per SpMV task
+        constexpr inline double krylov_target = 16384.0;          // the largest stored magnitude
+
+        // sum of x[i] * y[i] in fp64, partial sums over fixed chunks added in order
+        template< typename T >
+        double krylov_dot( std::span<T const> x, std::span<T const> y, std::size_t threads )
+        {
+            std::size_t const chunks = ( x.size() + krylov_grain - 1 ) / krylov_grain;
+            std::vector<double> partial( chunks, 0.0 );
+            parallel_for( 0, chunks, 1, [&]( std::size_t first, std::size_t last )
+            {
+                for ( std::size_t c = first; c != last; ++c )
+                {
+                    double s = 0.0;
+                    for ( std::size_t i = c * krylov_grain, e = std::min( x.size(), i + krylov_grain ); i != e; ++i )
+                        s += double( x[i] ) * double( y[i] );
+                    partial[c] = s;
+                }
+            }, threads );
+            double s = 0.0;
+            for ( double p : partial ) s += p;
+            return s;
+        }
+
+        // one stored value to float, a single vcvtph2ps where F16C is available; converting in the SpMV loop
+        // itself beats widening runs of values into a buffer first, which costs an extra store and reload
+        inline float krylov_widen( float16_t h ) noexcept
+        {
+#if defined(__F16C__)
+            return _cvtsh_ss( std::uint16_t( h ) );
+#else
+            return float( h );
+#endif
+        }
+
+        // func( i ) for every element, in parallel
+        template< typename Func >
+        void krylov_for( std::size_t n, Func const& func, std::size_t threads )
+        {
+            parallel_for( 0, n, krylov_grain, [&]( std::size_t first, std::size_t last )
+            {
+                for ( std::size_t i = first; i != last; ++i ) func( i );
+            }, threads );
+        }
+
+    }//namespace float16_t_private
+
+    class half_csr_matrix
+    {
+    public:
+        //
+        // builds from CSR arrays (row_offsets has rows + 1 entries, columns and values one per nonzero);
+        // throws std::invalid_argument on inconsistent arrays, out-of-range columns or non-finite values
+        //
+        half_csr_matrix( std::size_t rows, std::size_t cols, std::span<std::uint64_t const> row_offsets,
+                         std::span<std::uint32_t const> columns, std::span<double const> values )
+            : rows_{ rows }, cols_{ cols }, row_offsets_( row_offsets.begin(), row_offsets.end() ), columns_( columns.begin(), columns.end() ), values_( values.size() )
+        {
+            if ( row_offsets.size() != rows + 1 || row_offsets.front() != 0 || row_offsets.back() != values.size() || columns.size() != values.size() )
+                throw std::invalid_argument( "half_csr_matrix: inconsistent CSR arrays" );
+            for ( std::size_t i = 0; i != rows; ++i )
+                if ( row_offsets[i] > row_offsets[i + 1] )
+                    throw std::invalid_argument( "half_csr_matrix: row offsets decrease" );
+            if ( std::any_of( columns.begin(), columns.end(), [&]( std::uint32_t c ) { return c >= cols; } ) )
+                throw std::invalid_argument( "half_csr_matrix: column index out of range" );
+
+            double largest = 0.0;
+            for ( double v : values )
+            {
+                if ( !std::isfinite( v ) )
+                    throw std::invalid_argument( "half_csr_matrix: non-finite value" );
+                largest = std::max( largest, std::abs( v ) );
+            }
+            if ( largest > 0.0 )
+            {
+                int e;
+                std::frexp( largest / float16_t_private::krylov_target, &e );
+                scale_ = std::ldexp( 1.0, e );
+            }
+            for ( std::size_t k = 0; k != values.size(); ++k )
+            {
+                values_[k] = float16_t{ float( values[k] / scale_ ) };
+                flushed_ += values[k] != 0.0 && ( std::uint16_t( values_[k] ) & 0x7fff ) == 0;
+            }
+        }
+
+        std::size_t rows() const noexcept { return rows_; }
+        std::size_t cols() const noexcept { return cols_; }
+        std::size_t nonzeros() const noexcept { return values_.size(); }
+
+        // stored value * scale() is the matrix entry
+        double scale() const noexcept { return scale_; }
+
+        // nonzeros too small relative to the largest entry to survive as halves
+        std::size_t flushed() const noexcept { return flushed_; }
+
+        std::size_t bytes() const noexcept
+        {
+            return values_.size() * ( sizeof( float16_t ) + sizeof( std::uint32_t ) ) + row_offsets_.size() * sizeof( std::uint64_t );
+        }
+
+        // y = A x, rows in parallel; T is float or double and sets the accumulation precision
+        template< typename T >
+        void multiply( std::span<T const> x, std::span<T> y, std::size_t threads = 0 ) const
+        {
+            static_assert( std::is_same_v<T, float> || std::is_same_v<T, double>, "vectors must be float or double" );
+            if ( x.size() != cols_ || y.size() != rows_ )
+                throw std::invalid_argument( "half_csr_matrix::multiply: vector sizes differ from the matrix" );
+
+            T const scale = T( scale_ );
+            float16_t_private::parallel_for( 0, rows_, float16_t_private::krylov_row_grain, [&]( std::size_t first, std::size_t last )
+            {
+                for ( std::size_t i = first; i != last; ++i )
+                {
+                    T sum = 0;
+                    for ( std::size_t k = row_offsets_[i], e = row_offsets_[i + 1]; k != e; ++k )
+                        sum += T( float16_t_private::krylov_widen( values_[k] ) ) * x[columns_[k]];
+                    y[i] = sum * scale;
+                }
+            }, threads );
+        }
+
+        void multiply( std::span<float const> x, std::span<float> y, std::size_t threads = 0 ) const { multiply<float>( x, y, threads ); }
+        void multiply( std::span<double const> x, std::span<double> y, std::size_t threads = 0 ) const { multiply<double>( x, y, threads ); }
+
+    private:
+        std::size_t rows_;
+        std::size_t cols_;
+        std::vector<std::uint64_t> row_offsets_;
+        std::vector<std::uint32_t> columns_;
+        std::vector<float16_t> values_;
+        double scale_ = 1.0;
+        std::size_t flushed_ = 0;
+    };
+
+    namespace float16_t_private
+    {
+        // r = b - A x, returns ||r||
+        template< typename T >
+        double krylov_residual( half_csr_matrix const& a, std::span<T const> b, std::span<T const> x, std::span<T> r, std::size_t threads )
+        {
+            a.multiply<T>( x, r, threads );
+            krylov_for( r.size(), [&]( std::size_t i ) { r[i] = b[i] - r[i]; }, threads );
+            return std::sqrt( krylov_dot<T>( r, r, threads ) );
+        }
+
+        inline void krylov_check( half_csr_matrix const& a, std::size_t b, std::size_t x )
+        {
+            if ( a.rows() != a.cols() || b != a.rows() || x != a.rows() )
+                throw std::invalid_argument( "krylov: the matrix must be square and match b and x" );
+        }
+
+    }//namespace float16_t_private
+
+    //
+    // solves A x = b for symmetric positive definite A, starting from the given x. the recursively updated residual
+    // is replaced by b - A x every replace_every steps and before convergence is declared, so the reported
+    // residual is the true one
+    //
+    template< typename T >
+    krylov_result conjugate_gradient( half_csr_matrix const& a, std::span<T const> b, std::span<T> x, krylov_options const& options = {} )
+    {
+        using float16_t_private::krylov_dot;
+        using float16_t_private::krylov_for;
+        float16_t_private::krylov_check( a, b.size(), x.size() );
+        std::size_t const n = b.size(), threads = options.threads;
+
+        krylov_result result;
+        double const b_norm = std::sqrt( krylov_dot<T>( b, b, threads ) );
+        if ( b_norm == 0.0 )
+        {
+            std::fill( x.begin(), x.end(), T( 0 ) );
+            result.converged = true;
+            return result;
+        }
+
+        std::vector<T> r( n ), p( n ), q( n );
+        double r_norm = float16_t_private::krylov_residual<T>( a, b, x, r, threads );
+        result.relative_residual = r_norm / b_norm;
+        if ( result.relative_residual <= options.tolerance )
+        {
+            result.converged = true;
+            return result;
+        }
+        std::copy( r.begin(), r.end(), p.begin() );
+        double rr = r_norm * r_norm;
+
+        while ( result.iterations < options.max_iterations )
+        {
+            a.multiply<T>( p, q, threads );
+            ++result.iterations;
+            double const pq = krylov_dot<T>( p, q, threads );
+            if ( !( pq > 0.0 ) )
+            {
+                result.breakdown = true;
+                break;
+            }
+            T const alpha = T( rr / pq );
+            krylov_for( n, [&]( std::size_t i ) { x[i] += alpha * p[i]; r[i] -= alpha * q[i]; }, threads );
+
+            double rr_next = krylov_dot<T>( r, r, threads );
+            bool const small = std::sqrt( rr_next ) / b_norm <= options.tolerance;
+            if ( small || ( options.replace_every && result.iterations % options.replace_every == 0 ) )
+            {
+                r_norm = float16_t_private::krylov_residual<T>( a, b, x, r, threads );
+                rr_next = r_norm * r_norm;
+                if ( r_norm / b_norm <= options.tolerance ) break;
+            }
+
+            T const beta = T( rr_next / rr );
+            krylov_for( n, [&]( std::size_t i ) { p[i] = r[i] + beta * p[i]; }, threads );
+            rr = rr_next;
+        }
+
+        result.relative_residual = float16_t_private::krylov_residual<T>( a, b, x, r, threads ) / b_norm;
+        result.converged = result.relative_residual <= options.tolerance;
+        return result;
+    }
+
+    //
+    // restarted GMRES(restart) for general square A, starting from the given x. each cycle ends early once the
+    // Arnoldi residual estimate meets the tolerance, then the true residual decides; cycles that no longer reduce
+    // the true residual end the solve
+    //
+    template< typename T >
+    krylov_result gmres( half_csr_matrix const& a, std::span<T const> b, std::span<T> x, krylov_options const& options = {} )
+    {
+        using float16_t_private::krylov_dot;
+        using float16_t_private::krylov_for;
+        float16_t_private::krylov_check( a, b.size(), x.size() );
+        std::size_t const n = b.size(), threads = options.threads;
+        std::size_t const m = std::max<std::size_t>( options.restart, 1 );
+
+        krylov_result result;
+        double const b_norm = std::sqrt( krylov_dot<T>( b, b, threads ) );
+        if ( b_norm == 0.0 )
+        {
+            std::fill( x.begin(), x.end(), T( 0 ) );
+            result.converged = true;
+            return result;
+        }
+
+        std::vector<T> r( n ), w( n );
+        std::vector<std::vector<T>> basis( m + 1, std::vector<T>( n ) );
+        std::vector<double> h( ( m + 1 ) * m ), cs( m ), sn( m ), g( m + 1 ), y( m );
+
+        double previous = std::numeric_limits<double>::infinity();
+        for ( ;; )
+        {
+            double const beta = float16_t_private::krylov_residual<T>( a, b, x, r, threads );
+            result.relative_residual = beta / b_norm;
+            if ( result.relative_residual <= options.tolerance )
+            {
+                result.converged = true;
+                break;
+            }
+            if ( result.iterations >= options.max_iterations || !( beta < previous ) )
+                break;
+            previous = beta;
+
+            krylov_for( n, [&]( std::size_t i ) { basis[0][i] = T( r[i] / beta ); }, threads );
+            std::fill( g.begin(), g.end(), 0.0 );
+            g[0] = beta;
+
+            std::size_t k = 0;
+            while ( k < m && result.iterations < options.max_iterations )
+            {
+                a.multiply<T>( basis[k], w, threads );
+                ++result.iterations;
+                for ( std::size_t i = 0; i <= k; ++i )
+                {
+                    double const hik = krylov_dot<T>( w, basis[i], threads );
+                    h[i * m + k] = hik;
+                    krylov_for( n, [&]( std::size_t t ) { w[t] -= T( hik ) * basis[i][t]; }, threads );
+                }
+                double const next = std::sqrt( krylov_dot<T>( w, w, threads ) );
+                h[( k + 1 ) * m + k] = next;
+
+                for ( std::size_t i = 0; i != k; ++i )
+                {
+                    double const t = cs[i] * h[i * m + k] + sn[i] * h[( i + 1 ) * m + k];
+                    h[( i + 1 ) * m + k] = -sn[i] * h[i * m + k] + cs[i] * h[( i + 1 ) * m + k];
+                    h[i * m + k] = t;
+                }
+                double const d = std::hypot( h[k * m + k], next );
+                cs[k] = d > 0.0 ? h[k * m + k] / d : 1.0;
+                sn[k] = d > 0.0 ? next / d : 0.0;
+                h[k * m + k] = d;
+                h[( k + 1 ) * m + k] = 0.0;
+                g[k + 1] = -sn[k] * g[k];
+                g[k] = cs[k] * g[k];
+                ++k;
+
+                // an exact invariant subspace, or the estimate already meets the tolerance
+                if ( next == 0.0 || std::abs( g[k] ) / b_norm <= options.tolerance ) break;
+                krylov_for( n, [&]( std::size_t t ) { basis[k][t] = T( w[t] / next ); }, threads );
+            }
+
+            for ( std::size_t i = k; i-- > 0; )
+            {
+                double s = g[i];
+                for ( std::size_t j = i + 1; j != k; ++j ) s -= h[i * m + j] * y[j];
+                y[i] = h[i * m + i] != 0.0 ? s / h[i * m + i] : 0.0;
+            }
+            krylov_for( n, [&]( std::size_t t )
+            {
+                double s = 0.0;
+                for ( std::size_t j = 0; j != k; ++j ) s += y[j] * double( basis[j][t] );
+                x[t] += T( s );
+            }, threads );
+        }
+        return result;
+    }
+
+    inline krylov_result conjugate_gradient( half_csr_matrix const& a, std::span<float const> b, std::span<float> x, krylov_options const& options = {} )
+    {
+        return conjugate_gradient<float>( a, b, x, options );
+    }
+
+    inline krylov_result conjugate_gradient( half_csr_matrix const& a, std::span<double const> b, std::span<double> x, krylov_options const& options = {} )
+    {
+        return conjugate_gradient<double>( a, b, x, options );
+    }
+
+    inline krylov_result gmres( half_csr_matrix const& a, std::span<float const> b, std::span<float> x, krylov_options const& options = {} )
+    {
+        return gmres<float>( a, b, x, options );
+    }
+
+    inline krylov_result gmres( half_csr_matrix const& a, std::span<double const> b, std::span<double> x, krylov_options const& options = {} )
+    {
+        return gmres<double>( a, b, x, options );
+    }
+
+}//namespace numeric
+
+#endif
@@ -0,0 +1,445 @@
+#ifndef FLOAT16_T_LOADER_HPP_INCLUDED_SDLKFJ3049USDLKFJ0394USDFLKJ3049USDFLKJSDFL
+#define FLOAT16_T_LOADER_HPP_INCLUDED_SDLKFJ3049USDLKFJ0394USDFLKJ3049USDFLKJSDFL
+//
+// asynchronous loading of raw float16_t data from a file straight into float: the file is read in chunks
+// through io_uring (plain pread when the kernel or a sandbox refuses it) into a fixed set of aligned
+// buffers, and every completed chunk is widened by a pool of worker threads while the next reads are in
+// flight. memory beyond the output is bounded by queue_depth * chunk_bytes.
+//
+#include "float16_t.hpp"
+#include "float16_t_parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace numeric
+{
+    struct load_options
+    {
+        std::size_t chunk_bytes = std::size_t( 1 ) << 22;   // rounded up to a multiple of 4096
+        std::size_t queue_depth = 8;                        // chunk buffers, i.e. reads in flight plus chunks being widened
+        std::size_t threads = 0;                            // widening workers, 0 means all hardware threads
+        bool io_uring = true;                               // false forces the pread path
+    };
+
+    struct load_stats
+    {
+        std::size_t bytes = 0;
+        std::size_t chunks = 0;
+        bool io_uring = false;
+        double wall_seconds = 0.0;
+        double io_seconds = 0.0;        // time with at least one read in flight
+        double convert_seconds = 0.0;   // widening time summed over the workers
+
+        // share of the shorter of the two activities that ran concurrently with the other, in [0, 1]
+        double overlap() const noexcept
+        {
+            double const shorter = std::min( io_seconds, convert_seconds );
+            if ( shorter <= 0.0 ) return 0.0;
+            return std::clamp( ( io_seconds + convert_seconds - wall_seconds ) / shorter, 0.0, 1.0 );
+        }
+    };
+
+    namespace float16_t_private
+    {
+        constexpr inline std::size_t loader_alignment = 4096;
+
+        struct loader_free
+        {
+            void operator()( std::byte* p ) const noexcept { ::operator delete[]( p, std::align_val_t{ loader_alignment } ); }
+        };
+
+        //
+        // a minimal io_uring submission/completion pair driven through the raw syscalls, one reader thread only.
+        // when the ring cannot be set up, or the kernel predates IORING_OP_READ, reads are done with pread at
+        // submission time and their results queued for wait()
+        //
+        class read_queue
+        {
+        public:
+            read_queue( unsigned entries, bool try_uring )
+            {
+                if ( try_uring ) setup( entries );
+            }
+
+            read_queue( read_queue const& ) = delete;
+            read_queue& operator = ( read_queue const& ) = delete;
+
+            ~read_queue()
+            {
+                if ( ring_fd_ < 0 ) return;
+                munmap( sqes_, sqes_bytes_ );
+                if ( cq_ptr_ != sq_ptr_ ) munmap( cq_ptr_, cq_bytes_ );
+                munmap( sq_ptr_, sq_bytes_ );
+                ::close( ring_fd_ );
+            }
+
+            bool uring() const noexcept { return ring_fd_ >= 0; }
+
+            // reads prepared but not yet accepted by the kernel
+            unsigned unsubmitted() const noexcept { return pending_; }
+
+            // queues a read of len bytes at offset into buffer; nothing reaches the kernel before submit()
+            void prepare( int fd, void* buffer, unsigned len, std::uint64_t offset, std::uint64_t tag )
+            {
+                if ( !uring() )
+                {
+                    ssize_t r;
+                    do r = ::pread( fd, buffer, len, static_cast<off_t>( offset ) ); while ( r < 0 && errno == EINTR );
+                    done_.emplace_back( tag, r < 0 ? -errno : static_cast<int>( r ) );
+                    return;
+                }
+                unsigned const tail = *sq_tail_;
+                unsigned const index = tail & *sq_mask_;
+                io_uring_sqe& sqe = sqes_[index];
+                std::memset( &sqe, 0, sizeof( sqe ) );
+                sqe.opcode = IORING_OP_READ;
+                sqe.fd = fd;
+                sqe.addr = reinterpret_cast<std::uint64_t>( buffer );
+                sqe.len = len;
+                sqe.off = offset;
+                sqe.user_data = tag;
+                sq_array_[index] = index;
+                std::atomic_ref<unsigned>{ *sq_tail_ }.store( tail + 1, std::memory_order_release );
+                ++pending_;
+            }
+
+            void submit()
+            {
+                while ( pending_ )
+                {
+                    long const r = enter( pending_, 0, 0 );
+                    if ( r < 0 )
+                    {
+                        if ( errno == EINTR || errno == EAGAIN ) continue;
+                        throw std::system_error( errno, std::generic_category(), "io_uring_enter" );
+                    }
+                    pending_ -= static_cast<unsigned>( r );
+                }
+            }
+
+            // blocks for the next completion: ( tag, bytes read or -errno )
+            std::pair<std::uint64_t, int> wait()
+            {
+                if ( !uring() )
+                {
+                    auto const r = done_.front();
+                    done_.pop_front();
+                    return r;
+                }
+                for ( ;; )
+                {
+                    unsigned const head = *cq_head_;
+                    if ( head != std::atomic_ref<unsigned>{ *cq_tail_ }.load( std::memory_order_acquire ) )
+                    {
+                        io_uring_cqe const& cqe = cqes_[head & *cq_mask_];
+                        std::pair<std::uint64_t, int> const r{ cqe.user_data, cqe.res };
+                        std::atomic_ref<unsigned>{ *cq_head_ }.store( head + 1, std::memory_order_release );
+                        return r;
+                    }
+                    if ( enter( 0, 1, IORING_ENTER_GETEVENTS ) < 0 && errno != EINTR )
+                        throw std::system_error( errno, std::generic_category(), "io_uring_enter" );
+                }
+            }
+
+        private:
+            long enter( unsigned submit, unsigned complete, unsigned flags ) noexcept
+            {
+                return ::syscall( __NR_io_uring_enter, ring_fd_, submit, complete, flags, nullptr, 0 );
+            }
+
+            void setup( unsigned entries )
+            {
+                io_uring_params params;
+                std::memset( &params, 0, sizeof( params ) );
+                int const fd = static_cast<int>( ::syscall( __NR_io_uring_setup, entries, &params ) );
+                if ( fd < 0 ) return;
+                // IORING_OP_READ arrived together with this feature bit (5.6)
+                if ( !( params.features & IORING_FEAT_RW_CUR_POS ) ) { ::close( fd ); return; }
+
+                sq_bytes_ = params.sq_off.array + params.sq_entries * sizeof( unsigned );
+                cq_bytes_ = params.cq_off.cqes + params.cq_entries * sizeof( io_uring_cqe );
+                bool const single = params.features & IORING_FEAT_SINGLE_MMAP;
+                if ( single ) sq_bytes_ = cq_bytes_ = std::max( sq_bytes_, cq_bytes_ );
+
+                void* sq = mmap( nullptr, sq_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING );
+                if ( sq == MAP_FAILED ) { ::close( fd ); return; }
+                void* cq = single ? sq : mmap( nullptr, cq_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING );
+                if ( cq == MAP_FAILED ) { munmap( sq, sq_bytes_ ); ::close( fd ); return; }
+                sqes_bytes_ = params.sq_entries * sizeof( io_uring_sqe );
+                void* sqes = mmap( nullptr, sqes_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES );
+                if ( sqes == MAP_FAILED )
+                {
+                    if ( !single ) munmap( cq, cq_bytes_ );
+                    munmap( sq, sq_bytes_ );
+                    ::close( fd );
+                    return;
+                }
+
+                auto* const s = static_cast<std::byte*>( sq );
+                auto* const c = static_cast<std::byte*>( cq );
+                sq_ptr_ = sq;
+                cq_ptr_ = cq;
+                sq_tail_ = reinterpret_cast<unsigned*>( s + params.sq_off.tail );
+                sq_mask_ = reinterpret_cast<unsigned*>( s + params.sq_off.ring_mask );
+                sq_array_ = reinterpret_cast<unsigned*>( s + params.sq_off.array );
+                cq_head_ = reinterpret_cast<unsigned*>( c + params.cq_off.head );
+                cq_tail_ = reinterpret_cast<unsigned*>( c + params.cq_off.tail );
+                cq_mask_ = reinterpret_cast<unsigned*>( c + params.cq_off.ring_mask );
+                cqes_ = reinterpret_cast<io_uring_cqe*>( c + params.cq_off.cqes );
+                sqes_ = static_cast<io_uring_sqe*>( sqes );
+                ring_fd_ = fd;
+            }
+
+            int ring_fd_ = -1;
+            void* sq_ptr_ = nullptr;
+            void* cq_ptr_ = nullptr;
+            std::size_t sq_bytes_ = 0;
+            std::size_t cq_bytes_ = 0;
+            std::size_t sqes_bytes_ = 0;
+            unsigned* sq_tail_ = nullptr;
+            unsigned* sq_mask_ = nullptr;
+            unsigned* sq_array_ = nullptr;
+            unsigned* cq_head_ = nullptr;
+            unsigned* cq_tail_ = nullptr;
+            unsigned* cq_mask_ = nullptr;
+            io_uring_cqe* cqes_ = nullptr;
+            io_uring_sqe* sqes_ = nullptr;
+            unsigned pending_ = 0;
+            std::deque<std::pair<std::uint64_t, int>> done_;
+        };
+
+        struct file_descriptor
+        {
+            int fd = -1;
+            ~file_descriptor() { if ( fd >= 0 ) ::close( fd ); }
+        };
+
+    }//namespace float16_t_private
+
+    class half_loader
+    {
+    public:
+        explicit half_loader( load_options const& options = {} ) : options_{ options }
+        {
+            if ( options_.queue_depth == 0 )
+                throw std::invalid_argument( "half_loader: queue_depth must be positive" );
+            std::size_t const a = float16_t_private::loader_alignment;
+            options_.chunk_bytes = std::max( a, ( options_.chunk_bytes + a - 1 ) / a * a );
+            if ( options_.chunk_bytes > ( std::size_t( 1 ) << 30 ) )
+                throw std::invalid_argument( "half_loader: chunk_bytes above 1 GiB" );
+            buffers_.reset( static_cast<std::byte*>( ::operator new[]( options_.chunk_bytes * options_.queue_depth, std::align_val_t{ a } ) ) );
+            queue_ = std::make_unique<float16_t_private::read_queue>( static_cast<unsigned>( std::bit_ceil( options_.queue_depth ) ), options_.io_uring );
+        }
+
+        bool uses_io_uring() const noexcept { return queue_->uring(); }
+
+        //
+        // reads out.size() halves starting at byte `offset` of `path` and widens them into `out`;
+        // throws std::system_error on I/O errors and std::runtime_error when the file is too short
+        //
+        load_stats load( std::string const& path, std::uint64_t offset, std::span<float> out )
+        {
+            using clock = std::chrono::steady_clock;
+            auto const start = clock::now();
+
+            float16_t_private::file_descriptor file;
+            file.fd = ::open( path.c_str(), O_RDONLY | O_CLOEXEC );
+            if ( file.fd < 0 )
+                throw std::system_error( errno, std::generic_category(), "half_loader: open " + path );
+
+            std::size_t const chunk = options_.chunk_bytes;
+            std::size_t const depth = options_.queue_depth;
+            std::size_t const total = out.size() * sizeof( float16_t );
+            std::size_t const chunks = ( total + chunk - 1 ) / chunk;
+
+            load_stats stats;
+            stats.bytes = total;
+            stats.chunks = chunks;
+            stats.io_uring = uses_io_uring();
+
+            // shared with the workers
+            struct ready_chunk { std::size_t buffer; std::size_t chunk; };
+            std::mutex mutex;
+            std::condition_variable work, freed;
+            std::deque<ready_chunk> ready;
+            std::vector<std::size_t> free_buffers( depth );
+            for ( std::size_t b = 0; b != depth; ++b ) free_buffers[b] = depth - 1 - b;
+            bool stop = false;
+            std::atomic<std::int64_t> convert_ns{ 0 };
+
+            auto const worker = [&]
+            {
+                for ( ;; )
+                {
+                    ready_chunk task;
+                    {
+                        std::unique_lock lock{ mutex };
+                        work.wait( lock, [&] { return !ready.empty() || stop; } );
+                        if ( ready.empty() ) return;
+                        task = ready.front();
+                        ready.pop_front();
+                    }
+                    auto const t0 = clock::now();
+                    std::size_t const first = task.chunk * chunk / sizeof( float16_t );
+                    std::size_t const count = std::min( out.size() - first, chunk / sizeof( float16_t ) );
+                    widen( reinterpret_cast<float16_t const*>( buffer( task.buffer ) ), out.data() + first, count );
+                    convert_ns.fetch_add( std::chrono::duration_cast<std::chrono::nanoseconds>( clock::now() - t0 ).count(), std::memory_order_relaxed );
+                    {
+                        std::lock_guard lock{ mutex };
+                        free_buffers.push_back( task.buffer );
+                    }
+                    freed.notify_one();
+                }
+            };
+
+            // per buffer: the chunk it holds and how many of its bytes have arrived
+            std::vector<std::size_t> held( depth ), filled( depth );
+            std::size_t submitted = 0, inflight = 0;
+            clock::time_point busy_since{};
+            std::exception_ptr error;
+            bool broken = false;    // the queue threw, its state is no longer trusted
+
+            auto const length = [&]( std::size_t c ) { return std::min( chunk, total - c * chunk ); };
+            auto const issue = [&]( std::size_t b )
+            {
+                if ( inflight++ == 0 ) busy_since = clock::now();
+                queue_->prepare( file.fd, buffer( b ) + filled[b], static_cast<unsigned>( length( held[b] ) - filled[b] ), offset + held[b] * chunk + filled[b], b );
+            };
+            auto const retire = [&]
+            {
+                if ( --inflight == 0 ) stats.io_seconds += std::chrono::duration<double>( clock::now() - busy_since ).count();
+            };
+
+            std::size_t const workers = std::max<std::size_t>( 1, std::min( options_.threads ? options_.threads : float16_t_private::hardware_threads(), chunks ) );
+            std::vector<std::thread> pool;
+            try
+            {
+                pool.reserve( workers );
+                for ( std::size_t w = 0; w != workers; ++w )
+                    pool.emplace_back( worker );
+
+                while ( submitted < chunks || inflight )
+                {
+                    if ( !error )
+                    {
+                        std::vector<std::size_t> grabbed;
+                        {
+                            std::unique_lock lock{ mutex };
+                            if ( inflight == 0 )
+                                freed.wait( lock, [&] { return !free_buffers.empty(); } );
+                            while ( submitted + grabbed.size() < chunks && !free_buffers.empty() )
+                            {
+                                grabbed.push_back( free_buffers.back() );
+                                free_buffers.pop_back();
+                            }
+                        }
+                        for ( std::size_t b : grabbed )
+                        {
+                            held[b] = submitted++;
+                            filled[b] = 0;
+                            issue( b );
+                        }
+                        queue_->submit();
+                    }
+                    if ( inflight == 0 ) break;
+
+                    auto const [tag, result] = queue_->wait();
+                    std::size_t const b = static_cast<std::size_t>( tag );
+                    retire();
+                    if ( error ) continue;   // only draining reads that still target our buffers
+                    if ( result <= 0 )
+                    {
+                        error = result < 0 ? std::make_exception_ptr( std::system_error( -result, std::generic_category(), "half_loader: read " + path ) )
+                                           : std::make_exception_ptr( std::runtime_error( "half_loader: " + path + " ends before the requested range" ) );
+                        continue;
+                    }
+                    filled[b] += static_cast<std::size_t>( result );
+                    if ( filled[b] < length( held[b] ) )
+                    {
+                        issue( b );   // short read, ask for the rest
+                        queue_->submit();
+                        continue;
+                    }
+                    {
+                        std::lock_guard lock{ mutex };
+                        ready.push_back( { b, held[b] } );
+                    }
+                    work.notify_one();
+                }
+            }
+            catch ( ... )
+            {
+                if ( !error ) error = std::current_exception();
+                broken = true;
+            }
+
+            {
+                std::lock_guard lock{ mutex };
+                stop = true;
+            }
+            work.notify_all();
+            for ( auto& t : pool )
+                t.join();
+            if ( broken )
+            {
+                // collect what the kernel still owes for our buffers, then start the next load() on a fresh ring
+                try
+                {
+                    for ( std::size_t owed = inflight - std::min<std::size_t>( inflight, queue_->unsubmitted() ); owed; --owed )
+                        queue_->wait();
+                }
+                catch ( ... ) {}
+                queue_ = std::make_unique<float16_t_private::read_queue>( static_cast<unsigned>( std::bit_ceil( depth ) ), options_.io_uring );
+            }
+            if ( error )
+                std::rethrow_exception( error );
+
+            stats.convert_seconds = double( convert_ns.load() ) * 1.0e-9;
+            stats.wall_seconds = std::chrono::duration<double>( clock::now() - start ).count();
+            return stats;
+        }
+
+        std::vector<float> load( std::string const& path, std::uint64_t offset, std::size_t count )
+        {
+            std::vector<float> out( count );
+            load( path, offset, out );
+            return out;
+        }
+
+    private:
+        std::byte* buffer( std::size_t b ) const noexcept { return buffers_.get() + b * options_.chunk_bytes; }
+
+        load_options options_;
+        std::unique_ptr<std::byte[], float16_t_private::loader_free> buffers_;
+        std::unique_ptr<float16_t_private::read_queue> queue_;
+    };
+
+}//namespace numeric
+
+#endif
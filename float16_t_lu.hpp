@@ -0,0 +1,363 @@
+#ifndef FLOAT16_T_LU_HPP_INCLUDED_SDLFKJ3049USDFLKJ3049USDLFKJ0394USDFLKJ3049US
+#define FLOAT16_T_LU_HPP_INCLUDED_SDLFKJ3049USDFLKJ3049USDLFKJ0394USDFLKJ3049US
+//
+// mixed-precision LU with iterative refinement for dense systems: the matrix is equilibrated by powers of two,
+// factorized with partial pivoting in fp32 (blocked, right-looking, the trailing updates run as a GEMM over
+// the half-stored panels), and the L and U factors are kept as float16_t (U rows carry a power-of-two scale so
+// no entry overflows past fp16_max). solutions from the half factors are refined with fp64 residuals until the
+// normwise backward error reaches fp64 level. works while the condition number stays well below ~1e4.
+//
+#include "float16_t.hpp"
+#include "float16_t_parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#if defined(__F16C__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+namespace numeric
+{
+    struct lu_options
+    {
+        std::size_t block = 64;             // panel width of the blocked factorization
+        std::size_t threads = 0;            // 0 means all hardware threads
+        std::size_t max_iterations = 30;    // refinement steps
+        double tolerance = 0.0;             // backward error to reach, 0 means n * 2^-53
+    };
+
+    struct refinement_result
+    {
+        std::size_t iterations = 0;
+        double backward_error = 0.0;        // ||b - A x||_inf / ( ||A||_inf ||x||_inf + ||b||_inf )
+        bool converged = false;
+    };
+
+    namespace float16_t_private
+    {
+        // largest U row entry after scaling, leaves headroom below fp16_max
+        constexpr inline float lu_row_target = 16384.0f;
+
+        // the largest power of two not above v > 0
+        inline double power_of_two_below( double v ) noexcept
+        {
+            int e;
+            std::frexp( v, &e );
+            return std::ldexp( 1.0, e - 1 );
+        }
+
+        //
+        // c[r * ldc + j] += sum_k a[r * lda + k] * b[k * ldb + j] for r < rows, j < cols, k < depth:
+        // fp32 multipliers against a half panel, accumulated in fp32. 4 x 16 register tiles on F16C/FMA
+        //
+        inline void gemm_half_update( float const* a, std::size_t lda, float16_t const* b, std::size_t ldb,
+                                      float* c, std::size_t ldc, std::size_t rows, std::size_t cols, std::size_t depth ) noexcept
+        {
+            std::size_t r = 0;
+#if defined(__F16C__) && defined(__FMA__)
+            for ( ; r + 4 <= rows; r += 4 )
+            {
+                std::size_t j = 0;
+                for ( ; j + 16 <= cols; j += 16 )
+                {
+                    __m256 acc[4][2];
+                    for ( std::size_t i = 0; i != 4; ++i )
+                    {
+                        acc[i][0] = _mm256_loadu_ps( c + ( r + i ) * ldc + j );
+                        acc[i][1] = _mm256_loadu_ps( c + ( r + i ) * ldc + j + 8 );
+                    }
+                    for ( std::size_t k = 0; k != depth; ++k )
+                    {
+                        float16_t const* const row = b + k * ldb + j;
+                        __m256 const b0 = _mm256_cvtph_ps( _mm_loadu_si128( reinterpret_cast<__m128i const*>( row ) ) );
+                        __m256 const b1 = _mm256_cvtph_ps( _mm_loadu_si128( reinterpret_cast<__m128i const*>( row + 8 ) ) );
+                        for ( std::size_t i = 0; i != 4; ++i )
+                        {
+                            __m256 const w = _mm256_broadcast_ss( a + ( r + i ) * lda + k );
+                            acc[i][0] = _mm256_fmadd_ps( w, b0, acc[i][0] );
+                            acc[i][1] = _mm256_fmadd_ps( w, b1, acc[i][1] );
+                        }
+                    }
+                    for ( std::size_t i = 0; i != 4; ++i )
+                    {
+                        _mm256_storeu_ps( c + ( r + i ) * ldc + j, acc[i][0] );
+                        _mm256_storeu_ps( c + ( r + i ) * ldc + j + 8, acc[i][1] );
+                    }
+                }
+                for ( std::size_t i = 0; i != 4; ++i )
+                    for ( std::size_t k = 0; k != depth; ++k )
+                    {
+                        float const w = a[( r + i ) * lda + k];
+                        for ( std::size_t jj = j; jj != cols; ++jj )
+                            c[( r + i ) * ldc + jj] += w * float( b[k * ldb + jj] );
+                    }
+            }
+#endif
+            for ( ; r < rows; ++r )
+                for ( std::size_t k = 0; k != depth; ++k )
+                {
+                    float const w = a[r * lda + k];
+                    for ( std::size_t j = 0; j != cols; ++j )
+                        c[r * ldc + j] += w * float( b[k * ldb + j] );
+                }
+        }
+
+        // sum of row[i] * x[i], the half row widened a chunk at a time
+        inline float dot_half( float16_t const* row, float const* x, std::size_t n ) noexcept
+        {
+            float buffer[512];
+            float sum = 0.0f;
+            for ( std::size_t first = 0; first < n; first += 512 )
+            {
+                std::size_t const m = std::min<std::size_t>( 512, n - first );
+                widen( row + first, buffer, m );
+                for ( std::size_t i = 0; i != m; ++i )
+                    sum += buffer[i] * x[first + i];
+            }
+            return sum;
+        }
+
+    }//namespace float16_t_private
+
+    class mixed_lu
+    {
+    public:
+        //
+        // factorizes the row-major n x n matrix `a`; throws std::invalid_argument on a size mismatch and
+        // std::runtime_error when a pivot vanishes
+        //
+        mixed_lu( std::span<double const> a, std::size_t n, lu_options const& options = {} )
+            : n_{ n }, options_{ options }, factors_( n * n ), row_scale_( n ), col_scale_( n ), u_scale_( n ), pivots_( n )
+        {
+            if ( a.size() != n * n )
+                throw std::invalid_argument( "mixed_lu: matrix is not n x n" );
+            options_.block = std::max<std::size_t>( options_.block, 1 );
+            equilibrate( a );
+            factorize( a );
+        }
+
+        std::size_t size() const noexcept { return n_; }
+
+        // bytes held by the factors
+        std::size_t bytes() const noexcept
+        {
+            return factors_.size() * sizeof( float16_t ) + ( row_scale_.size() + col_scale_.size() ) * sizeof( double ) +
+                   u_scale_.size() * sizeof( float ) + pivots_.size() * sizeof( std::size_t );
+        }
+
+        // overwrites `x` (holding b) with the fp32 solution through the half factors, roughly 3 digits
+        void solve( std::span<double> x ) const
+        {
+            if ( x.size() != n_ )
+                throw std::invalid_argument( "mixed_lu::solve: vector size differs from the matrix" );
+            std::vector<float> y( n_ );
+            for ( std::size_t i = 0; i != n_; ++i )
+                y[i] = float( x[i] * row_scale_[i] );
+            for ( std::size_t i = 0; i != n_; ++i )
+                std::swap( y[i], y[pivots_[i]] );
+
+            for ( std::size_t i = 1; i < n_; ++i )
+                y[i] -= float16_t_private::dot_half( factors_.data() + i * n_, y.data(), i );
+            for ( std::size_t i = n_; i-- > 0; )
+            {
+                float16_t const* const row = factors_.data() + i * n_;
+                float const rest = float16_t_private::dot_half( row + i + 1, y.data() + i + 1, n_ - i - 1 );
+                y[i] = ( y[i] / u_scale_[i] - rest ) / float( row[i] );
+            }
+
+            for ( std::size_t i = 0; i != n_; ++i )
+                x[i] = double( y[i] ) * col_scale_[i];
+        }
+
+        //
+        // solves a x = b: starts from the half-factor solution and adds corrections solved against the fp64
+        // residual until the backward error drops to the tolerance, stagnates, or max_iterations is reached
+        //
+        refinement_result refine( std::span<double const> a, std::span<double const> b, std::span<double> x ) const
+        {
+            if ( a.size() != n_ * n_ || b.size() != n_ || x.size() != n_ )
+                throw std::invalid_argument( "mixed_lu::refine: sizes differ from the matrix" );
+
+            double const tolerance = options_.tolerance > 0.0 ? options_.tolerance : double( n_ ) * std::ldexp( 1.0, -53 );
+            double a_norm = 0.0;
+            for ( std::size_t i = 0; i != n_; ++i )
+            {
+                double s = 0.0;
+                for ( std::size_t j = 0; j != n_; ++j ) s += std::abs( a[i * n_ + j] );
+                a_norm = std::max( a_norm, s );
+            }
+            double b_norm = 0.0;
+            for ( double v : b ) b_norm = std::max( b_norm, std::abs( v ) );
+
+            std::copy( b.begin(), b.end(), x.begin() );
+            solve( x );
+
+            refinement_result result;
+            std::vector<double> r( n_ );
+            double previous = std::numeric_limits<double>::infinity();
+            for ( ;; )
+            {
+                float16_t_private::parallel_for( 0, n_, 64, [&]( std::size_t first, std::size_t last )
+                {
+                    for ( std::size_t i = first; i != last; ++i )
+                    {
+                        double s = b[i];
+                        for ( std::size_t j = 0; j != n_; ++j ) s -= a[i * n_ + j] * x[j];
+                        r[i] = s;
+                    }
+                }, options_.threads );
+
+                double r_norm = 0.0, x_norm = 0.0;
+                for ( std::size_t i = 0; i != n_; ++i )
+                {
+                    r_norm = std::max( r_norm, std::abs( r[i] ) );
+                    x_norm = std::max( x_norm, std::abs( x[i] ) );
+                }
+                double const denominator = a_norm * x_norm + b_norm;
+                result.backward_error = denominator > 0.0 ? r_norm / denominator : 0.0;
+                if ( result.backward_error <= tolerance )
+                {
+                    result.converged = true;
+                    break;
+                }
+                // each step should gain about the precision of the factors, stop once it no longer halves the error
+                if ( result.iterations == options_.max_iterations || !std::isfinite( result.backward_error ) || result.backward_error > 0.5 * previous )
+                    break;
+                previous = result.backward_error;
+
+                // normalized so that residuals far below fp32 range survive the fp32 solve
+                for ( auto& v : r ) v /= r_norm;
+                solve( r );
+                for ( std::size_t i = 0; i != n_; ++i ) x[i] += r[i] * r_norm;
+                ++result.iterations;
+            }
+            return result;
+        }
+
+    private:
+        // power-of-two row then column scales bringing every row and column maximum into [0.5, 1]
+        void equilibrate( std::span<double const> a )
+        {
+            for ( std::size_t i = 0; i != n_; ++i )
+            {
+                double m = 0.0;
+                for ( std::size_t j = 0; j != n_; ++j ) m = std::max( m, std::abs( a[i * n_ + j] ) );
+                if ( m == 0.0 || !std::isfinite( m ) )
+                    throw std::runtime_error( "mixed_lu: matrix has a zero or non-finite row" );
+                row_scale_[i] = 0.5 / float16_t_private::power_of_two_below( m );
+            }
+            std::vector<double> m( n_, 0.0 );
+            for ( std::size_t i = 0; i != n_; ++i )
+                for ( std::size_t j = 0; j != n_; ++j )
+                    m[j] = std::max( m[j], std::abs( a[i * n_ + j] ) * row_scale_[i] );
+            for ( std::size_t j = 0; j != n_; ++j )
+            {
+                if ( m[j] == 0.0 )
+                    throw std::runtime_error( "mixed_lu: matrix has a zero column" );
+                col_scale_[j] = 0.5 / float16_t_private::power_of_two_below( m[j] );
+            }
+        }
+
+        void factorize( std::span<double const> a )
+        {
+            std::size_t const n = n_;
+            std::vector<float> w( n * n );   // the fp32 working matrix, only its trailing part is live
+            for ( std::size_t i = 0; i != n; ++i )
+                for ( std::size_t j = 0; j != n; ++j )
+                    w[i * n + j] = float( a[i * n + j] * row_scale_[i] * col_scale_[j] );
+
+            std::vector<float> multipliers;
+            for ( std::size_t k0 = 0; k0 < n; k0 += options_.block )
+            {
+                std::size_t const k1 = std::min( n, k0 + options_.block );
+
+                // panel: unblocked partial pivoting on columns [k0, k1), pivots swap whole rows
+                for ( std::size_t j = k0; j != k1; ++j )
+                {
+                    std::size_t p = j;
+                    for ( std::size_t i = j + 1; i != n; ++i )
+                        if ( std::abs( w[i * n + j] ) > std::abs( w[p * n + j] ) ) p = i;
+                    if ( w[p * n + j] == 0.0f )
+                        throw std::runtime_error( "mixed_lu: matrix is singular to working precision" );
+                    pivots_[j] = p;
+                    if ( p != j )
+                    {
+                        std::swap_ranges( w.begin() + std::ptrdiff_t( j * n + k0 ), w.begin() + std::ptrdiff_t( j * n + n ), w.begin() + std::ptrdiff_t( p * n + k0 ) );
+                        std::swap_ranges( factors_.begin() + std::ptrdiff_t( j * n ), factors_.begin() + std::ptrdiff_t( j * n + k0 ), factors_.begin() + std::ptrdiff_t( p * n ) );
+                    }
+                    float const inverse = 1.0f / w[j * n + j];
+                    for ( std::size_t i = j + 1; i != n; ++i )
+                    {
+                        float const l = w[i * n + j] *= inverse;
+                        for ( std::size_t c = j + 1; c != k1; ++c )
+                            w[i * n + c] -= l * w[j * n + c];
+                    }
+                }
+
+                // U12 = L11^-1 A12
+                for ( std::size_t j = k0 + 1; j < k1; ++j )
+                    for ( std::size_t t = k0; t != j; ++t )
+                    {
+                        float const l = w[j * n + t];
+                        for ( std::size_t c = k1; c != n; ++c )
+                            w[j * n + c] -= l * w[t * n + c];
+                    }
+
+                // store the panel: L columns unscaled (|l| <= 1), U rows with their own power-of-two scale
+                for ( std::size_t i = k0 + 1; i < n; ++i )
+                    for ( std::size_t j = k0; j != std::min( i, k1 ); ++j )
+                        factors_[i * n + j] = float16_t{ w[i * n + j] };
+                for ( std::size_t i = k0; i != k1; ++i )
+                {
+                    float m = 0.0f;
+                    for ( std::size_t j = i; j != n; ++j ) m = std::max( m, std::abs( w[i * n + j] ) );
+                    u_scale_[i] = float( float16_t_private::power_of_two_below( m ) ) * 2.0f / float16_t_private::lu_row_target;
+                    float const inverse = 1.0f / u_scale_[i];
+                    for ( std::size_t j = i; j != n; ++j )
+                        factors_[i * n + j] = float16_t{ w[i * n + j] * inverse };
+                }
+
+                // trailing update A22 -= L21 U12, both operands read back from their half storage
+                if ( k1 == n ) break;
+                std::size_t const depth = k1 - k0;
+                multipliers.assign( ( n - k1 ) * depth, 0.0f );
+                for ( std::size_t i = k1; i != n; ++i )
+                    for ( std::size_t t = k0; t != k1; ++t )
+                        multipliers[( i - k1 ) * depth + t - k0] = -float( factors_[i * n + t] ) * u_scale_[t];
+                float16_t_private::parallel_for( k1, n, 32, [&]( std::size_t first, std::size_t last )
+                {
+                    // column strips keep the U12 panel slice in cache across the rows
+                    for ( std::size_t c = k1; c < n; c += 1024 )
+                        float16_t_private::gemm_half_update( multipliers.data() + ( first - k1 ) * depth, depth, factors_.data() + k0 * n + c, n,
+                                                             w.data() + first * n + c, n, last - first, std::min<std::size_t>( 1024, n - c ), depth );
+                }, options_.threads );
+            }
+        }
+
+        std::size_t n_;
+        lu_options options_;
+        std::vector<float16_t> factors_;     // unit lower L below the diagonal, U / u_scale_ on and above it
+        std::vector<double> row_scale_;
+        std::vector<double> col_scale_;
+        std::vector<float> u_scale_;
+        std::vector<std::size_t> pivots_;    // row i was swapped with pivots_[i] >= i, in order
+    };
+
+    // factorizes and refines in one call
+    inline refinement_result solve_refined( std::span<double const> a, std::size_t n, std::span<double const> b, std::span<double> x,
+                                            lu_options const& options = {} )
+    {
+        return mixed_lu{ a, n, options }.refine( a, b, x );
+    }
+
+}//namespace numeric
+
+#endif
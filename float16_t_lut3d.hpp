@@ -0,0 +1,364 @@
+#ifndef FLOAT16_T_LUT3D_HPP_INCLUDED_SDLKFJ3049UFSDLKJ3049USDLFKJ3049USDLKFJ3094
+#define FLOAT16_T_LUT3D_HPP_INCLUDED_SDLKFJ3049UFSDLKJ3049USDLFKJ3049USDLKFJ3094
+//
+// 3D color LUTs (33^3, 65^3, ...) applied to interleaved RGBA float16_t pixels.
+// entries are stored as halves, padded to four per entry so a corner is two 32-bit gathers; each channel
+// first goes through a shaper, a 65536-entry table indexed by the half bit pattern that maps the input
+// (e.g. scene-linear HDR) onto the [0, 1] LUT domain exactly for every half. the AVX2 kernel transposes
+// eight pixels into channel vectors, interpolates tetrahedrally (4 corners) or trilinearly (8 corners)
+// in fp32 and transposes back; alpha is copied through bit for bit. pixels run in parallel tiles.
+//
+#include "float16_t.hpp"
+#include "float16_t_parallel.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__) && defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+namespace numeric
+{
+    enum class lut_interpolation
+    {
+        tetrahedral,
+        trilinear
+    };
+
+    struct lut_options
+    {
+        lut_interpolation interpolation = lut_interpolation::tetrahedral;
+        std::size_t threads = 0;             // 0 means all hardware threads
+    };
+
+    namespace float16_t_private
+    {
+        constexpr inline std::size_t lut_tile = 4096;     // pixels per task
+
+    }//namespace float16_t_private
+
+    // per-channel map from input halves onto the [0, 1] LUT domain, NaN maps to 0
+    class lut_shaper
+    {
+    public:
+        // identity on [0, 1], inputs outside are clamped
+        lut_shaper() : lut_shaper{ []( float x ) { return x; } } {}
+
+        // fn( x ) for every half x, clamped to [0, 1]
+        template< typename Fn >
+        explicit lut_shaper( Fn const& fn ) : table_( 65536 )
+        {
+            float16_t_private::parallel_for( 0, 65536, 4096, [&]( std::size_t first, std::size_t last )
+            {
+                for ( std::size_t i = first; i != last; ++i )
+                {
+                    std::uint16_t const bits = static_cast<std::uint16_t>( i );
+                    float const y = float16_t_private::is_nan_bits( bits ) ? 0.0f : static_cast<float>( fn( float( float16_t{ bits } ) ) );
+                    table_[i] = y > 0.0f ? std::min( y, 1.0f ) : 0.0f;
+                }
+            } );
+        }
+
+        // [lo, hi] onto [0, 1]
+        static lut_shaper linear( float lo, float hi )
+        {
+            if ( !( hi > lo ) )
+                throw std::invalid_argument( "lut_shaper::linear: empty range" );
+            return lut_shaper{ [=]( float x ) { return ( x - lo ) / ( hi - lo ); } };
+        }
+
+        // log2( x / middle_grey ) from min_stops to max_stops onto [0, 1], the usual shaper for scene-linear HDR
+        static lut_shaper log2( float min_stops, float max_stops, float middle_grey = 0.18f )
+        {
+            if ( !( max_stops > min_stops ) || !( middle_grey > 0.0f ) )
+                throw std::invalid_argument( "lut_shaper::log2: empty range" );
+            return lut_shaper{ [=]( float x ) { return x > 0.0f ? ( std::log2( x / middle_grey ) - min_stops ) / ( max_stops - min_stops ) : 0.0f; } };
+        }
+
+        float operator()( float16_t x ) const noexcept { return table_[std::uint16_t( x )]; }
+
+        float const* data() const noexcept { return table_.data(); }
+
+    private:
+        std::vector<float> table_;
+    };
+
+    class lut3d
+    {
+    public:
+        //
+        // size^3 RGB triplets with red varying fastest, then green, then blue (the .cube order).
+        // values beyond the half range are saturated; throws std::invalid_argument on a size outside [2, 1024],
+        // a mismatched count or non-finite values
+        //
+        lut3d( std::size_t size, std::span<float const> rgb ) : size_{ size }
+        {
+            if ( size < 2 || size > 1024 )
+                throw std::invalid_argument( "lut3d: size must be in [2, 1024]" );
+            if ( rgb.size() != 3 * size * size * size )
+                throw std::invalid_argument( "lut3d: expected size^3 RGB triplets" );
+            entries_.resize( 4 * size * size * size );
+            for ( std::size_t i = 0, n = size * size * size; i != n; ++i )
+                for ( std::size_t c = 0; c != 3; ++c )
+                {
+                    float const v = rgb[3 * i + c];
+                    if ( !std::isfinite( v ) )
+                        throw std::invalid_argument( "lut3d: non-finite entry" );
+                    entries_[4 * i + c] = float16_t{ std::clamp( v, -65504.0f, 65504.0f ) };
+                }
+        }
+
+        // entries fn( r, g, b ) over the [0, 1]^3 grid, fn returning three floats
+        template< typename Fn >
+        static lut3d from_function( std::size_t size, Fn const& fn )
+        {
+            if ( size < 2 || size > 1024 )
+                throw std::invalid_argument( "lut3d: size must be in [2, 1024]" );
+            std::vector<float> rgb( 3 * size * size * size );
+            float const step = 1.0f / float( size - 1 );
+            for ( std::size_t b = 0, i = 0; b != size; ++b )
+                for ( std::size_t g = 0; g != size; ++g )
+                    for ( std::size_t r = 0; r != size; ++r, ++i )
+                    {
+                        std::array<float, 3> const v = fn( float( r ) * step, float( g ) * step, float( b ) * step );
+                        std::copy( v.begin(), v.end(), rgb.begin() + std::ptrdiff_t( 3 * i ) );
+                    }
+            return lut3d{ size, rgb };
+        }
+
+        static lut3d identity( std::size_t size )
+        {
+            return from_function( size, []( float r, float g, float b ) { return std::array<float, 3>{ r, g, b }; } );
+        }
+
+        std::size_t size() const noexcept { return size_; }
+        std::size_t bytes() const noexcept { return entries_.size() * sizeof( float16_t ); }
+
+        std::array<float, 3> entry( std::size_t r, std::size_t g, std::size_t b ) const noexcept
+        {
+            float16_t const* e = entries_.data() + 4 * ( ( b * size_ + g ) * size_ + r );
+            return { float( e[0] ), float( e[1] ), float( e[2] ) };
+        }
+
+        // RGB + padding per entry
+        float16_t const* data() const noexcept { return entries_.data(); }
+
+    private:
+        std::size_t size_;
+        std::vector<float16_t> entries_;
+    };
+
+    namespace float16_t_private
+    {
+        inline void lut_pixel( lut3d const& lut, lut_shaper const& shaper, lut_interpolation interpolation, float16_t const* in, float16_t* out ) noexcept
+        {
+            std::size_t const n = lut.size();
+            std::size_t const stride[3] = { 1, n, n * n };
+            float f[3];
+            std::size_t base = 0;
+            for ( int c = 0; c != 3; ++c )
+            {
+                float const x = shaper( in[c] ) * float( n - 1 );
+                std::size_t const i = std::min( static_cast<std::size_t>( x ), n - 2 );
+                f[c] = x - float( i );
+                base += i * stride[c];
+            }
+            auto const corner = [&]( std::size_t offset, int c ) { return float( lut.data()[4 * ( base + offset ) + c] ); };
+
+            float result[3] = {};
+            if ( interpolation == lut_interpolation::tetrahedral )
+            {
+                // order the fractions, the walk from the low corner steps along the largest first
+                int a = 0, b = 1, c = 2;
+                if ( f[a] < f[b] ) std::swap( a, b );
+                if ( f[b] < f[c] ) std::swap( b, c );
+                if ( f[a] < f[b] ) std::swap( a, b );
+                std::size_t const v1 = stride[a], v2 = v1 + stride[b], v3 = v2 + stride[c];
+                float const w0 = 1.0f - f[a], w1 = f[a] - f[b], w2 = f[b] - f[c], w3 = f[c];
+                for ( int k = 0; k != 3; ++k )
+                    result[k] = w0 * corner( 0, k ) + w1 * corner( v1, k ) + w2 * corner( v2, k ) + w3 * corner( v3, k );
+            }
+            else
+            {
+                for ( int z = 0; z != 2; ++z )
+                    for ( int y = 0; y != 2; ++y )
+                        for ( int x = 0; x != 2; ++x )
+                        {
+                            float const w = ( x ? f[0] : 1.0f - f[0] ) * ( y ? f[1] : 1.0f - f[1] ) * ( z ? f[2] : 1.0f - f[2] );
+                            std::size_t const offset = x * stride[0] + y * stride[1] + z * stride[2];
+                            for ( int k = 0; k != 3; ++k )
+                                result[k] += w * corner( offset, k );
+                        }
+            }
+            narrow( result, out, 3 ); // ties to even with F16C, like the vector path
+            out[3] = in[3];
+        }
+
+#if defined(__AVX2__) && defined(__F16C__)
+        // four registers of two interleaved 4-channel pixels each <-> four channel registers, lanes in pixel order 0 2 4 6 1 3 5 7
+        inline void lut_transpose( __m256& v0, __m256& v1, __m256& v2, __m256& v3 ) noexcept
+        {
+            __m256 const t0 = _mm256_unpacklo_ps( v0, v1 ), t1 = _mm256_unpackhi_ps( v0, v1 );
+            __m256 const t2 = _mm256_unpacklo_ps( v2, v3 ), t3 = _mm256_unpackhi_ps( v2, v3 );
+            v0 = _mm256_shuffle_ps( t0, t2, 0x44 );
+            v1 = _mm256_shuffle_ps( t0, t2, 0xee );
+            v2 = _mm256_shuffle_ps( t1, t3, 0x44 );
+            v3 = _mm256_shuffle_ps( t1, t3, 0xee );
+        }
+
+        inline void lut_untranspose( __m256& v0, __m256& v1, __m256& v2, __m256& v3 ) noexcept
+        {
+            __m256 const t0 = _mm256_unpacklo_ps( v0, v1 ), t1 = _mm256_unpacklo_ps( v2, v3 );
+            __m256 const t2 = _mm256_unpackhi_ps( v0, v1 ), t3 = _mm256_unpackhi_ps( v2, v3 );
+            v0 = _mm256_shuffle_ps( t0, t1, 0x44 );
+            v1 = _mm256_shuffle_ps( t0, t1, 0xee );
+            v2 = _mm256_shuffle_ps( t2, t3, 0x44 );
+            v3 = _mm256_shuffle_ps( t2, t3, 0xee );
+        }
+
+        // the three channels of eight entries at `index`
+        inline void lut_gather( float16_t const* entries, __m256i index, __m256 ( &rgb )[3] ) noexcept
+        {
+            // the low halves of the four 32-bit lanes to the low 8 bytes of each 128-bit lane, the high halves above them
+            __m256i const split = _mm256_setr_epi8( 0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15,
+                                                    0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15 );
+            __m256i const rg = _mm256_permute4x64_epi64( _mm256_shuffle_epi8( _mm256_i32gather_epi32( reinterpret_cast<int const*>( entries ), index, 8 ), split ), 0xd8 );
+            __m256i const bx = _mm256_permute4x64_epi64( _mm256_shuffle_epi8( _mm256_i32gather_epi32( reinterpret_cast<int const*>( entries + 2 ), index, 8 ), split ), 0xd8 );
+            rgb[0] = _mm256_cvtph_ps( _mm256_castsi256_si128( rg ) );
+            rgb[1] = _mm256_cvtph_ps( _mm256_extracti128_si256( rg, 1 ) );
+            rgb[2] = _mm256_cvtph_ps( _mm256_castsi256_si128( bx ) );
+        }
+
+        inline void lut_accumulate( __m256 ( &result )[3], __m256 w, __m256 const ( &corner )[3] ) noexcept
+        {
+            for ( int k = 0; k != 3; ++k )
+#if defined(__FMA__)
+                result[k] = _mm256_fmadd_ps( w, corner[k], result[k] );
+#else
+                result[k] = _mm256_add_ps( result[k], _mm256_mul_ps( w, corner[k] ) );
+#endif
+        }
+
+        // eight pixels from `in` to `out`
+        inline void lut_pixels8( lut3d const& lut, lut_shaper const& shaper, lut_interpolation interpolation, float16_t const* in, float16_t* out ) noexcept
+        {
+            int const n = static_cast<int>( lut.size() );
+
+            // zero-extended bit patterns, transposed to channels through the float shuffles
+            __m256 v[4];
+            for ( int p = 0; p != 4; ++p )
+                v[p] = _mm256_castsi256_ps( _mm256_cvtepu16_epi32( _mm_loadu_si128( reinterpret_cast<__m128i const*>( in + 8 * p ) ) ) );
+            lut_transpose( v[0], v[1], v[2], v[3] );
+
+            __m256 const scale = _mm256_set1_ps( float( n - 1 ) );
+            __m256i const top = _mm256_set1_epi32( n - 2 );
+            __m256 f[3];
+            __m256i base = _mm256_setzero_si256();
+            __m256i stride[3] = { _mm256_set1_epi32( 1 ), _mm256_set1_epi32( n ), _mm256_set1_epi32( n * n ) };
+            for ( int c = 0; c != 3; ++c )
+            {
+                __m256 const x = _mm256_mul_ps( _mm256_i32gather_ps( shaper.data(), _mm256_castps_si256( v[c] ), 4 ), scale );
+                __m256i const i = _mm256_min_epi32( _mm256_cvttps_epi32( x ), top );
+                f[c] = _mm256_sub_ps( x, _mm256_cvtepi32_ps( i ) );
+                base = _mm256_add_epi32( base, _mm256_mullo_epi32( i, stride[c] ) );
+            }
+
+            __m256 result[3] = { _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps() };
+            __m256 corner[3];
+            __m256 const one = _mm256_set1_ps( 1.0f );
+            if ( interpolation == lut_interpolation::tetrahedral )
+            {
+                // sorting network on ( fraction, stride ) pairs, largest fraction first
+                auto const order = [&]( int a, int b )
+                {
+                    __m256 const swap = _mm256_cmp_ps( f[a], f[b], _CMP_LT_OQ );
+                    __m256 const fa = _mm256_blendv_ps( f[a], f[b], swap ), fb = _mm256_blendv_ps( f[b], f[a], swap );
+                    __m256i const s = _mm256_castps_si256( swap );
+                    __m256i const sa = _mm256_blendv_epi8( stride[a], stride[b], s ), sb = _mm256_blendv_epi8( stride[b], stride[a], s );
+                    f[a] = fa; f[b] = fb; stride[a] = sa; stride[b] = sb;
+                };
+                order( 0, 1 );
+                order( 1, 2 );
+                order( 0, 1 );
+                __m256i const v1 = _mm256_add_epi32( base, stride[0] ), v2 = _mm256_add_epi32( v1, stride[1] ), v3 = _mm256_add_epi32( v2, stride[2] );
+                lut_gather( lut.data(), base, corner );
+                lut_accumulate( result, _mm256_sub_ps( one, f[0] ), corner );
+                lut_gather( lut.data(), v1, corner );
+                lut_accumulate( result, _mm256_sub_ps( f[0], f[1] ), corner );
+                lut_gather( lut.data(), v2, corner );
+                lut_accumulate( result, _mm256_sub_ps( f[1], f[2] ), corner );
+                lut_gather( lut.data(), v3, corner );
+                lut_accumulate( result, f[2], corner );
+            }
+            else
+            {
+                __m256 const g[3][2] = { { _mm256_sub_ps( one, f[0] ), f[0] }, { _mm256_sub_ps( one, f[1] ), f[1] }, { _mm256_sub_ps( one, f[2] ), f[2] } };
+                for ( int z = 0; z != 2; ++z )
+                    for ( int y = 0; y != 2; ++y )
+                    {
+                        __m256 const wyz = _mm256_mul_ps( g[1][y], g[2][z] );
+                        __m256i const row = _mm256_add_epi32( base, _mm256_set1_epi32( y * n + z * n * n ) );
+                        for ( int x = 0; x != 2; ++x )
+                        {
+                            lut_gather( lut.data(), _mm256_add_epi32( row, _mm256_set1_epi32( x ) ), corner );
+                            lut_accumulate( result, _mm256_mul_ps( g[0][x], wyz ), corner );
+                        }
+                    }
+            }
+
+            // narrowed and zero-extended again, the original alpha bits rejoin and everything is packed back
+            for ( int c = 0; c != 3; ++c )
+                v[c] = _mm256_castsi256_ps( _mm256_cvtepu16_epi32( _mm256_cvtps_ph( result[c], _MM_FROUND_TO_NEAREST_INT ) ) );
+            lut_untranspose( v[0], v[1], v[2], v[3] );
+            for ( int p = 0; p != 4; p += 2 )
+            {
+                __m256i const h = _mm256_packus_epi32( _mm256_castps_si256( v[p] ), _mm256_castps_si256( v[p + 1] ) );
+                _mm256_storeu_si256( reinterpret_cast<__m256i*>( out + 8 * p ), _mm256_permute4x64_epi64( h, 0xd8 ) );
+            }
+        }
+#endif
+
+    }//namespace float16_t_private
+
+    //
+    // out = lut( shaper( in ) ) for interleaved RGBA pixels, alpha copied; in and out may be the same span.
+    // throws std::invalid_argument when the sizes differ or are not a multiple of 4
+    //
+    inline void apply_lut( lut3d const& lut, lut_shaper const& shaper, std::span<float16_t const> in, std::span<float16_t> out,
+                           lut_options const& options = {} )
+    {
+        if ( in.size() != out.size() || in.size() % 4 )
+            throw std::invalid_argument( "apply_lut: expected equal sized RGBA spans" );
+        // tiles start at multiples of 8 pixels, so which pixels take the vector path does not depend on the thread count
+        std::size_t const pixels = in.size() / 4;
+        float16_t_private::parallel_for( 0, ( pixels + 7 ) / 8, float16_t_private::lut_tile / 8, [&]( std::size_t first, std::size_t last )
+        {
+            std::size_t p = 8 * first;
+            std::size_t const end = std::min( pixels, 8 * last );
+#if defined(__AVX2__) && defined(__F16C__)
+            for ( ; p + 8 <= end; p += 8 )
+                float16_t_private::lut_pixels8( lut, shaper, options.interpolation, in.data() + 4 * p, out.data() + 4 * p );
+#endif
+            for ( ; p != end; ++p )
+                float16_t_private::lut_pixel( lut, shaper, options.interpolation, in.data() + 4 * p, out.data() + 4 * p );
+        }, options.threads );
+    }
+
+    // with the identity shaper, RGB clamped to [0, 1]
+    inline void apply_lut( lut3d const& lut, std::span<float16_t const> in, std::span<float16_t> out, lut_options const& options = {} )
+    {
+        static lut_shaper const identity;
+        apply_lut( lut, identity, in, out, options );
+    }
+
+}//namespace numeric
+
+#endif
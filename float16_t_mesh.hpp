@@ -0,0 +1,318 @@
+#ifndef FLOAT16_T_MESH_HPP_INCLUDED_LKSDJF3094USDFLKJ3409SDFLKJ3094SDFLKJ0934SDF
+#define FLOAT16_T_MESH_HPP_INCLUDED_LKSDJF3094USDFLKJ3409SDFLKJ3094SDFLKJ0934SDF
+//
+// bulk vertex attribute codecs: chunk-relative half positions, octahedral normals and half uvs
+//
+// every encoder decodes its own output on the fly and reports the resulting error, the decoders are
+// single streaming passes meant for load time. attributes are interleaved (xyz xyz ... / uv uv ...).
+//
+#include "float16_t.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+
+namespace numeric
+{
+    struct codec_error
+    {
+        float max = 0.0f;   // largest error over all encoded values
+        float rms = 0.0f;   // root mean square error
+    };
+
+    namespace float16_t_private
+    {
+        // number of floats converted through the stack buffers at a time, a multiple of 2 and 3
+        constexpr inline std::size_t mesh_block = 768;
+
+        struct error_accumulator
+        {
+            float max = 0.0f;
+            double sum_sq = 0.0;
+            std::size_t count = 0;
+
+            void add( float const* err, std::size_t n ) noexcept
+            {
+                float mx = 0.0f;
+                float sq = 0.0f;
+                for ( std::size_t i = 0; i != n; ++i )
+                {
+                    mx = std::max( mx, err[i] );
+                    sq += err[i] * err[i];
+                }
+                max = std::max( max, mx );
+                sum_sq += sq;
+                count += n;
+            }
+
+            void add( float const* a, float const* b, std::size_t n ) noexcept
+            {
+                float err[mesh_block];
+                for ( std::size_t i = 0; i != n; ++i )
+                    err[i] = std::abs( a[i] - b[i] );
+                add( err, n );
+            }
+
+            codec_error result() const noexcept
+            {
+                return codec_error{ max, count ? static_cast<float>( std::sqrt( sum_sq / count ) ) : 0.0f };
+            }
+        };
+
+        inline float sign_not_zero( float x ) noexcept
+        {
+            return x >= 0.0f ? 1.0f : -1.0f;
+        }
+
+        // unit vector to the [-1, 1]^2 octahedral square
+        inline void oct_encode( float const* n, float* uv, std::size_t count ) noexcept
+        {
+            for ( std::size_t i = 0; i != count; ++i )
+            {
+                float const x = n[3*i], y = n[3*i+1], z = n[3*i+2];
+                float const inv_l1 = 1.0f / std::max( std::abs( x ) + std::abs( y ) + std::abs( z ), 1.0e-30f );
+                float const u = x * inv_l1;
+                float const v = y * inv_l1;
+                bool const lower = z < 0.0f;
+                uv[2*i]   = lower ? ( 1.0f - std::abs( v ) ) * sign_not_zero( u ) : u;
+                uv[2*i+1] = lower ? ( 1.0f - std::abs( u ) ) * sign_not_zero( v ) : v;
+            }
+        }
+
+        inline void oct_decode( float const* uv, float* n, std::size_t count ) noexcept
+        {
+            for ( std::size_t i = 0; i != count; ++i )
+            {
+                float const u = uv[2*i], v = uv[2*i+1];
+                float const z = 1.0f - std::abs( u ) - std::abs( v );
+                float const t = std::max( -z, 0.0f );
+                float const x = u - t * sign_not_zero( u );
+                float const y = v - t * sign_not_zero( v );
+                float const inv_len = 1.0f / std::sqrt( x * x + y * y + z * z );
+                n[3*i]   = x * inv_len;
+                n[3*i+1] = y * inv_len;
+                n[3*i+2] = z * inv_len;
+            }
+        }
+
+        // angle between the original and the decoded normal, in radians
+        inline void angular_error( float const* a, float const* b, float* err, std::size_t count ) noexcept
+        {
+            for ( std::size_t i = 0; i != count; ++i )
+            {
+                // atan2 of |a x b| and a . b stays accurate for the tiny angles acos would flush to zero
+                float const ax = a[3*i], ay = a[3*i+1], az = a[3*i+2];
+                float const bx = b[3*i], by = b[3*i+1], bz = b[3*i+2];
+                float const cx = ay * bz - az * by;
+                float const cy = az * bx - ax * bz;
+                float const cz = ax * by - ay * bx;
+                err[i] = std::atan2( std::sqrt( cx * cx + cy * cy + cz * cz ), ax * bx + ay * by + az * bz );
+            }
+        }
+
+    }//namespace float16_t_private
+
+    //
+    // positions are stored as half relative to the center of each chunk of `chunk_vertices` vertices,
+    // so precision follows the chunk extent rather than the distance from the mesh origin.
+    // `offsets` receives 3 floats per chunk. the reported error is the absolute per-component error.
+    //
+    inline codec_error encode_positions( std::span<float const> xyz, std::size_t chunk_vertices,
+                                         std::span<float16_t> out, std::span<float> offsets )
+    {
+        using float16_t_private::mesh_block;
+
+        if ( xyz.size() % 3 != 0 || out.size() != xyz.size() || chunk_vertices == 0 )
+            throw std::invalid_argument( "encode_positions: size mismatch" );
+        std::size_t const vertices = xyz.size() / 3;
+        std::size_t const chunks = ( vertices + chunk_vertices - 1 ) / chunk_vertices;
+        if ( offsets.size() != 3 * chunks )
+            throw std::invalid_argument( "encode_positions: offsets must hold 3 floats per chunk" );
+
+        float16_t_private::error_accumulator error;
+        float rel[mesh_block];
+        float back[mesh_block];
+        for ( std::size_t c = 0; c != chunks; ++c )
+        {
+            std::size_t const first = 3 * c * chunk_vertices;
+            std::size_t const last = 3 * std::min( vertices, ( c + 1 ) * chunk_vertices );
+
+            float lo[3] = { xyz[first], xyz[first+1], xyz[first+2] };
+            float hi[3] = { lo[0], lo[1], lo[2] };
+            for ( std::size_t i = first; i != last; i += 3 )
+                for ( int a = 0; a != 3; ++a )
+                {
+                    lo[a] = std::min( lo[a], xyz[i+a] );
+                    hi[a] = std::max( hi[a], xyz[i+a] );
+                }
+            float* const offset = offsets.data() + 3 * c;
+            for ( int a = 0; a != 3; ++a )
+                offset[a] = 0.5f * ( lo[a] + hi[a] );
+
+            for ( std::size_t b = first; b < last; b += mesh_block )
+            {
+                std::size_t const n = std::min( mesh_block, last - b );
+                for ( std::size_t i = 0; i != n; ++i )
+                    rel[i] = xyz[b+i] - offset[i % 3];
+                narrow( rel, out.data() + b, n );
+                widen( out.data() + b, back, n );
+                error.add( rel, back, n );
+            }
+        }
+        return error.result();
+    }
+
+    inline void decode_positions( std::span<float16_t const> in, std::size_t chunk_vertices,
+                                  std::span<float const> offsets, std::span<float> xyz )
+    {
+        if ( in.size() % 3 != 0 || xyz.size() != in.size() || chunk_vertices == 0 )
+            throw std::invalid_argument( "decode_positions: size mismatch" );
+        std::size_t const vertices = in.size() / 3;
+        std::size_t const chunks = ( vertices + chunk_vertices - 1 ) / chunk_vertices;
+        if ( offsets.size() != 3 * chunks )
+            throw std::invalid_argument( "decode_positions: offsets must hold 3 floats per chunk" );
+
+        widen( in.data(), xyz.data(), in.size() );
+        for ( std::size_t c = 0; c != chunks; ++c )
+        {
+            float const ox = offsets[3*c], oy = offsets[3*c+1], oz = offsets[3*c+2];
+            std::size_t const last = 3 * std::min( vertices, ( c + 1 ) * chunk_vertices );
+            for ( std::size_t i = 3 * c * chunk_vertices; i != last; i += 3 )
+            {
+                xyz[i]   += ox;
+                xyz[i+1] += oy;
+                xyz[i+2] += oz;
+            }
+        }
+    }
+
+    //
+    // unit normals to 2 components each, either as half or as snorm16 (value * 32767).
+    // the reported error is the angle in radians between the input and the decoded normal.
+    //
+    inline codec_error encode_normals( std::span<float const> xyz, std::span<float16_t> out )
+    {
+        using float16_t_private::mesh_block;
+
+        if ( xyz.size() % 3 != 0 || out.size() != xyz.size() / 3 * 2 )
+            throw std::invalid_argument( "encode_normals: output must hold 2 halves per normal" );
+
+        std::size_t const normals = xyz.size() / 3;
+        std::size_t const per_block = mesh_block / 3;
+        float16_t_private::error_accumulator error;
+        float uv[mesh_block];
+        float back[mesh_block];
+        float err[mesh_block];
+        for ( std::size_t b = 0; b < normals; b += per_block )
+        {
+            std::size_t const n = std::min( per_block, normals - b );
+            float16_t_private::oct_encode( xyz.data() + 3 * b, uv, n );
+            narrow( uv, out.data() + 2 * b, 2 * n );
+            widen( out.data() + 2 * b, uv, 2 * n );
+            float16_t_private::oct_decode( uv, back, n );
+            float16_t_private::angular_error( xyz.data() + 3 * b, back, err, n );
+            error.add( err, n );
+        }
+        return error.result();
+    }
+
+    inline codec_error encode_normals( std::span<float const> xyz, std::span<std::int16_t> out )
+    {
+        using float16_t_private::mesh_block;
+
+        if ( xyz.size() % 3 != 0 || out.size() != xyz.size() / 3 * 2 )
+            throw std::invalid_argument( "encode_normals: output must hold 2 snorm16 per normal" );
+
+        std::size_t const normals = xyz.size() / 3;
+        std::size_t const per_block = mesh_block / 3;
+        float16_t_private::error_accumulator error;
+        float uv[mesh_block];
+        float back[mesh_block];
+        float err[mesh_block];
+        for ( std::size_t b = 0; b < normals; b += per_block )
+        {
+            std::size_t const n = std::min( per_block, normals - b );
+            float16_t_private::oct_encode( xyz.data() + 3 * b, uv, n );
+            std::int16_t* const dst = out.data() + 2 * b;
+            for ( std::size_t i = 0; i != 2 * n; ++i )
+            {
+                dst[i] = static_cast<std::int16_t>( std::lrint( std::clamp( uv[i], -1.0f, 1.0f ) * 32767.0f ) );
+                uv[i] = dst[i] * ( 1.0f / 32767.0f );
+            }
+            float16_t_private::oct_decode( uv, back, n );
+            float16_t_private::angular_error( xyz.data() + 3 * b, back, err, n );
+            error.add( err, n );
+        }
+        return error.result();
+    }
+
+    inline void decode_normals( std::span<float16_t const> in, std::span<float> xyz )
+    {
+        using float16_t_private::mesh_block;
+
+        if ( in.size() % 2 != 0 || xyz.size() != in.size() / 2 * 3 )
+            throw std::invalid_argument( "decode_normals: output must hold 3 floats per normal" );
+
+        std::size_t const normals = in.size() / 2;
+        std::size_t const per_block = mesh_block / 2;
+        float uv[mesh_block];
+        for ( std::size_t b = 0; b < normals; b += per_block )
+        {
+            std::size_t const n = std::min( per_block, normals - b );
+            widen( in.data() + 2 * b, uv, 2 * n );
+            float16_t_private::oct_decode( uv, xyz.data() + 3 * b, n );
+        }
+    }
+
+    inline void decode_normals( std::span<std::int16_t const> in, std::span<float> xyz )
+    {
+        using float16_t_private::mesh_block;
+
+        if ( in.size() % 2 != 0 || xyz.size() != in.size() / 2 * 3 )
+            throw std::invalid_argument( "decode_normals: output must hold 3 floats per normal" );
+
+        std::size_t const normals = in.size() / 2;
+        std::size_t const per_block = mesh_block / 2;
+        float uv[mesh_block];
+        for ( std::size_t b = 0; b < normals; b += per_block )
+        {
+            std::size_t const n = std::min( per_block, normals - b );
+            for ( std::size_t i = 0; i != 2 * n; ++i )
+                uv[i] = in[2*b+i] * ( 1.0f / 32767.0f );
+            float16_t_private::oct_decode( uv, xyz.data() + 3 * b, n );
+        }
+    }
+
+    // texture coordinates straight to half, the reported error is the absolute per-component error
+    inline codec_error encode_uvs( std::span<float const> uv, std::span<float16_t> out )
+    {
+        using float16_t_private::mesh_block;
+
+        if ( out.size() != uv.size() )
+            throw std::invalid_argument( "encode_uvs: size mismatch" );
+
+        float16_t_private::error_accumulator error;
+        float back[mesh_block];
+        for ( std::size_t b = 0; b < uv.size(); b += mesh_block )
+        {
+            std::size_t const n = std::min( mesh_block, uv.size() - b );
+            narrow( uv.data() + b, out.data() + b, n );
+            widen( out.data() + b, back, n );
+            error.add( uv.data() + b, back, n );
+        }
+        return error.result();
+    }
+
+    inline void decode_uvs( std::span<float16_t const> in, std::span<float> uv )
+    {
+        if ( uv.size() != in.size() )
+            throw std::invalid_argument( "decode_uvs: size mismatch" );
+        widen( in.data(), uv.data(), in.size() );
+    }
+
+}//namespace numeric
+
+#endif
@@ -0,0 +1,238 @@
+#ifndef FLOAT16_T_NN_HPP_INCLUDED_LKJASDF98U34LKJSDFOIU3498USDFLKJ3498USDFLKJSDF
+#define FLOAT16_T_NN_HPP_INCLUDED_LKJASDF98U34LKJSDFOIU3498USDFLKJ3498USDFLKJSDF
+//
+// neural network kernels over float16_t storage, all accumulation is done in fp32
+//
+#include "float16_t.hpp"
+#include "float16_t_parallel.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <span>
+#include <stdexcept>
+
+namespace numeric
+{
+    namespace float16_t_private
+    {
+        // number of elements widened into a stack buffer at a time
+        constexpr inline std::size_t nn_chunk = 512;
+
+        // acc[0, n) += w * row[0, n)
+        inline void accumulate_row( float16_t const* row, float w, float* acc, std::size_t n ) noexcept
+        {
+            std::size_t i = 0;
+#if defined(__F16C__)
+            __m256 const vw = _mm256_set1_ps( w );
+            for ( ; i + 8 <= n; i += 8 )
+            {
+                __m256 const x = _mm256_cvtph_ps( _mm_loadu_si128( reinterpret_cast<__m128i const*>( row + i ) ) );
+#if defined(__FMA__)
+                _mm256_storeu_ps( acc + i, _mm256_fmadd_ps( x, vw, _mm256_loadu_ps( acc + i ) ) );
+#else
+                _mm256_storeu_ps( acc + i, _mm256_add_ps( _mm256_mul_ps( x, vw ), _mm256_loadu_ps( acc + i ) ) );
+#endif
+            }
+#endif
+            for ( ; i < n; ++i )
+                acc[i] += w * float( row[i] );
+        }
+
+        inline void prefetch_row( float16_t const* row, std::size_t n ) noexcept
+        {
+#ifdef __GNUC__
+            // one touch per 64 byte line over the whole row, starting from the line holding its first byte
+            std::uintptr_t const first = reinterpret_cast<std::uintptr_t>( row ) & ~std::uintptr_t( 63 );
+            std::uintptr_t const last = reinterpret_cast<std::uintptr_t>( row + n );
+            for ( std::uintptr_t line = first; line < last; line += 64 )
+                __builtin_prefetch( reinterpret_cast<char const*>( line ), 0, 1 );
+#else
+            (void)row;
+            (void)n;
+#endif
+        }
+
+    }//namespace float16_t_private
+
+    struct cross_entropy_options
+    {
+        float label_smoothing = 0.0f;       // eps, target is (1-eps) * one_hot + eps / classes
+        std::int64_t ignore_index = -100;   // rows with this label get zero loss and zero gradient
+        float grad_scale = 1.0f;            // multiplied into the gradient, e.g. 1/batch for a mean reduction
+        std::size_t threads = 0;            // 0 for hardware concurrency
+    };
+
+    //
+    // fused softmax + log + nll + backward over a row-major [rows x classes] logits matrix
+    //
+    // each row is streamed twice: an online max/sum-exp pass producing the loss, then a pass writing
+    // softmax(x) - target back as half. `grad` may alias `logits`.
+    // returns the number of rows whose label is not `ignore_index`.
+    //
+    inline std::size_t softmax_cross_entropy( std::span<float16_t const> logits, std::span<std::int64_t const> labels,
+                                              std::size_t classes, std::span<float> loss, std::span<float16_t> grad,
+                                              cross_entropy_options const& opt = {} )
+    {
+        using float16_t_private::nn_chunk;
+
+        if ( classes == 0 )
+            throw std::invalid_argument( "softmax_cross_entropy: classes must be positive" );
+        std::size_t const rows = labels.size();
+        if ( logits.size() != rows * classes || loss.size() != rows || grad.size() != rows * classes )
+            throw std::invalid_argument( "softmax_cross_entropy: size mismatch" );
+
+        float const eps = opt.label_smoothing;
+        float const off_target = eps / static_cast<float>( classes );
+
+        for ( auto label : labels )
+            if ( label != opt.ignore_index && ( label < 0 || static_cast<std::uint64_t>( label ) >= classes ) )
+                throw std::out_of_range( "softmax_cross_entropy: label out of range" );
+
+        std::size_t const grain = std::max<std::size_t>( 1, ( 1 << 14 ) / classes );
+        float16_t_private::parallel_for( 0, rows, grain, [&]( std::size_t r_begin, std::size_t r_end )
+        {
+            float buf[nn_chunk];
+
+            for ( std::size_t r = r_begin; r != r_end; ++r )
+            {
+                float16_t const* x = logits.data() + r * classes;
+                float16_t* g = grad.data() + r * classes;
+                std::int64_t const label = labels[r];
+
+                if ( label == opt.ignore_index )
+                {
+                    loss[r] = 0.0f;
+                    for ( std::size_t c = 0; c != classes; ++c )
+                        g[c] = fp16_zero;
+                    continue;
+                }
+
+                // pass 1: running max, rescaled sum of exponentials and plain sum (for label smoothing)
+                float mx = std::numeric_limits<float>::lowest();
+                float sum_exp = 0.0f;
+                float sum_x = 0.0f;
+                for ( std::size_t c = 0; c < classes; c += nn_chunk )
+                {
+                    std::size_t const n = std::min( nn_chunk, classes - c );
+                    widen( x + c, buf, n );
+
+                    float cmx = buf[0];
+                    for ( std::size_t i = 1; i < n; ++i )
+                        cmx = std::max( cmx, buf[i] );
+                    if ( cmx > mx )
+                    {
+                        sum_exp *= std::exp( mx - cmx );
+                        mx = cmx;
+                    }
+
+                    float s = 0.0f;
+                    float sx = 0.0f;
+                    for ( std::size_t i = 0; i < n; ++i )
+                    {
+                        s += std::exp( buf[i] - mx );
+                        sx += buf[i];
+                    }
+                    sum_exp += s;
+                    sum_x += sx;
+                }
+
+                float const lse = mx + std::log( sum_exp );
+                float const x_label = float( x[label] );
+                loss[r] = lse - ( 1.0f - eps ) * x_label - off_target * sum_x;
+
+                // pass 2: gradient softmax(x) - target
+                float const scale = opt.grad_scale;
+                for ( std::size_t c = 0; c < classes; c += nn_chunk )
+                {
+                    std::size_t const n = std::min( nn_chunk, classes - c );
+                    widen( x + c, buf, n );
+                    for ( std::size_t i = 0; i < n; ++i )
+                        buf[i] = ( std::exp( buf[i] - lse ) - off_target ) * scale;
+                    std::size_t const l = static_cast<std::size_t>( label );
+                    if ( l >= c && l < c + n )
+                        buf[l - c] -= ( 1.0f - eps ) * scale;
+                    narrow( buf, g + c, n );
+                }
+            }
+        }, opt.threads );
+
+        std::size_t valid = 0;
+        for ( auto label : labels )
+            valid += ( label != opt.ignore_index );
+        return valid;
+    }
+
+    enum class embedding_bag_mode
+    {
+        sum,
+        mean
+    };
+
+    //
+    // gathers rows of a row-major [rows x dim] half table and pools them per bag into fp32
+    //
+    // bag b covers indices[offsets[b], offsets[b+1]), the last bag runs to the end of `indices`; offsets[0] must be 0.
+    // `weights`, when not empty, holds one weight per index (weighted sum, or weighted mean
+    // normalized by the bag size). empty bags produce zeros. `out` is [offsets.size() x dim].
+    //
+    inline void embedding_bag( std::span<float16_t const> table, std::size_t dim,
+                               std::span<std::int64_t const> indices, std::span<std::int64_t const> offsets,
+                               embedding_bag_mode mode, std::span<float> out,
+                               std::span<float const> weights = {}, std::size_t threads = 0 )
+    {
+        if ( dim == 0 || table.size() % dim != 0 )
+            throw std::invalid_argument( "embedding_bag: table size is not a multiple of dim" );
+        std::size_t const table_rows = table.size() / dim;
+        std::size_t const bags = offsets.size();
+        if ( out.size() != bags * dim )
+            throw std::invalid_argument( "embedding_bag: output size mismatch" );
+        if ( !weights.empty() && weights.size() != indices.size() )
+            throw std::invalid_argument( "embedding_bag: weights size mismatch" );
+        if ( bags != 0 && offsets[0] != 0 )
+            throw std::invalid_argument( "embedding_bag: offsets[0] must be 0" );
+        for ( std::size_t b = 0; b != bags; ++b )
+        {
+            std::int64_t const end = b + 1 == bags ? static_cast<std::int64_t>( indices.size() ) : offsets[b+1];
+            if ( offsets[b] < 0 || offsets[b] > end || static_cast<std::size_t>( end ) > indices.size() )
+                throw std::invalid_argument( "embedding_bag: offsets must be non-decreasing and within indices" );
+        }
+        for ( auto idx : indices )
+            if ( idx < 0 || static_cast<std::size_t>( idx ) >= table_rows )
+                throw std::out_of_range( "embedding_bag: index out of range" );
+
+        // rows are fetched this many lookups ahead of their use
+        constexpr std::size_t prefetch_distance = 8;
+
+        float16_t_private::parallel_for( 0, bags, 64, [&]( std::size_t b_begin, std::size_t b_end )
+        {
+            for ( std::size_t b = b_begin; b != b_end; ++b )
+            {
+                std::size_t const first = static_cast<std::size_t>( offsets[b] );
+                std::size_t const last = b + 1 == bags ? indices.size() : static_cast<std::size_t>( offsets[b+1] );
+                float* acc = out.data() + b * dim;
+                std::fill( acc, acc + dim, 0.0f );
+
+                for ( std::size_t k = first; k != last; ++k )
+                {
+                    if ( k + prefetch_distance < indices.size() )
+                        float16_t_private::prefetch_row( table.data() + indices[k+prefetch_distance] * dim, dim );
+                    float const w = weights.empty() ? 1.0f : weights[k];
+                    float16_t_private::accumulate_row( table.data() + indices[k] * dim, w, acc, dim );
+                }
+
+                if ( mode == embedding_bag_mode::mean && last > first )
+                {
+                    float const inv = 1.0f / static_cast<float>( last - first );
+                    for ( std::size_t d = 0; d != dim; ++d )
+                        acc[d] *= inv;
+                }
+            }
+        }, threads );
+    }
+
+}//namespace numeric
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef FLOAT16_T_PARALLEL_HPP_INCLUDED_DSFKJ3LKJSDF09UASDLKJ3409USDFLKJ34OIUSDF
+#define FLOAT16_T_PARALLEL_HPP_INCLUDED_DSFKJ3LKJSDF09UASDLKJ3409USDFLKJ34OIUSDF
+//
+// minimal fork-join helper shared by the bulk kernels
+//
+#include <cstddef>
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace numeric
+{
+    namespace float16_t_private
+    {
+        inline std::size_t hardware_threads() noexcept
+        {
+            std::size_t const n = std::thread::hardware_concurrency();
+            return n ? n : 1;
+        }
+
+        // splits [first, last) into contiguous ranges of at least `grain` items and calls func( begin, end ) on each
+        // the calling thread takes the first range; exceptions thrown by any range are rethrown here
+        template< typename Func >
+        void parallel_for( std::size_t first, std::size_t last, std::size_t grain, Func const& func, std::size_t threads = 0 )
+        {
+            if ( last <= first ) return;
+            std::size_t const n = last - first;
+            grain = std::max<std::size_t>( grain, 1 );
+            std::size_t const max_threads = threads ? threads : hardware_threads();
+            std::size_t const workers = std::min( max_threads, ( n + grain - 1 ) / grain );
+
+            if ( workers <= 1 )
+            {
+                func( first, last );
+                return;
+            }
+
+            std::size_t const step = ( n + workers - 1 ) / workers;
+            std::vector<std::exception_ptr> errors( workers );
+            std::vector<std::thread> pool;
+            pool.reserve( workers - 1 );
+
+            auto const run = [&]( std::size_t w )
+            {
+                std::size_t const b = first + w * step;
+                std::size_t const e = std::min( last, b + step );
+                if ( b >= e ) return;
+                try { func( b, e ); }
+                catch ( ... ) { errors[w] = std::current_exception(); }
+            };
+
+            for ( std::size_t w = 1; w < workers; ++w )
+                pool.emplace_back( run, w );
+            run( 0 );
+
+            for ( auto& t : pool )
+                t.join();
+
+            for ( auto& e : errors )
+                if ( e ) std::rethrow_exception( e );
+        }
+
+    }//namespace float16_t_private
+
+}//namespace numeric
+
+#endif
@@ -0,0 +1,712 @@
+#ifndef FLOAT16_T_PARQUET_HPP_INCLUDED_LKSDJF0934USDFLKJ3049USDFLKJ3409USDFLKJSD
+#define FLOAT16_T_PARQUET_HPP_INCLUDED_LKSDJF0934USDFLKJ3049USDFLKJ3409USDFLKJSD
+//
+// self-contained parquet files holding a single required FLOAT16 column (FIXED_LEN_BYTE_ARRAY(2), little-endian)
+// https://github.com/apache/parquet-format
+//
+// the writer emits one row group with one uncompressed column chunk made of v1 data pages in PLAIN or
+// BYTE_STREAM_SPLIT encoding, each carrying min/max statistics. pages are flushed as they fill up and
+// read back one at a time, so memory stays bounded by the page size whatever the column length.
+//
+#include "float16_t.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace numeric
+{
+    enum class parquet_encoding : std::int32_t
+    {
+        plain = 0,
+        byte_stream_split = 9
+    };
+
+    struct parquet_page_info
+    {
+        std::size_t values = 0;
+        std::optional<float16_t> min;   // absent when the page only holds NaNs (or no statistics were written)
+        std::optional<float16_t> max;
+    };
+
+    namespace float16_t_private
+    {
+        // thrift compact protocol, only what parquet metadata needs
+        enum thrift_type : std::uint8_t
+        {
+            thrift_true = 1, thrift_false = 2, thrift_byte = 3, thrift_i16 = 4, thrift_i32 = 5, thrift_i64 = 6,
+            thrift_double = 7, thrift_binary = 8, thrift_list = 9, thrift_set = 10, thrift_map = 11, thrift_struct = 12
+        };
+
+        class thrift_writer
+        {
+        public:
+            std::string out;
+
+            void i32( std::int16_t id, std::int32_t v ) { field( id, thrift_i32 ); zigzag( v ); }
+            void i64( std::int16_t id, std::int64_t v ) { field( id, thrift_i64 ); zigzag( v ); }
+            void boolean( std::int16_t id, bool v ) { field( id, v ? thrift_true : thrift_false ); }
+
+            void binary( std::int16_t id, std::string_view v )
+            {
+                field( id, thrift_binary );
+                string( v );
+            }
+
+            void begin_struct( std::int16_t id ) { field( id, thrift_struct ); push(); }
+            void end_struct() { stop(); }
+
+            void begin_list( std::int16_t id, thrift_type element, std::size_t size )
+            {
+                field( id, thrift_list );
+                if ( size < 15 )
+                    out += static_cast<char>( ( size << 4 ) | element );
+                else
+                {
+                    out += static_cast<char>( 0xf0 | element );
+                    varint( size );
+                }
+            }
+
+            // struct elements of a list have no field header
+            void begin_element() { push(); }
+            void end_element() { stop(); }
+
+            void string( std::string_view v )
+            {
+                varint( v.size() );
+                out.append( v.data(), v.size() );
+            }
+
+            void i32_element( std::int32_t v ) { zigzag( v ); }
+
+            // terminates the outermost struct
+            void finish() { out += '\0'; }
+
+        private:
+            void field( std::int16_t id, std::uint8_t type )
+            {
+                std::int16_t const delta = id - last_;
+                if ( delta > 0 && delta <= 15 )
+                    out += static_cast<char>( ( delta << 4 ) | type );
+                else
+                {
+                    out += static_cast<char>( type );
+                    zigzag( id );
+                }
+                last_ = id;
+            }
+
+            void push() { stack_.push_back( last_ ); last_ = 0; }
+            void stop() { out += '\0'; last_ = stack_.back(); stack_.pop_back(); }
+
+            void varint( std::uint64_t v )
+            {
+                while ( v >= 0x80 )
+                {
+                    out += static_cast<char>( ( v & 0x7f ) | 0x80 );
+                    v >>= 7;
+                }
+                out += static_cast<char>( v );
+            }
+
+            void zigzag( std::int64_t v ) { varint( ( static_cast<std::uint64_t>( v ) << 1 ) ^ static_cast<std::uint64_t>( v >> 63 ) ); }
+
+            std::int16_t last_ = 0;
+            std::vector<std::int16_t> stack_;
+        };
+
+        class thrift_reader
+        {
+        public:
+            thrift_reader( std::uint8_t const* p, std::size_t n ) : p_{ p }, end_{ p + n }, begin_{ p } { }
+
+            std::size_t consumed() const noexcept { return static_cast<std::size_t>( p_ - begin_ ); }
+
+            // calls on_field( id, type ) for every field; the callback reads the value or calls skip( type )
+            template< typename Func >
+            void read_struct( Func const& on_field )
+            {
+                std::int16_t last = 0;
+                for ( ;; )
+                {
+                    std::uint8_t const b = byte();
+                    if ( b == 0 ) return;
+                    std::uint8_t const type = b & 0x0f;
+                    std::int16_t const delta = b >> 4;
+                    std::int16_t const id = delta ? static_cast<std::int16_t>( last + delta ) : static_cast<std::int16_t>( zigzag() );
+                    last = id;
+                    on_field( id, type );
+                }
+            }
+
+            // returns the element count, the element type goes to `element`
+            std::size_t list_header( std::uint8_t& element )
+            {
+                std::uint8_t const b = byte();
+                element = b & 0x0f;
+                std::size_t const size = b >> 4;
+                return size == 15 ? static_cast<std::size_t>( varint() ) : size;
+            }
+
+            std::int64_t integer() { return zigzag(); }
+
+            std::string_view binary()
+            {
+                std::size_t const n = static_cast<std::size_t>( varint() );
+                need( n );
+                std::string_view const v{ reinterpret_cast<char const*>( p_ ), n };
+                p_ += n;
+                return v;
+            }
+
+            void skip( std::uint8_t type, bool in_list = false )
+            {
+                switch ( type )
+                {
+                    case thrift_true:
+                    case thrift_false: if ( in_list ) byte(); return;
+                    case thrift_byte: byte(); return;
+                    case thrift_i16:
+                    case thrift_i32:
+                    case thrift_i64: varint(); return;
+                    case thrift_double: need( 8 ); p_ += 8; return;
+                    case thrift_binary: binary(); return;
+                    case thrift_list:
+                    case thrift_set:
+                    {
+                        std::uint8_t element;
+                        std::size_t const n = list_header( element );
+                        for ( std::size_t i = 0; i != n; ++i ) skip( element, true );
+                        return;
+                    }
+                    case thrift_map:
+                    {
+                        std::size_t const n = static_cast<std::size_t>( varint() );
+                        if ( n == 0 ) return;
+                        std::uint8_t const kv = byte();
+                        for ( std::size_t i = 0; i != n; ++i ) { skip( kv >> 4, true ); skip( kv & 0x0f, true ); }
+                        return;
+                    }
+                    case thrift_struct: read_struct( [&]( std::int16_t, std::uint8_t t ) { skip( t ); } ); return;
+                    default: throw std::runtime_error( "parquet: corrupt thrift data" );
+                }
+            }
+
+        private:
+            void need( std::size_t n ) const
+            {
+                if ( static_cast<std::size_t>( end_ - p_ ) < n )
+                    throw std::runtime_error( "parquet: truncated thrift data" );
+            }
+
+            std::uint8_t byte() { need( 1 ); return *p_++; }
+
+            std::uint64_t varint()
+            {
+                std::uint64_t v = 0;
+                for ( int shift = 0; shift < 64; shift += 7 )
+                {
+                    std::uint8_t const b = byte();
+                    v |= std::uint64_t( b & 0x7f ) << shift;
+                    if ( !( b & 0x80 ) ) return v;
+                }
+                throw std::runtime_error( "parquet: varint too long" );
+            }
+
+            std::int64_t zigzag()
+            {
+                std::uint64_t const v = varint();
+                return static_cast<std::int64_t>( ( v >> 1 ) ^ ( ~( v & 1 ) + 1 ) );
+            }
+
+            std::uint8_t const* p_;
+            std::uint8_t const* end_;
+            std::uint8_t const* begin_;
+        };
+
+        // parquet float statistics: NaNs are left out, a zero minimum is written as -0 and a zero maximum as +0
+        struct parquet_min_max
+        {
+            std::uint16_t min_key = 0xffff;
+            std::uint16_t max_key = 0;
+            bool any = false;
+
+            void add( std::span<float16_t const> values ) noexcept
+            {
+                std::uint16_t lo = min_key, hi = max_key;
+                bool seen = false;
+                for ( auto v : values )
+                {
+                    if ( is_nan_bits( std::uint16_t( v ) ) ) continue;
+                    std::uint16_t const k = order_key( v );
+                    lo = std::min( lo, k );
+                    hi = std::max( hi, k );
+                    seen = true;
+                }
+                if ( !seen ) return;
+                min_key = lo;
+                max_key = hi;
+                any = true;
+            }
+
+            void add( parquet_min_max const& other ) noexcept
+            {
+                if ( !other.any ) return;
+                min_key = std::min( min_key, other.min_key );
+                max_key = std::max( max_key, other.max_key );
+                any = true;
+            }
+
+            float16_t min() const noexcept
+            {
+                float16_t const m = from_order_key( min_key );
+                return ( std::uint16_t( m ) & 0x7fff ) == 0 ? fp16_zero_negative : m;
+            }
+
+            float16_t max() const noexcept
+            {
+                float16_t const m = from_order_key( max_key );
+                return ( std::uint16_t( m ) & 0x7fff ) == 0 ? fp16_zero : m;
+            }
+        };
+
+        inline std::string parquet_le16( float16_t v )
+        {
+            std::uint16_t const b = std::uint16_t( v );
+            return std::string{ static_cast<char>( b & 0xff ), static_cast<char>( b >> 8 ) };
+        }
+
+        inline float16_t parquet_read_le16( std::string_view s )
+        {
+            if ( s.size() != 2 ) throw std::runtime_error( "parquet: FLOAT16 statistic is not 2 bytes" );
+            return float16_t{ static_cast<std::uint16_t>( static_cast<std::uint8_t>( s[0] ) | ( static_cast<std::uint8_t>( s[1] ) << 8 ) ) };
+        }
+
+        inline void parquet_statistics( thrift_writer& w, std::int16_t id, parquet_min_max const& mm )
+        {
+            w.begin_struct( id );
+            w.i64( 3, 0 ); // null_count
+            if ( mm.any )
+            {
+                w.binary( 5, parquet_le16( mm.max() ) );
+                w.binary( 6, parquet_le16( mm.min() ) );
+            }
+            w.end_struct();
+        }
+
+        inline void parquet_read_statistics( thrift_reader& r, parquet_page_info& info )
+        {
+            r.read_struct( [&]( std::int16_t id, std::uint8_t type )
+            {
+                if ( id == 5 && type == thrift_binary ) info.max = parquet_read_le16( r.binary() );
+                else if ( id == 6 && type == thrift_binary ) info.min = parquet_read_le16( r.binary() );
+                else r.skip( type );
+            } );
+        }
+
+        constexpr inline char const parquet_magic[4] = { 'P', 'A', 'R', '1' };
+        constexpr inline std::int32_t parquet_fixed_len_byte_array = 7;
+        constexpr inline std::int32_t parquet_rle = 3;
+
+    }//namespace float16_t_private
+
+    class parquet_float16_writer
+    {
+    public:
+        parquet_float16_writer( std::string const& path, std::string column, parquet_encoding encoding = parquet_encoding::plain,
+                                std::size_t page_values = 1 << 16 )
+            : out_{ path, std::ios::binary | std::ios::trunc }, column_{ std::move( column ) }, encoding_{ encoding },
+              page_values_{ std::max<std::size_t>( page_values, 1 ) }
+        {
+            if ( !out_ )
+                throw std::runtime_error( "parquet: cannot create " + path );
+            if ( page_values_ > ( std::size_t{ 1 } << 29 ) )
+                throw std::invalid_argument( "parquet: page too large" );
+            page_.reserve( page_values_ );
+            out_.write( float16_t_private::parquet_magic, 4 );
+            offset_ = 4;
+        }
+
+        void write( std::span<float16_t const> values )
+        {
+            while ( !values.empty() )
+            {
+                std::size_t const n = std::min( values.size(), page_values_ - page_.size() );
+                page_.insert( page_.end(), values.begin(), values.begin() + n );
+                values = values.subspan( n );
+                if ( page_.size() == page_values_ )
+                    flush_page();
+            }
+        }
+
+        // writes the last page and the footer
+        void close()
+        {
+            if ( !page_.empty() || pages_ == 0 )
+                flush_page();
+
+            using float16_t_private::thrift_binary;
+            using float16_t_private::thrift_i32;
+            using float16_t_private::thrift_struct;
+            float16_t_private::thrift_writer w;
+            w.i32( 1, 2 ); // version
+            w.begin_list( 2, thrift_struct, 2 );
+            {
+                w.begin_element();
+                w.binary( 4, "schema" );
+                w.i32( 5, 1 );
+                w.end_element();
+
+                w.begin_element();
+                w.i32( 1, float16_t_private::parquet_fixed_len_byte_array );
+                w.i32( 2, 2 );
+                w.i32( 3, 0 ); // REQUIRED
+                w.binary( 4, column_ );
+                w.begin_struct( 10 );
+                w.begin_struct( 15 ); // FLOAT16
+                w.end_struct();
+                w.end_struct();
+                w.end_element();
+            }
+            w.i64( 3, static_cast<std::int64_t>( rows_ ) );
+            w.begin_list( 4, thrift_struct, 1 );
+            {
+                w.begin_element();
+                w.begin_list( 1, thrift_struct, 1 );
+                {
+                    w.begin_element();
+                    w.i64( 2, static_cast<std::int64_t>( offset_ ) );
+                    w.begin_struct( 3 );
+                    w.i32( 1, float16_t_private::parquet_fixed_len_byte_array );
+                    w.begin_list( 2, thrift_i32, 1 );
+                    w.i32_element( static_cast<std::int32_t>( encoding_ ) );
+                    w.begin_list( 3, thrift_binary, 1 );
+                    w.string( column_ );
+                    w.i32( 4, 0 ); // UNCOMPRESSED
+                    w.i64( 5, static_cast<std::int64_t>( rows_ ) );
+                    w.i64( 6, static_cast<std::int64_t>( offset_ - 4 ) );
+                    w.i64( 7, static_cast<std::int64_t>( offset_ - 4 ) );
+                    w.i64( 9, 4 ); // data_page_offset
+                    float16_t_private::parquet_statistics( w, 12, chunk_stats_ );
+                    w.end_struct();
+                    w.end_element();
+                }
+                w.i64( 2, static_cast<std::int64_t>( offset_ - 4 ) );
+                w.i64( 3, static_cast<std::int64_t>( rows_ ) );
+                w.end_element();
+            }
+            w.binary( 6, "float16_t version " + std::to_string( version ) );
+            w.begin_list( 7, thrift_struct, 1 );
+            w.begin_element();
+            w.begin_struct( 1 ); // TypeDefinedOrder
+            w.end_struct();
+            w.end_element();
+            w.finish();
+
+            std::uint32_t const n = static_cast<std::uint32_t>( w.out.size() );
+            char const len[4] = { static_cast<char>( n ), static_cast<char>( n >> 8 ), static_cast<char>( n >> 16 ), static_cast<char>( n >> 24 ) };
+            out_.write( w.out.data(), static_cast<std::streamsize>( w.out.size() ) );
+            out_.write( len, 4 );
+            out_.write( float16_t_private::parquet_magic, 4 );
+            out_.close();
+            if ( !out_ )
+                throw std::runtime_error( "parquet: write failed" );
+        }
+
+    private:
+        void flush_page()
+        {
+            std::size_t const n = page_.size();
+            body_.resize( 2 * n );
+            if ( encoding_ == parquet_encoding::byte_stream_split )
+            {
+                // all low bytes, then all high bytes
+                for ( std::size_t i = 0; i != n; ++i )
+                {
+                    std::uint16_t const b = std::uint16_t( page_[i] );
+                    body_[i] = static_cast<char>( b & 0xff );
+                    body_[n+i] = static_cast<char>( b >> 8 );
+                }
+            }
+            else
+            {
+                for ( std::size_t i = 0; i != n; ++i )
+                {
+                    std::uint16_t const b = std::uint16_t( page_[i] );
+                    body_[2*i] = static_cast<char>( b & 0xff );
+                    body_[2*i+1] = static_cast<char>( b >> 8 );
+                }
+            }
+
+            float16_t_private::parquet_min_max stats;
+            stats.add( page_ );
+            chunk_stats_.add( stats );
+
+            float16_t_private::thrift_writer w;
+            w.i32( 1, 0 ); // DATA_PAGE
+            w.i32( 2, static_cast<std::int32_t>( body_.size() ) );
+            w.i32( 3, static_cast<std::int32_t>( body_.size() ) );
+            w.begin_struct( 5 );
+            w.i32( 1, static_cast<std::int32_t>( n ) );
+            w.i32( 2, static_cast<std::int32_t>( encoding_ ) );
+            w.i32( 3, float16_t_private::parquet_rle );
+            w.i32( 4, float16_t_private::parquet_rle );
+            float16_t_private::parquet_statistics( w, 5, stats );
+            w.end_struct();
+            w.finish();
+
+            out_.write( w.out.data(), static_cast<std::streamsize>( w.out.size() ) );
+            out_.write( body_.data(), static_cast<std::streamsize>( body_.size() ) );
+            if ( !out_ )
+                throw std::runtime_error( "parquet: write failed" );
+            offset_ += w.out.size() + body_.size();
+            rows_ += n;
+            ++pages_;
+            page_.clear();
+        }
+
+        std::ofstream out_;
+        std::string column_;
+        parquet_encoding encoding_;
+        std::size_t page_values_;
+        std::vector<float16_t> page_;
+        std::string body_;
+        float16_t_private::parquet_min_max chunk_stats_;
+        std::uint64_t offset_ = 0;
+        std::uint64_t rows_ = 0;
+        std::size_t pages_ = 0;
+    };
+
+    //
+    // reads the footer on construction, then returns the column one page at a time.
+    // any number of row groups is accepted; columns must be uncompressed, required FLOAT16 (or FLBA(2)).
+    //
+    class parquet_float16_reader
+    {
+    public:
+        explicit parquet_float16_reader( std::string const& path ) : in_{ path, std::ios::binary }
+        {
+            if ( !in_ )
+                throw std::runtime_error( "parquet: cannot open " + path );
+            in_.seekg( 0, std::ios::end );
+            std::uint64_t const size = static_cast<std::uint64_t>( in_.tellg() );
+            if ( size < 12 )
+                throw std::runtime_error( "parquet: file too small" );
+
+            char tail[8];
+            read_at( size - 8, tail, 8 );
+            if ( std::memcmp( tail + 4, float16_t_private::parquet_magic, 4 ) != 0 )
+                throw std::runtime_error( "parquet: missing magic" );
+            std::uint32_t const n = static_cast<std::uint8_t>( tail[0] ) | ( static_cast<std::uint8_t>( tail[1] ) << 8 ) |
+                                    ( static_cast<std::uint8_t>( tail[2] ) << 16 ) | ( std::uint32_t( static_cast<std::uint8_t>( tail[3] ) ) << 24 );
+            if ( n > size - 12 )
+                throw std::runtime_error( "parquet: footer larger than the file" );
+            std::vector<std::uint8_t> footer( n );
+            read_at( size - 8 - n, footer.data(), n );
+            parse_footer( footer );
+        }
+
+        std::string const& column() const noexcept { return column_; }
+        std::uint64_t rows() const noexcept { return rows_; }
+
+        //
+        // decodes the next data page into `out` (resized to the page) and returns its statistics,
+        // std::nullopt once the column is exhausted
+        //
+        std::optional<parquet_page_info> read_page( std::vector<float16_t>& out )
+        {
+            using namespace float16_t_private;
+
+            while ( chunk_ != chunks_.size() && chunk_remaining_ == 0 )
+                if ( ++chunk_ != chunks_.size() )
+                    start_chunk();
+            if ( chunk_ == chunks_.size() )
+                return std::nullopt;
+
+            std::uint8_t head[4096];
+            std::size_t const head_size = static_cast<std::size_t>( std::min<std::uint64_t>( sizeof( head ), file_end_ - position_ ) );
+            read_at( position_, head, head_size );
+            thrift_reader r{ head, head_size };
+
+            std::int32_t type = -1;
+            std::int32_t compressed = 0;
+            std::int32_t encoding = 0;
+            std::int32_t levels_bytes = 0;
+            parquet_page_info info;
+            r.read_struct( [&]( std::int16_t id, std::uint8_t t )
+            {
+                if ( id == 1 && t == thrift_i32 ) type = static_cast<std::int32_t>( r.integer() );
+                else if ( id == 3 && t == thrift_i32 ) compressed = static_cast<std::int32_t>( r.integer() );
+                else if ( ( id == 5 || id == 8 ) && t == thrift_struct )
+                {
+                    // DataPageHeader (v1) and DataPageHeaderV2 share num_values at 1 and encoding at 2 (v1) / 4 (v2)
+                    bool const v2 = id == 8;
+                    r.read_struct( [&]( std::int16_t fid, std::uint8_t ft )
+                    {
+                        if ( fid == 1 && ft == thrift_i32 ) info.values = static_cast<std::size_t>( r.integer() );
+                        else if ( fid == ( v2 ? 4 : 2 ) && ft == thrift_i32 ) encoding = static_cast<std::int32_t>( r.integer() );
+                        else if ( v2 && ( fid == 5 || fid == 6 ) && ft == thrift_i32 ) levels_bytes += static_cast<std::int32_t>( r.integer() );
+                        else if ( fid == ( v2 ? 8 : 5 ) && ft == thrift_struct ) parquet_read_statistics( r, info );
+                        else r.skip( ft );
+                    } );
+                }
+                else r.skip( t );
+            } );
+
+            if ( type != 0 && type != 3 )
+                throw std::runtime_error( "parquet: only data pages are supported (no dictionary or index pages)" );
+            if ( compressed < 0 || static_cast<std::uint64_t>( compressed ) > file_end_ - position_ - r.consumed() ||
+                 static_cast<std::size_t>( compressed ) != 2 * info.values + static_cast<std::size_t>( levels_bytes ) )
+                throw std::runtime_error( "parquet: page size does not match its value count" );
+
+            body_.resize( 2 * info.values );
+            read_at( position_ + r.consumed() + static_cast<std::uint64_t>( levels_bytes ), body_.data(), body_.size() );
+            position_ += r.consumed() + static_cast<std::uint64_t>( compressed );
+            chunk_remaining_ -= std::min<std::uint64_t>( chunk_remaining_, info.values );
+
+            std::size_t const n = info.values;
+            out.resize( n );
+            if ( encoding == static_cast<std::int32_t>( parquet_encoding::byte_stream_split ) )
+                for ( std::size_t i = 0; i != n; ++i )
+                    out[i] = float16_t{ static_cast<std::uint16_t>( static_cast<std::uint8_t>( body_[i] ) | ( static_cast<std::uint8_t>( body_[n+i] ) << 8 ) ) };
+            else if ( encoding == static_cast<std::int32_t>( parquet_encoding::plain ) )
+                for ( std::size_t i = 0; i != n; ++i )
+                    out[i] = float16_t{ static_cast<std::uint16_t>( static_cast<std::uint8_t>( body_[2*i] ) | ( static_cast<std::uint8_t>( body_[2*i+1] ) << 8 ) ) };
+            else
+                throw std::runtime_error( "parquet: unsupported encoding " + std::to_string( encoding ) );
+            return info;
+        }
+
+    private:
+        struct chunk_info
+        {
+            std::uint64_t offset = 0;
+            std::uint64_t size = 0;
+            std::uint64_t values = 0;
+        };
+
+        void read_at( std::uint64_t pos, void* dst, std::size_t n )
+        {
+            in_.clear();
+            in_.seekg( static_cast<std::streamoff>( pos ) );
+            in_.read( static_cast<char*>( dst ), static_cast<std::streamsize>( n ) );
+            if ( static_cast<std::size_t>( in_.gcount() ) != n )
+                throw std::runtime_error( "parquet: unexpected end of file" );
+        }
+
+        void start_chunk()
+        {
+            position_ = chunks_[chunk_].offset;
+            file_end_ = chunks_[chunk_].offset + chunks_[chunk_].size;
+            chunk_remaining_ = chunks_[chunk_].values;
+        }
+
+        void parse_footer( std::vector<std::uint8_t> const& footer )
+        {
+            using namespace float16_t_private;
+            thrift_reader r{ footer.data(), footer.size() };
+
+            std::size_t leaves = 0;
+            r.read_struct( [&]( std::int16_t id, std::uint8_t type )
+            {
+                if ( id == 2 && type == thrift_list )
+                {
+                    std::uint8_t element;
+                    std::size_t const n = r.list_header( element );
+                    for ( std::size_t i = 0; i != n; ++i )
+                    {
+                        std::int32_t physical = -1, length = 0, repetition = 0, children = 0;
+                        std::string name;
+                        r.read_struct( [&]( std::int16_t fid, std::uint8_t ft )
+                        {
+                            if ( fid == 1 && ft == thrift_i32 ) physical = static_cast<std::int32_t>( r.integer() );
+                            else if ( fid == 2 && ft == thrift_i32 ) length = static_cast<std::int32_t>( r.integer() );
+                            else if ( fid == 3 && ft == thrift_i32 ) repetition = static_cast<std::int32_t>( r.integer() );
+                            else if ( fid == 4 && ft == thrift_binary ) name = std::string{ r.binary() };
+                            else if ( fid == 5 && ft == thrift_i32 ) children = static_cast<std::int32_t>( r.integer() );
+                            else r.skip( ft );
+                        } );
+                        if ( i == 0 || children > 0 )
+                            continue;
+                        ++leaves;
+                        if ( physical != parquet_fixed_len_byte_array || length != 2 )
+                            throw std::runtime_error( "parquet: column " + name + " is not FIXED_LEN_BYTE_ARRAY(2)" );
+                        if ( repetition != 0 )
+                            throw std::runtime_error( "parquet: column " + name + " is not REQUIRED" );
+                        column_ = name;
+                    }
+                }
+                else if ( id == 3 && type == thrift_i64 )
+                    rows_ = static_cast<std::uint64_t>( r.integer() );
+                else if ( id == 4 && type == thrift_list )
+                {
+                    std::uint8_t element;
+                    std::size_t const groups = r.list_header( element );
+                    for ( std::size_t g = 0; g != groups; ++g )
+                        r.read_struct( [&]( std::int16_t gid, std::uint8_t gt )
+                        {
+                            if ( gid != 1 || gt != thrift_list ) { r.skip( gt ); return; }
+                            std::size_t const columns = r.list_header( element );
+                            for ( std::size_t c = 0; c != columns; ++c )
+                                r.read_struct( [&]( std::int16_t cid, std::uint8_t ct )
+                                {
+                                    if ( cid != 3 || ct != thrift_struct ) { r.skip( ct ); return; }
+                                    parse_column_meta( r );
+                                } );
+                        } );
+                }
+                else
+                    r.skip( type );
+            } );
+
+            if ( leaves != 1 )
+                throw std::runtime_error( "parquet: expected exactly one column" );
+            if ( !chunks_.empty() )
+                start_chunk();
+        }
+
+        void parse_column_meta( float16_t_private::thrift_reader& r )
+        {
+            using namespace float16_t_private;
+            chunk_info chunk;
+            std::int64_t codec = 0;
+            std::int64_t dictionary_offset = -1;
+            r.read_struct( [&]( std::int16_t id, std::uint8_t type )
+            {
+                if ( id == 4 && type == thrift_i32 ) codec = r.integer();
+                else if ( id == 5 && type == thrift_i64 ) chunk.values = static_cast<std::uint64_t>( r.integer() );
+                else if ( id == 7 && type == thrift_i64 ) chunk.size = static_cast<std::uint64_t>( r.integer() );
+                else if ( id == 9 && type == thrift_i64 ) chunk.offset = static_cast<std::uint64_t>( r.integer() );
+                else if ( id == 11 && type == thrift_i64 ) dictionary_offset = r.integer();
+                else r.skip( type );
+            } );
+            if ( codec != 0 )
+                throw std::runtime_error( "parquet: compressed column chunks are not supported" );
+            if ( dictionary_offset >= 0 )
+                throw std::runtime_error( "parquet: dictionary encoded column chunks are not supported" );
+            chunks_.push_back( chunk );
+        }
+
+        std::ifstream in_;
+        std::string column_;
+        std::uint64_t rows_ = 0;
+        std::vector<chunk_info> chunks_;
+        std::size_t chunk_ = 0;
+        std::uint64_t position_ = 0;
+        std::uint64_t file_end_ = 0;
+        std::uint64_t chunk_remaining_ = 0;
+        std::vector<char> body_;
+    };
+
+}//namespace numeric
+
+#endif
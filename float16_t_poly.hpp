@@ -0,0 +1,324 @@
+#ifndef FLOAT16_T_POLY_HPP_INCLUDED_SDLFKJ3094USDLKFJ3049USDFLKJ3049USDLFKJ0394U
+#define FLOAT16_T_POLY_HPP_INCLUDED_SDLFKJ3094USDLKFJ3049USDFLKJ3049USDLFKJ0394U
+//
+// batched polynomial evaluation on float16_t inputs in fp32.
+//   polyval: c[0] + c[1] x + ... + c[n-1] x^(n-1) (ascending order), by Horner's rule or Estrin's scheme
+//   chebval: c[0] T0(t) + c[1] T1(t) + ... by the Clenshaw recurrence, [lo, hi] mapped onto t in [-1, 1]
+// inputs are widened in chunks and evaluated in blocks of poly_lanes elements, the loops over a block are what
+// the compiler vectorizes. std::array coefficients fix the degree at compile time and unroll the evaluation
+// completely. half outputs round to infinity on overflow. large inputs are split across threads.
+//
+#include "float16_t.hpp"
+#include "float16_t_parallel.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace numeric
+{
+    enum class poly_scheme
+    {
+        horner,      // n - 1 dependent multiply-adds; with a runtime degree the fastest, a block has plenty of independent lanes
+        estrin       // pairs combined with x^2, x^4, ..., a log2( n ) deep dependency chain, for the compile-time degrees
+    };
+
+    struct poly_options
+    {
+        poly_scheme scheme = poly_scheme::horner;
+        std::size_t threads = 0;             // 0 means all hardware threads
+    };
+
+    namespace float16_t_private
+    {
+        constexpr inline std::size_t poly_lanes = 64;                       // elements evaluated together, enough to hide the FMA latency
+        constexpr inline std::size_t poly_chunk = 1024;                     // elements widened at a time
+        constexpr inline std::size_t poly_grain = std::size_t( 1 ) << 16;   // elements per task
+
+        //
+        // widens chunks of `in`, lets eval( x, y, count ) fill y from x with count rounded up to whole blocks (so every
+        // element takes the same code path) and stores y to `out`. make_eval() builds one evaluator per task
+        //
+        template< typename Out, typename MakeEval >
+        void poly_drive( std::span<float16_t const> in, std::span<Out> out, std::size_t threads, MakeEval const& make_eval )
+        {
+            static_assert( std::is_same_v<Out, float16_t> || std::is_same_v<Out, float>, "outputs must be float16_t or float" );
+            if ( in.size() != out.size() )
+                throw std::invalid_argument( "polyval: input and output sizes differ" );
+            parallel_for( 0, in.size(), poly_grain, [&]( std::size_t first, std::size_t last )
+            {
+                auto eval = make_eval();
+                alignas( 64 ) float x[poly_chunk] = {};
+                alignas( 64 ) float y[poly_chunk];
+                alignas( 64 ) float16_t h[poly_chunk];
+                for ( std::size_t i = first; i < last; i += poly_chunk )
+                {
+                    std::size_t const n = std::min( poly_chunk, last - i );
+                    std::size_t const count = ( n + poly_lanes - 1 ) / poly_lanes * poly_lanes;
+                    widen( in.data() + i, x, n );
+                    eval( x, y, count );
+                    if constexpr ( std::is_same_v<Out, float> )
+                        std::copy( y, y + n, out.data() + i );
+                    else
+                    {
+                        // +-65520 narrows to infinity, larger values would not convert reliably
+                        for ( std::size_t j = 0; j != count; ++j ) y[j] = std::clamp( y[j], -65520.0f, 65520.0f );
+                        narrow( y, h, count );
+                        std::copy( h, h + n, out.data() + i );
+                    }
+                }
+            }, threads );
+        }
+
+        inline void horner_blocks( std::span<float const> c, float const* x, float* y, std::size_t count ) noexcept
+        {
+            std::size_t const n = c.size();
+            for ( std::size_t b = 0; b != count; b += poly_lanes )
+            {
+                float acc[poly_lanes];
+                for ( std::size_t j = 0; j != poly_lanes; ++j ) acc[j] = c[n - 1];
+                for ( std::size_t k = n - 1; k-- > 0; )
+                    for ( std::size_t j = 0; j != poly_lanes; ++j ) acc[j] = acc[j] * x[b + j] + c[k];
+                std::copy( acc, acc + poly_lanes, y + b );
+            }
+        }
+
+        // terms holds ( c.size() + 1 ) / 2 blocks
+        inline void estrin_blocks( std::span<float const> c, float const* x, float* y, std::size_t count, float* terms ) noexcept
+        {
+            std::size_t const n = c.size();
+            for ( std::size_t b = 0; b != count; b += poly_lanes )
+            {
+                float const* xb = x + b;
+                std::size_t m = ( n + 1 ) / 2;
+                for ( std::size_t k = 0; k != m; ++k )
+                {
+                    float* t = terms + k * poly_lanes;
+                    float const lo = c[2 * k];
+                    if ( 2 * k + 1 == n )
+                        std::fill( t, t + poly_lanes, lo );
+                    else
+                        for ( std::size_t j = 0; j != poly_lanes; ++j ) t[j] = lo + c[2 * k + 1] * xb[j];
+                }
+                float power[poly_lanes];
+                for ( std::size_t j = 0; j != poly_lanes; ++j ) power[j] = xb[j] * xb[j];
+                for ( ; m > 1; m = ( m + 1 ) / 2 )
+                {
+                    for ( std::size_t k = 0; k != m / 2; ++k )
+                    {
+                        float* t = terms + k * poly_lanes;
+                        float const* lo = terms + 2 * k * poly_lanes;
+                        float const* hi = lo + poly_lanes;
+                        for ( std::size_t j = 0; j != poly_lanes; ++j ) t[j] = lo[j] + hi[j] * power[j];
+                    }
+                    if ( m % 2 )
+                        std::copy( terms + ( m - 1 ) * poly_lanes, terms + m * poly_lanes, terms + m / 2 * poly_lanes );
+                    for ( std::size_t j = 0; j != poly_lanes; ++j ) power[j] *= power[j];
+                }
+                std::copy( terms, terms + poly_lanes, y + b );
+            }
+        }
+
+        // t = scale * x + offset
+        inline void clenshaw_blocks( std::span<float const> c, float scale, float offset, float const* x, float* y, std::size_t count ) noexcept
+        {
+            std::size_t const n = c.size();
+            for ( std::size_t b = 0; b != count; b += poly_lanes )
+            {
+                float t[poly_lanes], b1[poly_lanes] = {}, b2[poly_lanes] = {};
+                for ( std::size_t j = 0; j != poly_lanes; ++j ) t[j] = scale * x[b + j] + offset;
+                for ( std::size_t k = n - 1; k > 0; --k )
+                    for ( std::size_t j = 0; j != poly_lanes; ++j )
+                    {
+                        float const b0 = c[k] + 2.0f * t[j] * b1[j] - b2[j];
+                        b2[j] = b1[j];
+                        b1[j] = b0;
+                    }
+                for ( std::size_t j = 0; j != poly_lanes; ++j ) y[b + j] = c[0] + t[j] * b1[j] - b2[j];
+            }
+        }
+
+        template< std::size_t N, std::size_t I = 0 >
+        inline float horner_fixed( std::array<float, N> const& c, float x ) noexcept
+        {
+            if constexpr ( I + 1 == N )
+                return c[I];
+            else
+                return c[I] + x * horner_fixed<N, I + 1>( c, x );
+        }
+
+        // c[First, First + Count), split at the largest power of two below Count; power[k] is x^(2^k)
+        template< std::size_t N, std::size_t First, std::size_t Count >
+        inline float estrin_fixed( std::array<float, N> const& c, float const* power ) noexcept
+        {
+            if constexpr ( Count == 1 )
+                return c[First];
+            else
+            {
+                constexpr std::size_t low = std::bit_floor( Count - 1 );
+                return estrin_fixed<N, First, low>( c, power ) + power[std::bit_width( low ) - 1] * estrin_fixed<N, First + low, Count - low>( c, power );
+            }
+        }
+
+        template< std::size_t N >
+        inline float estrin_fixed( std::array<float, N> const& c, float x ) noexcept
+        {
+            constexpr std::size_t levels = N > 1 ? std::bit_width( N - 1 ) : 1;
+            float power[levels];
+            power[0] = x;
+            for ( std::size_t k = 1; k != levels; ++k ) power[k] = power[k - 1] * power[k - 1];
+            return estrin_fixed<N, 0, N>( c, power );
+        }
+
+        // b_k = c_k + 2 t b_(k+1) - b_(k+2), down to k = 1
+        template< std::size_t N, std::size_t K >
+        inline void clenshaw_fixed( std::array<float, N> const& c, float t, float& b1, float& b2 ) noexcept
+        {
+            if constexpr ( K > 0 )
+            {
+                float const b0 = c[K] + 2.0f * t * b1 - b2;
+                b2 = b1;
+                b1 = b0;
+                clenshaw_fixed<N, K - 1>( c, t, b1, b2 );
+            }
+        }
+
+        template< std::size_t N >
+        inline float clenshaw_fixed( std::array<float, N> const& c, float t ) noexcept
+        {
+            float b1 = 0.0f, b2 = 0.0f;
+            clenshaw_fixed<N, N - 1>( c, t, b1, b2 );
+            return c[0] + t * b1 - b2;
+        }
+
+        inline void check_interval( float lo, float hi )
+        {
+            if ( !( hi > lo ) )
+                throw std::invalid_argument( "chebval: empty interval" );
+        }
+
+        template< typename Out >
+        void polyval( std::span<float const> c, std::span<float16_t const> in, std::span<Out> out, poly_options const& options )
+        {
+            if ( c.empty() )
+            {
+                poly_drive( in, out, options.threads, [] { return []( float const*, float* y, std::size_t count ) { std::fill( y, y + count, 0.0f ); }; } );
+                return;
+            }
+            if ( options.scheme == poly_scheme::estrin )
+                poly_drive( in, out, options.threads, [&]
+                {
+                    return [&, terms = std::vector<float>( ( c.size() + 1 ) / 2 * poly_lanes )]( float const* x, float* y, std::size_t count ) mutable
+                    {
+                        estrin_blocks( c, x, y, count, terms.data() );
+                    };
+                } );
+            else
+                poly_drive( in, out, options.threads, [&] { return [&]( float const* x, float* y, std::size_t count ) { horner_blocks( c, x, y, count ); }; } );
+        }
+
+        template< std::size_t N, typename Out >
+        void polyval( std::array<float, N> const& c, std::span<float16_t const> in, std::span<Out> out, poly_options const& options )
+        {
+            static_assert( N > 0, "at least one coefficient" );
+            if ( options.scheme == poly_scheme::estrin )
+                poly_drive( in, out, options.threads, [&] { return [&]( float const* x, float* y, std::size_t count )
+                {
+                    for ( std::size_t j = 0; j != count; ++j ) y[j] = estrin_fixed( c, x[j] );
+                }; } );
+            else
+                poly_drive( in, out, options.threads, [&] { return [&]( float const* x, float* y, std::size_t count )
+                {
+                    for ( std::size_t j = 0; j != count; ++j ) y[j] = horner_fixed( c, x[j] );
+                }; } );
+        }
+
+        template< typename Out >
+        void chebval( std::span<float const> c, std::span<float16_t const> in, std::span<Out> out, float lo, float hi, std::size_t threads )
+        {
+            check_interval( lo, hi );
+            float const scale = 2.0f / ( hi - lo ), offset = -( lo + hi ) / ( hi - lo );
+            if ( c.empty() )
+                poly_drive( in, out, threads, [] { return []( float const*, float* y, std::size_t count ) { std::fill( y, y + count, 0.0f ); }; } );
+            else
+                poly_drive( in, out, threads, [&] { return [&]( float const* x, float* y, std::size_t count ) { clenshaw_blocks( c, scale, offset, x, y, count ); }; } );
+        }
+
+        template< std::size_t N, typename Out >
+        void chebval( std::array<float, N> const& c, std::span<float16_t const> in, std::span<Out> out, float lo, float hi, std::size_t threads )
+        {
+            static_assert( N > 0, "at least one coefficient" );
+            check_interval( lo, hi );
+            float const scale = 2.0f / ( hi - lo ), offset = -( lo + hi ) / ( hi - lo );
+            poly_drive( in, out, threads, [&] { return [&]( float const* x, float* y, std::size_t count )
+            {
+                for ( std::size_t j = 0; j != count; ++j ) y[j] = clenshaw_fixed( c, scale * x[j] + offset );
+            }; } );
+        }
+
+    }//namespace float16_t_private
+
+    //
+    // out[i] = sum of coeffs[k] * in[i]^k; throws std::invalid_argument when the sizes of in and out differ
+    //
+    inline void polyval( std::span<float const> coeffs, std::span<float16_t const> in, std::span<float16_t> out, poly_options const& options = {} )
+    {
+        float16_t_private::polyval( coeffs, in, out, options );
+    }
+
+    inline void polyval( std::span<float const> coeffs, std::span<float16_t const> in, std::span<float> out, poly_options const& options = {} )
+    {
+        float16_t_private::polyval( coeffs, in, out, options );
+    }
+
+    // the degree fixed at compile time
+    template< std::size_t N >
+    void polyval( std::array<float, N> const& coeffs, std::span<float16_t const> in, std::span<float16_t> out, poly_options const& options = {} )
+    {
+        float16_t_private::polyval( coeffs, in, out, options );
+    }
+
+    template< std::size_t N >
+    void polyval( std::array<float, N> const& coeffs, std::span<float16_t const> in, std::span<float> out, poly_options const& options = {} )
+    {
+        float16_t_private::polyval( coeffs, in, out, options );
+    }
+
+    //
+    // out[i] = sum of coeffs[k] * T_k( t ) with t = ( 2 in[i] - lo - hi ) / ( hi - lo ); throws std::invalid_argument
+    // when the sizes differ or hi <= lo
+    //
+    inline void chebval( std::span<float const> coeffs, std::span<float16_t const> in, std::span<float16_t> out,
+                         float lo = -1.0f, float hi = 1.0f, std::size_t threads = 0 )
+    {
+        float16_t_private::chebval( coeffs, in, out, lo, hi, threads );
+    }
+
+    inline void chebval( std::span<float const> coeffs, std::span<float16_t const> in, std::span<float> out,
+                         float lo = -1.0f, float hi = 1.0f, std::size_t threads = 0 )
+    {
+        float16_t_private::chebval( coeffs, in, out, lo, hi, threads );
+    }
+
+    template< std::size_t N >
+    void chebval( std::array<float, N> const& coeffs, std::span<float16_t const> in, std::span<float16_t> out,
+                  float lo = -1.0f, float hi = 1.0f, std::size_t threads = 0 )
+    {
+        float16_t_private::chebval( coeffs, in, out, lo, hi, threads );
+    }
+
+    template< std::size_t N >
+    void chebval( std::array<float, N> const& coeffs, std::span<float16_t const> in, std::span<float> out,
+                  float lo = -1.0f, float hi = 1.0f, std::size_t threads = 0 )
+    {
+        float16_t_private::chebval( coeffs, in, out, lo, hi, threads );
+    }
+
+}//namespace numeric
+
+#endif
@@ -0,0 +1,268 @@
+#ifndef FLOAT16_T_RING_HPP_INCLUDED_SDLKFJ0394USDFLKJ3049USDFLKJ3049USDLFKJSDF
+#define FLOAT16_T_RING_HPP_INCLUDED_SDLKFJ0394USDFLKJ3049USDFLKJ3049USDLFKJSDF
+//
+// bounded lock-free rings of fixed-size float16_t blocks for producer/consumer pipelines.
+// all block storage is allocated up front (64-byte aligned, one slot per block), pushes and pops copy
+// whole blocks in and out, and the batch calls move several blocks per index update.
+//   spsc_block_ring: one producer thread, one consumer thread
+//   mpmc_block_ring: any number of both, per-slot sequence numbers in the style of D. Vyukov's bounded queue
+//
+#include "float16_t.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <thread>
+
+namespace numeric
+{
+    namespace float16_t_private
+    {
+        constexpr inline std::size_t ring_cache_line = 64;
+
+        struct ring_free
+        {
+            void operator()( float16_t* p ) const noexcept { ::operator delete[]( p, std::align_val_t{ ring_cache_line } ); }
+        };
+
+        // capacity blocks of block_size halves, every block starting on its own cache line
+        class ring_storage
+        {
+        public:
+            ring_storage( std::size_t block_size, std::size_t capacity )
+            {
+                if ( block_size == 0 || capacity == 0 )
+                    throw std::invalid_argument( "block ring: block size and capacity must be positive" );
+                block_size_ = block_size;
+                stride_ = ( block_size * sizeof( float16_t ) + ring_cache_line - 1 ) / ring_cache_line * ring_cache_line / sizeof( float16_t );
+                capacity_ = std::bit_ceil( capacity );
+                data_.reset( static_cast<float16_t*>( ::operator new[]( capacity_ * stride_ * sizeof( float16_t ), std::align_val_t{ ring_cache_line } ) ) );
+            }
+
+            std::size_t block_size() const noexcept { return block_size_; }
+            std::size_t capacity() const noexcept { return capacity_; }
+            float16_t* slot( std::size_t position ) const noexcept { return data_.get() + ( position & ( capacity_ - 1 ) ) * stride_; }
+
+            void check( std::size_t size ) const
+            {
+                if ( size % block_size_ )
+                    throw std::invalid_argument( "block ring: span is not a whole number of blocks" );
+            }
+
+        private:
+            std::size_t block_size_ = 0;
+            std::size_t stride_ = 0;
+            std::size_t capacity_ = 0;
+            std::unique_ptr<float16_t[], ring_free> data_;
+        };
+
+        // spin briefly, then give the core away
+        inline void ring_backoff( unsigned& spins ) noexcept
+        {
+            if ( ++spins < 64 ) return;
+            std::this_thread::yield();
+        }
+
+    }//namespace float16_t_private
+
+    class spsc_block_ring
+    {
+    public:
+        // capacity is rounded up to a power of two
+        spsc_block_ring( std::size_t block_size, std::size_t capacity ) : storage_{ block_size, capacity } { }
+
+        spsc_block_ring( spsc_block_ring const& ) = delete;
+        spsc_block_ring& operator = ( spsc_block_ring const& ) = delete;
+
+        std::size_t block_size() const noexcept { return storage_.block_size(); }
+        std::size_t capacity() const noexcept { return storage_.capacity(); }
+
+        // producer side: copies as many leading blocks of `blocks` as fit and returns how many
+        std::size_t try_push( std::span<float16_t const> blocks )
+        {
+            storage_.check( blocks.size() );
+            std::size_t const wanted = blocks.size() / storage_.block_size();
+            std::size_t const tail = tail_.load( std::memory_order_relaxed );
+            if ( tail + wanted - cached_head_ > storage_.capacity() )
+                cached_head_ = head_.load( std::memory_order_acquire );
+            std::size_t const n = std::min( wanted, storage_.capacity() - ( tail - cached_head_ ) );
+            for ( std::size_t i = 0; i != n; ++i )
+                std::memcpy( storage_.slot( tail + i ), blocks.data() + i * storage_.block_size(), storage_.block_size() * sizeof( float16_t ) );
+            if ( n )
+                tail_.store( tail + n, std::memory_order_release );
+            return n;
+        }
+
+        // consumer side: fills up to blocks.size() / block_size() blocks and returns how many
+        std::size_t try_pop( std::span<float16_t> blocks )
+        {
+            storage_.check( blocks.size() );
+            std::size_t const wanted = blocks.size() / storage_.block_size();
+            std::size_t const head = head_.load( std::memory_order_relaxed );
+            if ( cached_tail_ - head < wanted )
+                cached_tail_ = tail_.load( std::memory_order_acquire );
+            std::size_t const n = std::min( wanted, cached_tail_ - head );
+            for ( std::size_t i = 0; i != n; ++i )
+                std::memcpy( blocks.data() + i * storage_.block_size(), storage_.slot( head + i ), storage_.block_size() * sizeof( float16_t ) );
+            if ( n )
+                head_.store( head + n, std::memory_order_release );
+            return n;
+        }
+
+        // blocking forms, spinning then yielding until every block went through
+        void push( std::span<float16_t const> blocks )
+        {
+            for ( unsigned spins = 0; !blocks.empty(); float16_t_private::ring_backoff( spins ) )
+                blocks = blocks.subspan( try_push( blocks ) * storage_.block_size() );
+        }
+
+        void pop( std::span<float16_t> blocks )
+        {
+            for ( unsigned spins = 0; !blocks.empty(); float16_t_private::ring_backoff( spins ) )
+                blocks = blocks.subspan( try_pop( blocks ) * storage_.block_size() );
+        }
+
+    private:
+        float16_t_private::ring_storage storage_;
+        // each index shares its line only with the copy of the other index its owner caches
+        alignas( float16_t_private::ring_cache_line ) std::atomic<std::size_t> tail_{ 0 };
+        std::size_t cached_head_ = 0;
+        alignas( float16_t_private::ring_cache_line ) std::atomic<std::size_t> head_{ 0 };
+        std::size_t cached_tail_ = 0;
+    };
+
+    class mpmc_block_ring
+    {
+    public:
+        // capacity is rounded up to a power of two
+        mpmc_block_ring( std::size_t block_size, std::size_t capacity )
+            : storage_{ block_size, capacity }, sequence_{ new sequence_slot[storage_.capacity()] }
+        {
+            for ( std::size_t i = 0; i != storage_.capacity(); ++i )
+                sequence_[i].value.store( i, std::memory_order_relaxed );
+        }
+
+        mpmc_block_ring( mpmc_block_ring const& ) = delete;
+        mpmc_block_ring& operator = ( mpmc_block_ring const& ) = delete;
+
+        std::size_t block_size() const noexcept { return storage_.block_size(); }
+        std::size_t capacity() const noexcept { return storage_.capacity(); }
+
+        //
+        // claims the longest run of free slots (up to the number of blocks given) with a single CAS,
+        // copies the leading blocks in and returns how many were pushed
+        //
+        std::size_t try_push( std::span<float16_t const> blocks )
+        {
+            storage_.check( blocks.size() );
+            std::size_t const wanted = blocks.size() / storage_.block_size();
+            if ( wanted == 0 ) return 0;
+
+            std::size_t position = enqueue_.load( std::memory_order_relaxed );
+            std::size_t n = 0;
+            for ( ;; )
+            {
+                n = ready( position, wanted, 0 );
+                if ( n == 0 )
+                {
+                    // the first slot is either still being consumed (full) or already claimed by another producer
+                    std::size_t const seq = slot( position ).load( std::memory_order_acquire );
+                    if ( seq < position ) return 0;
+                    position = enqueue_.load( std::memory_order_relaxed );
+                    continue;
+                }
+                if ( enqueue_.compare_exchange_weak( position, position + n, std::memory_order_relaxed ) )
+                    break;
+            }
+
+            for ( std::size_t i = 0; i != n; ++i )
+            {
+                std::memcpy( storage_.slot( position + i ), blocks.data() + i * storage_.block_size(), storage_.block_size() * sizeof( float16_t ) );
+                slot( position + i ).store( position + i + 1, std::memory_order_release );
+            }
+            return n;
+        }
+
+        // claims the longest run of filled slots, copies them out and returns how many were popped
+        std::size_t try_pop( std::span<float16_t> blocks )
+        {
+            storage_.check( blocks.size() );
+            std::size_t const wanted = blocks.size() / storage_.block_size();
+            if ( wanted == 0 ) return 0;
+
+            std::size_t position = dequeue_.load( std::memory_order_relaxed );
+            std::size_t n = 0;
+            for ( ;; )
+            {
+                n = ready( position, wanted, 1 );
+                if ( n == 0 )
+                {
+                    std::size_t const seq = slot( position ).load( std::memory_order_acquire );
+                    if ( seq < position + 1 ) return 0;
+                    position = dequeue_.load( std::memory_order_relaxed );
+                    continue;
+                }
+                if ( dequeue_.compare_exchange_weak( position, position + n, std::memory_order_relaxed ) )
+                    break;
+            }
+
+            for ( std::size_t i = 0; i != n; ++i )
+            {
+                std::memcpy( blocks.data() + i * storage_.block_size(), storage_.slot( position + i ), storage_.block_size() * sizeof( float16_t ) );
+                slot( position + i ).store( position + i + storage_.capacity(), std::memory_order_release );
+            }
+            return n;
+        }
+
+        void push( std::span<float16_t const> blocks )
+        {
+            for ( unsigned spins = 0; !blocks.empty(); float16_t_private::ring_backoff( spins ) )
+                blocks = blocks.subspan( try_push( blocks ) * storage_.block_size() );
+        }
+
+        void pop( std::span<float16_t> blocks )
+        {
+            for ( unsigned spins = 0; !blocks.empty(); float16_t_private::ring_backoff( spins ) )
+                blocks = blocks.subspan( try_pop( blocks ) * storage_.block_size() );
+        }
+
+    private:
+        struct sequence_slot
+        {
+            alignas( float16_t_private::ring_cache_line ) std::atomic<std::size_t> value;
+        };
+
+        std::atomic<std::size_t>& slot( std::size_t position ) const noexcept
+        {
+            return sequence_[position & ( storage_.capacity() - 1 )].value;
+        }
+
+        //
+        // number of consecutive slots from `position` whose sequence equals their position + offset, i.e. free
+        // for the producer at that position (offset 0) or filled for the consumer (offset 1). such slots can only
+        // be taken through the CAS on the shared index, so the count stays valid until that CAS.
+        //
+        std::size_t ready( std::size_t position, std::size_t wanted, std::size_t offset ) const noexcept
+        {
+            std::size_t n = 0;
+            while ( n != wanted && n != storage_.capacity() && slot( position + n ).load( std::memory_order_acquire ) == position + n + offset )
+                ++n;
+            return n;
+        }
+
+        float16_t_private::ring_storage storage_;
+        std::unique_ptr<sequence_slot[]> sequence_;
+        alignas( float16_t_private::ring_cache_line ) std::atomic<std::size_t> enqueue_{ 0 };
+        alignas( float16_t_private::ring_cache_line ) std::atomic<std::size_t> dequeue_{ 0 };
+    };
+
+}//namespace numeric
+
+#endif
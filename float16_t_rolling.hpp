@@ -0,0 +1,259 @@
+#ifndef FLOAT16_T_ROLLING_HPP_INCLUDED_SDKLFJ3049USDFLKJ3049USDFLKJ3049USDFLKJSD
+#define FLOAT16_T_ROLLING_HPP_INCLUDED_SDKLFJ3049USDFLKJ3049USDFLKJ3049USDFLKJSD
+//
+// streaming moving-window mean, standard deviation, min and max over float16_t series at O(1) per sample.
+// mean and variance come from fp32 running sums of (x - shift), where the shift and the sums are
+// recomputed from the window every `recompute_every` steps to bound drift; min and max come from
+// monotonic deques on the order key. several series can be evaluated in lockstep, the sums are then
+// updated across series with vector code. state is kept between calls, so input may arrive in chunks.
+//
+#include "float16_t.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace numeric
+{
+    struct rolling_options
+    {
+        std::size_t window = 0;
+        std::size_t series = 1;            // samples arrive interleaved: time step t of series s is at t * series + s
+        std::size_t ddof = 1;              // the variance divides by (count - ddof), as pandas
+        std::size_t recompute_every = 0;   // steps between exact recomputations, 0 means max( window, 256 )
+    };
+
+    // any empty span is not computed; otherwise each must hold one value per input sample
+    struct rolling_outputs
+    {
+        std::span<float> mean;
+        std::span<float> stddev;           // 0 while the window holds no more than ddof samples
+        std::span<float16_t> min;          // NaNs are ordered by order_key, a positive NaN exceeds +inf
+        std::span<float16_t> max;
+    };
+
+    namespace float16_t_private
+    {
+        // per-series ring of ( step, key ) pairs with keys kept monotonic from front to back
+        class monotonic_deques
+        {
+        public:
+            void resize( std::size_t series, std::size_t capacity )
+            {
+                capacity_ = capacity;
+                step_.assign( series * capacity, 0 );
+                key_.assign( series * capacity, 0 );
+                head_.assign( series, 0 );
+                count_.assign( series, 0 );
+            }
+
+            void clear() noexcept
+            {
+                std::fill( head_.begin(), head_.end(), 0 );
+                std::fill( count_.begin(), count_.end(), 0 );
+            }
+
+            // Less( a, b ) true means b can never be the answer while a stays in the window
+            template< typename Less >
+            std::uint16_t push( std::size_t s, std::uint64_t step, std::uint16_t key, std::size_t window, Less less ) noexcept
+            {
+                std::size_t const base = s * capacity_;
+                std::size_t head = head_[s];
+                std::size_t count = count_[s];
+
+                if ( count && step_[base + head] + window <= step )
+                {
+                    head = head + 1 == capacity_ ? 0 : head + 1;
+                    --count;
+                }
+                while ( count && !less( key_[base + ( head + count - 1 ) % capacity_], key ) )
+                    --count;
+
+                std::size_t const tail = ( head + count ) % capacity_;
+                step_[base + tail] = step;
+                key_[base + tail] = key;
+                head_[s] = head;
+                count_[s] = count + 1;
+                return key_[base + head];
+            }
+
+        private:
+            std::size_t capacity_ = 0;
+            std::vector<std::uint64_t> step_;
+            std::vector<std::uint16_t> key_;
+            std::vector<std::size_t> head_;
+            std::vector<std::size_t> count_;
+        };
+
+    }//namespace float16_t_private
+
+    class rolling_window
+    {
+    public:
+        explicit rolling_window( rolling_options const& options ) : options_{ options }
+        {
+            if ( options_.window == 0 || options_.series == 0 )
+                throw std::invalid_argument( "rolling_window: window and series must be positive" );
+            if ( options_.recompute_every == 0 )
+                options_.recompute_every = std::max<std::size_t>( options_.window, 256 );
+
+            std::size_t const s = options_.series;
+            ring_.resize( options_.window * s );
+            shift_.resize( s );
+            sum_.resize( s );
+            sum_squares_.resize( s );
+            incoming_.resize( s );
+            outgoing_.resize( s );
+            min_.resize( s, options_.window );
+            max_.resize( s, options_.window );
+            reset();
+        }
+
+        void reset() noexcept
+        {
+            std::fill( shift_.begin(), shift_.end(), 0.0f );
+            std::fill( sum_.begin(), sum_.end(), 0.0f );
+            std::fill( sum_squares_.begin(), sum_squares_.end(), 0.0f );
+            min_.clear();
+            max_.clear();
+            step_ = 0;
+            since_recompute_ = 0;
+        }
+
+        std::uint64_t steps() const noexcept { return step_; }
+
+        //
+        // consumes whole time steps (samples.size() must be a multiple of series) and writes the statistics of
+        // the window ending at every sample; early windows cover the samples seen so far
+        //
+        void process( std::span<float16_t const> samples, rolling_outputs const& out )
+        {
+            std::size_t const S = options_.series;
+            std::size_t const W = options_.window;
+            if ( samples.size() % S )
+                throw std::invalid_argument( "rolling_window::process: input is not a whole number of time steps" );
+            for ( std::size_t size : { out.mean.size(), out.stddev.size(), out.min.size(), out.max.size() } )
+                if ( size && size < samples.size() )
+                    throw std::invalid_argument( "rolling_window::process: output too small" );
+
+            std::size_t const steps = samples.size() / S;
+            for ( std::size_t t = 0; t != steps; ++t )
+            {
+                float16_t const* row = samples.data() + t * S;
+                float16_t* slot = ring_.data() + ( step_ % W ) * S;
+                bool const full = step_ >= W;
+
+                widen( row, incoming_.data(), S );
+                if ( step_ == 0 )
+                    std::copy_n( incoming_.data(), S, shift_.data() );  // centres the sums until the first recompute
+                if ( full )
+                    widen( slot, outgoing_.data(), S );
+                std::copy_n( row, S, slot );
+
+                float* const sum = sum_.data();
+                float* const squares = sum_squares_.data();
+                float const* const shift = shift_.data();
+                float const* const in = incoming_.data();
+                float const* const old = outgoing_.data();
+                if ( full )
+                    for ( std::size_t s = 0; s != S; ++s )
+                    {
+                        float const a = in[s] - shift[s];
+                        float const b = old[s] - shift[s];
+                        sum[s] += a - b;
+                        squares[s] += ( a - b ) * ( a + b );
+                    }
+                else
+                    for ( std::size_t s = 0; s != S; ++s )
+                    {
+                        float const a = in[s] - shift[s];
+                        sum[s] += a;
+                        squares[s] += a * a;
+                    }
+
+                std::size_t const count = std::min<std::uint64_t>( step_ + 1, W );
+                float const inv_count = 1.0f / float( count );
+                std::size_t const o = t * S;
+                if ( !out.mean.empty() )
+                    for ( std::size_t s = 0; s != S; ++s )
+                        out.mean[o + s] = shift[s] + sum[s] * inv_count;
+                if ( !out.stddev.empty() )
+                {
+                    float const inv_dof = count > options_.ddof ? 1.0f / float( count - options_.ddof ) : 0.0f;
+                    for ( std::size_t s = 0; s != S; ++s )
+                        out.stddev[o + s] = std::sqrt( std::max( ( squares[s] - sum[s] * sum[s] * inv_count ) * inv_dof, 0.0f ) );
+                }
+
+                for ( std::size_t s = 0; s != S; ++s )
+                {
+                    std::uint16_t const key = order_key( row[s] );
+                    std::uint16_t const lo = min_.push( s, step_, key, W, []( std::uint16_t a, std::uint16_t b ) { return a < b; } );
+                    std::uint16_t const hi = max_.push( s, step_, key, W, []( std::uint16_t a, std::uint16_t b ) { return a > b; } );
+                    if ( !out.min.empty() ) out.min[o + s] = from_order_key( lo );
+                    if ( !out.max.empty() ) out.max[o + s] = from_order_key( hi );
+                }
+
+                ++step_;
+                if ( ++since_recompute_ >= options_.recompute_every )
+                    recompute();
+            }
+        }
+
+        void process( std::span<float16_t const> samples, std::span<float> mean, std::span<float> stddev )
+        {
+            process( samples, rolling_outputs{ mean, stddev, {}, {} } );
+        }
+
+    private:
+        // exact sums over the current window, re-centred on its mean
+        void recompute()
+        {
+            std::size_t const S = options_.series;
+            std::size_t const count = std::min<std::uint64_t>( step_, options_.window );
+            std::vector<double> mean( S, 0.0 ), sum( S, 0.0 ), squares( S, 0.0 );
+            for ( std::size_t k = 0; k != count; ++k )
+            {
+                widen( ring_.data() + k * S, incoming_.data(), S );
+                for ( std::size_t s = 0; s != S; ++s )
+                    mean[s] += incoming_[s];
+            }
+            for ( std::size_t s = 0; s != S; ++s )
+                shift_[s] = float( mean[s] / double( count ) );
+            for ( std::size_t k = 0; k != count; ++k )
+            {
+                widen( ring_.data() + k * S, incoming_.data(), S );
+                for ( std::size_t s = 0; s != S; ++s )
+                {
+                    double const d = double( incoming_[s] ) - double( shift_[s] );
+                    sum[s] += d;
+                    squares[s] += d * d;
+                }
+            }
+            for ( std::size_t s = 0; s != S; ++s )
+            {
+                sum_[s] = float( sum[s] );
+                sum_squares_[s] = float( squares[s] );
+            }
+            since_recompute_ = 0;
+        }
+
+        rolling_options options_;
+        std::vector<float16_t> ring_;      // the last `window` time steps, slot step % window
+        std::vector<float> shift_;
+        std::vector<float> sum_;
+        std::vector<float> sum_squares_;
+        std::vector<float> incoming_;
+        std::vector<float> outgoing_;
+        float16_t_private::monotonic_deques min_;
+        float16_t_private::monotonic_deques max_;
+        std::uint64_t step_ = 0;
+        std::size_t since_recompute_ = 0;
+    };
+
+}//namespace numeric
+
+#endif
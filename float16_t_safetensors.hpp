@@ -0,0 +1,515 @@
+#ifndef FLOAT16_T_SAFETENSORS_HPP_INCLUDED_SLDKFJ3094USDFLKJ3094USDFLKJ3049USDFLK
+#define FLOAT16_T_SAFETENSORS_HPP_INCLUDED_SLDKFJ3094USDFLKJ3094USDFLKJ3049USDFLK
+//
+// safetensors checkpoints: an mmap-backed reader handing out zero-copy float16_t views and a streaming writer
+// https://github.com/huggingface/safetensors
+//
+// layout: 8 byte little-endian header size N, N bytes of JSON, then the tensor bytes. the JSON maps each
+// tensor name to {"dtype": "F16", "shape": [...], "data_offsets": [begin, end]}, offsets relative to the
+// first byte after the header, plus an optional "__metadata__" object of strings.
+//
+#include "float16_t.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace numeric
+{
+    struct safetensors_tensor
+    {
+        std::string name;
+        std::string dtype = "F16";
+        std::vector<std::int64_t> shape;
+        std::uint64_t begin = 0;    // byte offsets into the data section
+        std::uint64_t end = 0;
+    };
+
+    namespace float16_t_private
+    {
+        constexpr inline std::size_t safetensors_max_depth = 64;   // nesting allowed inside skipped values
+
+        // just enough JSON for safetensors headers: objects, arrays, strings, integers; other scalars are skipped
+        class safetensors_json
+        {
+        public:
+            explicit safetensors_json( std::string_view text ) : s_{ text } { }
+
+            void parse( std::vector<safetensors_tensor>& tensors, std::map<std::string, std::string>& metadata )
+            {
+                expect( '{' );
+                if ( peek() == '}' ) { ++pos_; return; }
+                for ( ;; )
+                {
+                    std::string key = string();
+                    expect( ':' );
+                    if ( key == "__metadata__" )
+                        parse_metadata( metadata );
+                    else
+                        tensors.push_back( parse_tensor( std::move( key ) ) );
+                    if ( peek() == ',' ) { ++pos_; continue; }
+                    expect( '}' );
+                    break;
+                }
+                if ( peek() != '\0' )
+                    fail( "trailing characters" );
+            }
+
+        private:
+            [[noreturn]] void fail( char const* what ) const
+            {
+                throw std::runtime_error( std::string{ "safetensors header: " } + what + " at byte " + std::to_string( pos_ ) );
+            }
+
+            char peek()
+            {
+                while ( pos_ < s_.size() && ( s_[pos_] == ' ' || s_[pos_] == '\n' || s_[pos_] == '\r' || s_[pos_] == '\t' ) )
+                    ++pos_;
+                return pos_ < s_.size() ? s_[pos_] : '\0';
+            }
+
+            void expect( char c )
+            {
+                if ( peek() != c ) fail( "unexpected character" );
+                ++pos_;
+            }
+
+            std::string string()
+            {
+                expect( '"' );
+                std::string out;
+                while ( pos_ < s_.size() && s_[pos_] != '"' )
+                {
+                    char c = s_[pos_++];
+                    if ( c != '\\' ) { out += c; continue; }
+                    if ( pos_ >= s_.size() ) fail( "unterminated escape" );
+                    c = s_[pos_++];
+                    switch ( c )
+                    {
+                        case 'b': out += '\b'; break;
+                        case 'f': out += '\f'; break;
+                        case 'n': out += '\n'; break;
+                        case 'r': out += '\r'; break;
+                        case 't': out += '\t'; break;
+                        case 'u':
+                        {
+                            if ( pos_ + 4 > s_.size() ) fail( "short unicode escape" );
+                            unsigned cp = 0;
+                            for ( std::size_t end = pos_ + 4; pos_ != end; ++pos_ )
+                            {
+                                char const h = s_[pos_];
+                                unsigned const digit = h >= '0' && h <= '9' ? unsigned( h - '0' )
+                                                     : h >= 'a' && h <= 'f' ? unsigned( h - 'a' + 10 )
+                                                     : h >= 'A' && h <= 'F' ? unsigned( h - 'A' + 10 ) : 16u;
+                                if ( digit == 16 ) fail( "bad unicode escape" );
+                                cp = cp * 16 + digit;
+                            }
+                            // surrogate pairs are not combined, names are ascii in practice
+                            if ( cp < 0x80 ) out += static_cast<char>( cp );
+                            else if ( cp < 0x800 ) { out += static_cast<char>( 0xc0 | ( cp >> 6 ) ); out += static_cast<char>( 0x80 | ( cp & 0x3f ) ); }
+                            else { out += static_cast<char>( 0xe0 | ( cp >> 12 ) ); out += static_cast<char>( 0x80 | ( ( cp >> 6 ) & 0x3f ) ); out += static_cast<char>( 0x80 | ( cp & 0x3f ) ); }
+                            break;
+                        }
+                        case '"': case '\\': case '/': out += c; break;
+                        default: fail( "bad escape" );
+                    }
+                }
+                if ( pos_ >= s_.size() ) fail( "unterminated string" );
+                ++pos_;
+                return out;
+            }
+
+            std::uint64_t integer()
+            {
+                peek();
+                std::size_t const start = pos_;
+                std::uint64_t v = 0;
+                while ( pos_ < s_.size() && s_[pos_] >= '0' && s_[pos_] <= '9' )
+                {
+                    std::uint64_t const digit = static_cast<std::uint64_t>( s_[pos_++] - '0' );
+                    if ( v > ( UINT64_MAX - digit ) / 10 ) fail( "integer out of range" );
+                    v = v * 10 + digit;
+                }
+                if ( pos_ == start ) fail( "expected a non-negative integer" );
+                return v;
+            }
+
+            template< typename Func >
+            void array( Func const& element )
+            {
+                expect( '[' );
+                if ( peek() == ']' ) { ++pos_; return; }
+                for ( ;; )
+                {
+                    element();
+                    if ( peek() == ',' ) { ++pos_; continue; }
+                    expect( ']' );
+                    return;
+                }
+            }
+
+            // unknown values are skipped with bounded recursion, a crafted header cannot exhaust the stack
+            void skip_value( std::size_t depth = 0 )
+            {
+                char const c = peek();
+                if ( c == '"' ) { string(); return; }
+                if ( ( c == '[' || c == '{' ) && depth == safetensors_max_depth ) fail( "nesting too deep" );
+                if ( c == '[' ) { array( [&] { skip_value( depth + 1 ); } ); return; }
+                if ( c == '{' )
+                {
+                    ++pos_;
+                    if ( peek() == '}' ) { ++pos_; return; }
+                    for ( ;; )
+                    {
+                        string();
+                        expect( ':' );
+                        skip_value( depth + 1 );
+                        if ( peek() == ',' ) { ++pos_; continue; }
+                        expect( '}' );
+                        return;
+                    }
+                }
+                // numbers, true, false, null
+                std::size_t const start = pos_;
+                while ( pos_ < s_.size() && std::strchr( ",]} \n\r\t", s_[pos_] ) == nullptr )
+                    ++pos_;
+                if ( pos_ == start ) fail( "expected a value" );
+            }
+
+            void parse_metadata( std::map<std::string, std::string>& metadata )
+            {
+                expect( '{' );
+                if ( peek() == '}' ) { ++pos_; return; }
+                for ( ;; )
+                {
+                    std::string key = string();
+                    expect( ':' );
+                    metadata[std::move( key )] = string();
+                    if ( peek() == ',' ) { ++pos_; continue; }
+                    expect( '}' );
+                    return;
+                }
+            }
+
+            safetensors_tensor parse_tensor( std::string name )
+            {
+                safetensors_tensor t;
+                t.name = std::move( name );
+                bool has_dtype = false, has_shape = false, has_offsets = false;
+                expect( '{' );
+                for ( ;; )
+                {
+                    std::string const key = string();
+                    expect( ':' );
+                    if ( key == "dtype" ) { t.dtype = string(); has_dtype = true; }
+                    else if ( key == "shape" )
+                    {
+                        array( [&]
+                        {
+                            std::uint64_t const extent = integer();
+                            if ( extent > std::uint64_t( INT64_MAX ) ) fail( "extent out of range" );
+                            t.shape.push_back( static_cast<std::int64_t>( extent ) );
+                        } );
+                        has_shape = true;
+                    }
+                    else if ( key == "data_offsets" )
+                    {
+                        std::vector<std::uint64_t> offsets;
+                        array( [&] { offsets.push_back( integer() ); } );
+                        if ( offsets.size() != 2 || offsets[0] > offsets[1] ) fail( "invalid data_offsets" );
+                        t.begin = offsets[0];
+                        t.end = offsets[1];
+                        has_offsets = true;
+                    }
+                    else
+                        skip_value();
+                    if ( peek() == ',' ) { ++pos_; continue; }
+                    expect( '}' );
+                    break;
+                }
+                if ( !has_dtype || !has_shape || !has_offsets ) fail( "tensor entry misses dtype, shape or data_offsets" );
+                return t;
+            }
+
+            std::string_view s_;
+            std::size_t pos_ = 0;
+        };
+
+        inline void json_escape( std::string& out, std::string_view s )
+        {
+            out += '"';
+            for ( char c : s )
+            {
+                if ( c == '"' || c == '\\' ) { out += '\\'; out += c; }
+                else if ( static_cast<unsigned char>( c ) < 0x20 )
+                {
+                    char buf[8];
+                    std::snprintf( buf, sizeof( buf ), "\\u%04x", static_cast<unsigned>( c ) );
+                    out += buf;
+                }
+                else out += c;
+            }
+            out += '"';
+        }
+
+        inline std::uint64_t element_count( std::vector<std::int64_t> const& shape )
+        {
+            std::uint64_t n = 1;
+            for ( auto extent : shape )
+            {
+                if ( extent < 0 ) throw std::invalid_argument( "safetensors: negative extent" );
+                if ( extent != 0 && n > UINT64_MAX / sizeof( float16_t ) / static_cast<std::uint64_t>( extent ) )
+                    throw std::overflow_error( "safetensors: shape too large" );
+                n *= static_cast<std::uint64_t>( extent );
+            }
+            return n; // n * sizeof( float16_t ) cannot overflow
+        }
+
+        //
+        // the size prefix and JSON header for `tensors`, laid out back to back in declaration order (their dtype and
+        // offsets are filled in); the header is padded with spaces so that the data section starts at a multiple of `alignment`
+        //
+        inline std::string safetensors_header( std::vector<safetensors_tensor>& tensors, std::map<std::string, std::string> const& metadata, std::size_t alignment )
+        {
+            std::string header = "{";
+            if ( !metadata.empty() )
+            {
+                header += "\"__metadata__\":{";
+                bool first = true;
+                for ( auto const& [k, v] : metadata )
+                {
+                    if ( !first ) header += ',';
+                    first = false;
+                    json_escape( header, k );
+                    header += ':';
+                    json_escape( header, v );
+                }
+                header += '}';
+            }
+
+            std::uint64_t offset = 0;
+            for ( auto& t : tensors )
+            {
+                t.dtype = "F16";
+                std::uint64_t const bytes = element_count( t.shape ) * sizeof( float16_t );
+                if ( bytes > UINT64_MAX - offset )
+                    throw std::overflow_error( "safetensors: tensors too large" );
+                t.begin = offset;
+                t.end = offset + bytes;
+                offset = t.end;
+
+                if ( header.size() > 1 ) header += ',';
+                json_escape( header, t.name );
+                header += ":{\"dtype\":\"F16\",\"shape\":[";
+                for ( std::size_t d = 0; d != t.shape.size(); ++d )
+                {
+                    if ( d ) header += ',';
+                    header += std::to_string( t.shape[d] );
+                }
+                header += "],\"data_offsets\":[" + std::to_string( t.begin ) + ',' + std::to_string( t.end ) + "]}";
+            }
+            header += '}';
+            while ( ( 8 + header.size() ) % alignment != 0 )
+                header += ' ';
+
+            std::string out( 8, '\0' );
+            std::uint64_t const n = header.size();
+            for ( int i = 0; i != 8; ++i )
+                out[i] = static_cast<char>( n >> ( 8 * i ) );
+            return out + header;
+        }
+
+    }//namespace float16_t_private
+
+    //
+    // maps the whole file read-only and parses the header once; views point into the mapping and
+    // stay valid for the lifetime of the reader, pages are only faulted in when a tensor is touched
+    //
+    class safetensors_reader
+    {
+    public:
+        explicit safetensors_reader( std::string const& path )
+        {
+            int const fd = ::open( path.c_str(), O_RDONLY );
+            if ( fd < 0 )
+                throw std::system_error( errno, std::generic_category(), "safetensors: open " + path );
+            struct stat st;
+            if ( fstat( fd, &st ) != 0 )
+            {
+                int const err = errno;
+                ::close( fd );
+                throw std::system_error( err, std::generic_category(), "safetensors: fstat" );
+            }
+            size_ = static_cast<std::size_t>( st.st_size );
+            if ( size_ < 8 )
+            {
+                ::close( fd );
+                throw std::runtime_error( "safetensors: file too small" );
+            }
+            void* p = mmap( nullptr, size_, PROT_READ, MAP_SHARED, fd, 0 );
+            int const err = errno;
+            ::close( fd );
+            if ( p == MAP_FAILED )
+                throw std::system_error( err, std::generic_category(), "safetensors: mmap" );
+            base_ = static_cast<std::byte const*>( p );
+
+            try { parse(); }
+            catch ( ... ) { munmap( const_cast<std::byte*>( base_ ), size_ ); throw; }
+        }
+
+        safetensors_reader( safetensors_reader const& ) = delete;
+        safetensors_reader& operator = ( safetensors_reader const& ) = delete;
+
+        ~safetensors_reader()
+        {
+            munmap( const_cast<std::byte*>( base_ ), size_ );
+        }
+
+        std::vector<safetensors_tensor> const& tensors() const noexcept { return tensors_; }
+        std::map<std::string, std::string> const& metadata() const noexcept { return metadata_; }
+
+        safetensors_tensor const& tensor( std::string_view name ) const
+        {
+            auto const it = index_.find( name );
+            if ( it == index_.end() )
+                throw std::out_of_range( "safetensors: no tensor named " + std::string{ name } );
+            return tensors_[it->second];
+        }
+
+        std::span<std::byte const> bytes( std::string_view name ) const
+        {
+            auto const& t = tensor( name );
+            return { data_ + t.begin, static_cast<std::size_t>( t.end - t.begin ) };
+        }
+
+        std::span<float16_t const> view( std::string_view name ) const
+        {
+            auto const& t = tensor( name );
+            if ( t.dtype != "F16" )
+                throw std::invalid_argument( "safetensors: tensor " + t.name + " is " + t.dtype + ", not F16" );
+            if ( reinterpret_cast<std::uintptr_t>( data_ + t.begin ) % alignof( float16_t ) != 0 )
+                throw std::runtime_error( "safetensors: tensor " + t.name + " is misaligned" );
+            return { reinterpret_cast<float16_t const*>( data_ + t.begin ), static_cast<std::size_t>( ( t.end - t.begin ) / sizeof( float16_t ) ) };
+        }
+
+    private:
+        void parse()
+        {
+            std::uint64_t n = 0;
+            for ( int i = 7; i >= 0; --i )
+                n = ( n << 8 ) | std::to_integer<std::uint64_t>( base_[i] );
+            if ( n > size_ - 8 )
+                throw std::runtime_error( "safetensors: header larger than the file" );
+            data_ = base_ + 8 + n;
+            std::size_t const data_size = size_ - 8 - static_cast<std::size_t>( n );
+
+            float16_t_private::safetensors_json json{ std::string_view{ reinterpret_cast<char const*>( base_ + 8 ), static_cast<std::size_t>( n ) } };
+            json.parse( tensors_, metadata_ );
+
+            for ( std::size_t i = 0; i != tensors_.size(); ++i )
+            {
+                auto const& t = tensors_[i];
+                if ( t.end > data_size )
+                    throw std::runtime_error( "safetensors: tensor " + t.name + " exceeds the file" );
+                if ( t.dtype == "F16" && t.end - t.begin != float16_t_private::element_count( t.shape ) * sizeof( float16_t ) )
+                    throw std::runtime_error( "safetensors: tensor " + t.name + " size does not match its shape" );
+                if ( !index_.emplace( t.name, i ).second )
+                    throw std::runtime_error( "safetensors: duplicate tensor " + t.name );
+            }
+        }
+
+        std::byte const* base_ = nullptr;
+        std::byte const* data_ = nullptr;
+        std::size_t size_ = 0;
+        std::vector<safetensors_tensor> tensors_;
+        std::map<std::string, std::string> metadata_;
+        std::map<std::string, std::size_t, std::less<>> index_;
+    };
+
+    //
+    // the header is written up front from the declared tensors, their data is then streamed in declaration
+    // order through any number of write() calls. the header is padded with spaces so that the data section
+    // starts on a 64 byte boundary; tensors follow each other without gaps as the format forbids holes.
+    //
+    class safetensors_writer
+    {
+    public:
+        safetensors_writer( std::string const& path, std::vector<safetensors_tensor> tensors,
+                            std::map<std::string, std::string> const& metadata = {} )
+            : tensors_{ std::move( tensors ) }, out_{ path, std::ios::binary | std::ios::trunc }
+        {
+            if ( !out_ )
+                throw std::runtime_error( "safetensors: cannot create " + path );
+
+            std::string const header = float16_t_private::safetensors_header( tensors_, metadata, 64 );
+            out_.write( header.data(), static_cast<std::streamsize>( header.size() ) );
+            remaining_ = tensors_.empty() ? 0 : tensors_.front().end - tensors_.front().begin;
+            skip_empty();
+        }
+
+        // appends to the current tensor and moves on to the next one once it is full
+        void write( std::span<float16_t const> values )
+        {
+            auto const* p = reinterpret_cast<char const*>( values.data() );
+            std::uint64_t bytes = values.size_bytes();
+            while ( bytes )
+            {
+                if ( current_ == tensors_.size() )
+                    throw std::length_error( "safetensors: more data written than declared" );
+                std::uint64_t const n = std::min( bytes, remaining_ );
+                out_.write( p, static_cast<std::streamsize>( n ) );
+                p += n;
+                bytes -= n;
+                remaining_ -= n;
+                skip_empty();
+            }
+            if ( !out_ )
+                throw std::runtime_error( "safetensors: write failed" );
+        }
+
+        // flushes the file, throws if not every declared tensor was written in full
+        void close()
+        {
+            if ( current_ != tensors_.size() )
+                throw std::logic_error( "safetensors: tensor " + tensors_[current_].name + " is incomplete" );
+            out_.close();
+            if ( !out_ )
+                throw std::runtime_error( "safetensors: close failed" );
+        }
+
+    private:
+        void skip_empty() noexcept
+        {
+            while ( current_ != tensors_.size() && remaining_ == 0 )
+            {
+                if ( ++current_ != tensors_.size() )
+                    remaining_ = tensors_[current_].end - tensors_[current_].begin;
+            }
+        }
+
+        std::vector<safetensors_tensor> tensors_;
+        std::ofstream out_;
+        std::size_t current_ = 0;
+        std::uint64_t remaining_ = 0;
+    };
+
+}//namespace numeric
+
+#endif
@@ -0,0 +1,247 @@
+#ifndef FLOAT16_T_STENCIL_HPP_INCLUDED_DSLKFJ3049USDLFKJ3049SUDLFKJ3094USDLKFJ34
+#define FLOAT16_T_STENCIL_HPP_INCLUDED_DSLKFJ3049USDLFKJ3049SUDLFKJ3094USDLKFJ34
+//
+// Jacobi-style stencils (5/9-point in 2D, 7/27-point in 3D) over float16_t grids with temporal blocking.
+// a sweep cuts the grid into tiles; each tile widens its cells plus a halo of `steps_per_sweep` cells into a
+// private fp32 buffer, runs that many time steps there (the valid region shrinking by one cell per step), and
+// narrows only its own cells back, so the grid is read and written once per sweep instead of once per step.
+// the halos are recomputed redundantly by neighbouring tiles, which keeps tiles independent and lets them run
+// in parallel. cells on the grid boundary are fixed (Dirichlet). intermediate steps of a sweep stay in fp32,
+// so results depend on steps_per_sweep, but not on the tile sizes or the thread count.
+// grids are row-major with x fastest: index = ( z * ny + y ) * nx + x.
+//
+#include "float16_t.hpp"
+#include "float16_t_parallel.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace numeric
+{
+    // weights[dy + 1][dx + 1] multiplies the cell at ( x + dx, y + dy )
+    struct stencil2d
+    {
+        float weights[3][3] = {};
+
+        static stencil2d five_point( float center, float neighbour ) noexcept
+        {
+            return { { { 0.0f, neighbour, 0.0f }, { neighbour, center, neighbour }, { 0.0f, neighbour, 0.0f } } };
+        }
+
+        static stencil2d nine_point( float center, float edge, float corner ) noexcept
+        {
+            return { { { corner, edge, corner }, { edge, center, edge }, { corner, edge, corner } } };
+        }
+    };
+
+    // weights[dz + 1][dy + 1][dx + 1] multiplies the cell at ( x + dx, y + dy, z + dz )
+    struct stencil3d
+    {
+        float weights[3][3][3] = {};
+
+        static stencil3d seven_point( float center, float face ) noexcept
+        {
+            return twenty_seven_point( center, face, 0.0f, 0.0f );
+        }
+
+        // face, edge and corner neighbours are 1, 2 and 3 offsets away from the center
+        static stencil3d twenty_seven_point( float center, float face, float edge, float corner ) noexcept
+        {
+            stencil3d s;
+            float const by_distance[4] = { center, face, edge, corner };
+            for ( int z = 0; z != 3; ++z )
+                for ( int y = 0; y != 3; ++y )
+                    for ( int x = 0; x != 3; ++x )
+                        s.weights[z][y][x] = by_distance[( z != 1 ) + ( y != 1 ) + ( x != 1 )];
+            return s;
+        }
+    };
+
+    struct stencil_options
+    {
+        std::size_t steps_per_sweep = 4;     // time steps per grid pass, also the halo width
+        std::size_t tile_x = 0;              // tile extents, 0 picks 256 x 64 in 2D and 64 x 32 x 16 in 3D
+        std::size_t tile_y = 0;
+        std::size_t tile_z = 0;
+        std::size_t threads = 0;             // 0 means all hardware threads
+    };
+
+    namespace float16_t_private
+    {
+        // rows are computed in multiples of this many cells so every cell goes through the same (vectorized) code,
+        // a scalar remainder loop could associate differently under -ffast-math and make results depend on the tiling
+        constexpr inline std::size_t stencil_lanes = 16;
+
+        // out[x] += w[0] * in[x - 1] + w[1] * in[x] + w[2] * in[x + 1] for x in [0, count), count a multiple of stencil_lanes
+        inline void stencil_row( float* out, float const* in, float const ( &w )[3], std::size_t count ) noexcept
+        {
+            float const w0 = w[0], w1 = w[1], w2 = w[2];
+            if ( w0 == 0.0f && w2 == 0.0f )
+            {
+                if ( w1 != 0.0f )
+                    for ( std::size_t x = 0; x != count; ++x )
+                        out[x] += w1 * in[x];
+                return;
+            }
+            for ( std::size_t x = 0; x != count; ++x )
+                out[x] += w0 * in[x - 1] + w1 * in[x] + w2 * in[x + 1];
+        }
+
+        struct stencil_grid
+        {
+            std::size_t n[3];                // x, y, z extents
+            bool planar;                     // 2D: z has extent 1 and no boundary
+        };
+
+        // [begin, end) of the cells a tile holds along one axis, and the updated part of it at step k
+        struct stencil_span
+        {
+            std::size_t begin, end;
+
+            static stencil_span halo( std::size_t first, std::size_t last, std::size_t halo, std::size_t n ) noexcept
+            {
+                return { first > halo ? first - halo : 0, std::min( n, last + halo ) };
+            }
+
+            // boundary cells are never updated; a cut edge loses one valid cell per step
+            stencil_span updated( std::size_t k, std::size_t n ) const noexcept
+            {
+                std::size_t const lo = begin ? begin + k : 1;
+                std::size_t const hi = end < n ? end - k : n - 1;
+                return { lo, std::max( lo, hi ) };
+            }
+        };
+
+        // one sweep of `steps` time steps from `in` to `out`
+        inline void stencil_sweep( float const ( &w )[3][3][3], stencil_grid const& g, float16_t const* in, float16_t* out,
+                                   std::size_t steps, std::size_t const ( &tile )[3], std::size_t threads )
+        {
+            std::size_t const tiles[3] = { ( g.n[0] + tile[0] - 1 ) / tile[0], ( g.n[1] + tile[1] - 1 ) / tile[1], ( g.n[2] + tile[2] - 1 ) / tile[2] };
+            parallel_for( 0, tiles[0] * tiles[1] * tiles[2], 1, [&]( std::size_t first, std::size_t last )
+            {
+                std::vector<float> a, b, row;
+                std::vector<float16_t> halves;
+                for ( std::size_t t = first; t != last; ++t )
+                {
+                    std::size_t const index[3] = { t % tiles[0], t / tiles[0] % tiles[1], t / ( tiles[0] * tiles[1] ) };
+                    stencil_span own[3], held[3];
+                    for ( int d = 0; d != 3; ++d )
+                    {
+                        own[d] = { index[d] * tile[d], std::min( g.n[d], ( index[d] + 1 ) * tile[d] ) };
+                        held[d] = d == 2 && g.planar ? own[d] : stencil_span::halo( own[d].begin, own[d].end, steps, g.n[d] );
+                    }
+                    std::size_t const lx = held[0].end - held[0].begin, ly = held[1].end - held[1].begin, lz = held[2].end - held[2].begin;
+                    auto const local = [&]( std::size_t z, std::size_t y ) { return ( ( z - held[2].begin ) * ly + ( y - held[1].begin ) ) * lx; };
+                    // slack past the last row for the reads of the rounded-up row lengths
+                    a.resize( lx * ly * lz + stencil_lanes );
+                    b.resize( a.size() );
+                    row.resize( lx + stencil_lanes );
+                    halves.resize( lx + stencil_lanes );
+
+                    for ( std::size_t z = held[2].begin; z != held[2].end; ++z )
+                        for ( std::size_t y = held[1].begin; y != held[1].end; ++y )
+                            widen( in + ( z * g.n[1] + y ) * g.n[0] + held[0].begin, a.data() + local( z, y ), lx );
+                    std::memcpy( b.data(), a.data(), a.size() * sizeof( float ) );
+
+                    for ( std::size_t k = 1; k <= steps; ++k )
+                    {
+                        stencil_span ux = held[0].updated( k, g.n[0] ), uy = held[1].updated( k, g.n[1] );
+                        stencil_span const uz = g.planar ? held[2] : held[2].updated( k, g.n[2] );
+                        int const dz0 = g.planar ? 1 : 0, dz1 = g.planar ? 2 : 3;
+                        ux = { ux.begin - held[0].begin, ux.end - held[0].begin };
+                        std::size_t const count = ( ux.end - ux.begin + stencil_lanes - 1 ) / stencil_lanes * stencil_lanes;
+                        for ( std::size_t z = uz.begin; z < uz.end; ++z )
+                            for ( std::size_t y = uy.begin; y < uy.end; ++y )
+                            {
+                                std::fill( row.begin(), row.begin() + count, 0.0f );
+                                for ( int dz = dz0; dz != dz1; ++dz )
+                                    for ( int dy = 0; dy != 3; ++dy )
+                                        stencil_row( row.data(), a.data() + local( z + dz - 1, y + dy - 1 ) + ux.begin, w[dz][dy], count );
+                                std::copy( row.begin(), row.begin() + ( ux.end - ux.begin ), b.begin() + local( z, y ) + ux.begin );
+                            }
+                        std::swap( a, b );
+                    }
+
+                    // narrowed in whole lanes too, the F16C and scalar conversions round ties differently
+                    std::size_t const width = own[0].end - own[0].begin;
+                    std::size_t const count = ( width + stencil_lanes - 1 ) / stencil_lanes * stencil_lanes;
+                    for ( std::size_t z = own[2].begin; z != own[2].end; ++z )
+                        for ( std::size_t y = own[1].begin; y != own[1].end; ++y )
+                        {
+                            narrow( a.data() + local( z, y ) + ( own[0].begin - held[0].begin ), halves.data(), count );
+                            std::copy( halves.begin(), halves.begin() + width, out + ( z * g.n[1] + y ) * g.n[0] + own[0].begin );
+                        }
+                }
+            }, threads );
+        }
+
+        inline void stencil_run( float const ( &w )[3][3][3], stencil_grid const& g, std::span<float16_t> grid, std::span<float16_t> scratch,
+                                 std::size_t steps, stencil_options const& options, std::size_t const ( &automatic )[3] )
+        {
+            std::size_t const cells = g.n[0] * g.n[1] * g.n[2];
+            if ( grid.size() != cells )
+                throw std::invalid_argument( "stencil: grid size does not match the extents" );
+            if ( scratch.size() != cells )
+                throw std::invalid_argument( "stencil: scratch size does not match the extents" );
+            if ( options.steps_per_sweep == 0 )
+                throw std::invalid_argument( "stencil: steps_per_sweep must be positive" );
+            std::size_t const tile[3] = { options.tile_x ? options.tile_x : automatic[0], options.tile_y ? options.tile_y : automatic[1],
+                                          g.planar ? 1 : ( options.tile_z ? options.tile_z : automatic[2] ) };
+
+            float16_t* from = grid.data();
+            float16_t* to = scratch.data();
+            for ( std::size_t done = 0; done < steps; done += options.steps_per_sweep )
+            {
+                stencil_sweep( w, g, from, to, std::min( options.steps_per_sweep, steps - done ), tile, options.threads );
+                std::swap( from, to );
+            }
+            if ( from != grid.data() )
+                parallel_for( 0, cells, std::size_t( 1 ) << 20, [&]( std::size_t first, std::size_t last )
+                {
+                    std::memcpy( grid.data() + first, from + first, ( last - first ) * sizeof( float16_t ) );
+                }, options.threads );
+        }
+
+    }//namespace float16_t_private
+
+    //
+    // advances the nx x ny grid by `steps` time steps in place; scratch is a second grid of the same size
+    // (its contents are overwritten). throws std::invalid_argument on mismatched sizes
+    //
+    inline void apply_stencil( stencil2d const& stencil, std::span<float16_t> grid, std::span<float16_t> scratch,
+                               std::size_t nx, std::size_t ny, std::size_t steps, stencil_options const& options = {} )
+    {
+        float w[3][3][3] = {};
+        std::memcpy( w[1], stencil.weights, sizeof( stencil.weights ) );
+        float16_t_private::stencil_run( w, { { nx, ny, 1 }, true }, grid, scratch, steps, options, { 256, 64, 1 } );
+    }
+
+    inline void apply_stencil( stencil3d const& stencil, std::span<float16_t> grid, std::span<float16_t> scratch,
+                               std::size_t nx, std::size_t ny, std::size_t nz, std::size_t steps, stencil_options const& options = {} )
+    {
+        float16_t_private::stencil_run( stencil.weights, { { nx, ny, nz }, false }, grid, scratch, steps, options, { 64, 32, 16 } );
+    }
+
+    // as above with a scratch grid allocated for the call
+    inline void apply_stencil( stencil2d const& stencil, std::span<float16_t> grid, std::size_t nx, std::size_t ny, std::size_t steps,
+                               stencil_options const& options = {} )
+    {
+        std::vector<float16_t> scratch( grid.size() );
+        apply_stencil( stencil, grid, scratch, nx, ny, steps, options );
+    }
+
+    inline void apply_stencil( stencil3d const& stencil, std::span<float16_t> grid, std::size_t nx, std::size_t ny, std::size_t nz,
+                               std::size_t steps, stencil_options const& options = {} )
+    {
+        std::vector<float16_t> scratch( grid.size() );
+        apply_stencil( stencil, grid, scratch, nx, ny, nz, steps, options );
+    }
+
+}//namespace numeric
+
+#endif
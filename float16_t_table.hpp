@@ -0,0 +1,209 @@
+#ifndef FLOAT16_T_TABLE_HPP_INCLUDED_SDFLKJ3049USDLFKJ3049USDLKFJ3094UFSDLKJ3049
+#define FLOAT16_T_TABLE_HPP_INCLUDED_SDFLKJ3049USDLFKJ3049USDLKFJ3094UFSDLKJ3049
+//
+// user-defined unary functions memoized over all 65536 half bit patterns.
+// tabulate( fn ) evaluates a float( float ) callable once per pattern (in parallel, so fn must be safe to call
+// concurrently) and rounds the results to halves, after which applying fn to any amount of data is a table
+// lookup: 16-bit gathers from the 128 KB table with AVX-512 or AVX2. compose() fuses two tables into one,
+// and save()/load() keep a table across runs in a small binary format:
+//   8 bytes "F16TABLE", u32 version (1), 65536 u16 entries, u64 content_hash64 of the entries, little-endian
+//
+#include "float16_t.hpp"
+#include "float16_t_hash.hpp"
+#include "float16_t_parallel.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__AVX512BW__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace numeric
+{
+    namespace float16_t_private
+    {
+        constexpr inline std::size_t table_entries = 65536;
+        constexpr inline std::size_t table_grain = std::size_t( 1 ) << 16;     // elements per lookup task
+        constexpr inline char table_magic[8] = { 'F', '1', '6', 'T', 'A', 'B', 'L', 'E' };
+        constexpr inline std::uint32_t table_version = 1;
+
+        // the nearest half, with overflow going to infinity rather than the NaN of float16_t{ float }
+        inline float16_t table_round( float y ) noexcept
+        {
+            if ( y >= 65520.0f ) return fp16_infinity;
+            if ( y <= -65520.0f ) return fp16_infinity_negative;
+            if ( y > 65504.0f ) return fp16_max;
+            if ( y < -65504.0f ) return -fp16_max;
+            return float16_t{ y };
+        }
+
+        template< std::size_t N >
+        void table_put( std::ostream& os, std::uint64_t v )
+        {
+            char bytes[N];
+            for ( std::size_t i = 0; i != N; ++i ) bytes[i] = static_cast<char>( v >> ( 8 * i ) );
+            os.write( bytes, N );
+        }
+
+        template< std::size_t N >
+        std::uint64_t table_get( std::istream& is )
+        {
+            unsigned char bytes[N];
+            if ( !is.read( reinterpret_cast<char*>( bytes ), N ) )
+                throw std::runtime_error( "half_table: truncated input" );
+            std::uint64_t v = 0;
+            for ( std::size_t i = 0; i != N; ++i ) v |= std::uint64_t( bytes[i] ) << ( 8 * i );
+            return v;
+        }
+
+        // out[i] = entries[in[i]]; entries holds one spare entry, so the 32-bit gather at the last pattern stays in bounds
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized" // gcc 12 trips over _mm512_undefined_epi32 in the AVX-512 intrinsics
+#endif
+        inline void table_lookup( float16_t const* entries, float16_t const* in, float16_t* out, std::size_t n ) noexcept
+        {
+            std::size_t i = 0;
+#if defined(__AVX512BW__)
+            int const* const table = reinterpret_cast<int const*>( entries );
+            for ( ; i + 16 <= n; i += 16 )
+            {
+                __m512i const index = _mm512_cvtepu16_epi32( _mm256_loadu_si256( reinterpret_cast<__m256i const*>( in + i ) ) );
+                __m512i const value = _mm512_i32gather_epi32( index, table, 2 );
+                _mm256_storeu_si256( reinterpret_cast<__m256i*>( out + i ), _mm512_cvtepi32_epi16( value ) );
+            }
+#elif defined(__AVX2__)
+            int const* const table = reinterpret_cast<int const*>( entries );
+            __m256i const low = _mm256_set1_epi32( 0xffff );
+            for ( ; i + 16 <= n; i += 16 )
+            {
+                __m256i const a = _mm256_cvtepu16_epi32( _mm_loadu_si128( reinterpret_cast<__m128i const*>( in + i ) ) );
+                __m256i const b = _mm256_cvtepu16_epi32( _mm_loadu_si128( reinterpret_cast<__m128i const*>( in + i + 8 ) ) );
+                __m256i const va = _mm256_and_si256( _mm256_i32gather_epi32( table, a, 2 ), low );
+                __m256i const vb = _mm256_and_si256( _mm256_i32gather_epi32( table, b, 2 ), low );
+                _mm256_storeu_si256( reinterpret_cast<__m256i*>( out + i ), _mm256_permute4x64_epi64( _mm256_packus_epi32( va, vb ), 0xd8 ) );
+            }
+#endif
+            for ( ; i != n; ++i )
+                out[i] = entries[std::uint16_t( in[i] )];
+        }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+    }//namespace float16_t_private
+
+    class half_table
+    {
+    public:
+        // the identity
+        half_table() : entries_( float16_t_private::table_entries + 1 )
+        {
+            for ( std::size_t i = 0; i != float16_t_private::table_entries; ++i )
+                entries_[i] = float16_t{ static_cast<std::uint16_t>( i ) };
+        }
+
+        // entries[i] is the result for the half with bit pattern i; throws std::invalid_argument unless there are 65536
+        explicit half_table( std::span<float16_t const> entries ) : entries_( float16_t_private::table_entries + 1 )
+        {
+            if ( entries.size() != float16_t_private::table_entries )
+                throw std::invalid_argument( "half_table: expected 65536 entries" );
+            std::copy( entries.begin(), entries.end(), entries_.begin() );
+        }
+
+        float16_t operator()( float16_t x ) const noexcept { return entries_[std::uint16_t( x )]; }
+
+        std::span<float16_t const> entries() const noexcept { return { entries_.data(), float16_t_private::table_entries }; }
+
+        //
+        // out[i] = table( in[i] ), in parallel for large inputs; in and out may be the same span.
+        // throws std::invalid_argument when the sizes differ
+        //
+        void apply( std::span<float16_t const> in, std::span<float16_t> out, std::size_t threads = 0 ) const
+        {
+            if ( in.size() != out.size() )
+                throw std::invalid_argument( "half_table::apply: input and output sizes differ" );
+            float16_t_private::parallel_for( 0, in.size(), float16_t_private::table_grain, [&]( std::size_t first, std::size_t last )
+            {
+                float16_t_private::table_lookup( entries_.data(), in.data() + first, out.data() + first, last - first );
+            }, threads );
+        }
+
+        void save( std::ostream& os ) const
+        {
+            os.write( float16_t_private::table_magic, sizeof( float16_t_private::table_magic ) );
+            float16_t_private::table_put<4>( os, float16_t_private::table_version );
+            std::array<char, 2 * 4096> buffer;
+            for ( std::size_t i = 0; i != float16_t_private::table_entries; i += 4096 )
+            {
+                for ( std::size_t k = 0; k != 4096; ++k )
+                {
+                    std::uint16_t const bits = std::uint16_t( entries_[i + k] );
+                    buffer[2 * k] = static_cast<char>( bits & 0xff );
+                    buffer[2 * k + 1] = static_cast<char>( bits >> 8 );
+                }
+                os.write( buffer.data(), std::streamsize( buffer.size() ) );
+            }
+            float16_t_private::table_put<8>( os, content_hash64( entries() ) );
+            if ( !os )
+                throw std::runtime_error( "half_table: write failed" );
+        }
+
+        // throws std::runtime_error on a foreign, truncated or corrupted stream
+        static half_table load( std::istream& is )
+        {
+            char magic[sizeof( float16_t_private::table_magic )];
+            if ( !is.read( magic, sizeof( magic ) ) || std::memcmp( magic, float16_t_private::table_magic, sizeof( magic ) ) != 0 )
+                throw std::runtime_error( "half_table: not a table" );
+            if ( float16_t_private::table_get<4>( is ) != float16_t_private::table_version )
+                throw std::runtime_error( "half_table: unsupported version" );
+            std::vector<float16_t> entries( float16_t_private::table_entries );
+            for ( auto& e : entries )
+                e = float16_t{ static_cast<std::uint16_t>( float16_t_private::table_get<2>( is ) ) };
+            if ( float16_t_private::table_get<8>( is ) != content_hash64( entries ) )
+                throw std::runtime_error( "half_table: checksum mismatch" );
+            return half_table{ entries };
+        }
+
+        friend bool operator == ( half_table const& a, half_table const& b ) noexcept
+        {
+            return std::equal( a.entries_.begin(), a.entries_.end() - 1, b.entries_.begin(), []( float16_t x, float16_t y ) { return std::uint16_t( x ) == std::uint16_t( y ); } );
+        }
+
+    private:
+        std::vector<float16_t> entries_;
+    };
+
+    // fn( x ) rounded to half for every half x, NaN inputs included
+    template< typename Fn >
+    half_table tabulate( Fn const& fn, std::size_t threads = 0 )
+    {
+        std::vector<float16_t> entries( float16_t_private::table_entries );
+        float16_t_private::parallel_for( 0, entries.size(), 4096, [&]( std::size_t first, std::size_t last )
+        {
+            for ( std::size_t i = first; i != last; ++i )
+                entries[i] = float16_t_private::table_round( static_cast<float>( fn( float( float16_t{ static_cast<std::uint16_t>( i ) } ) ) ) );
+        }, threads );
+        return half_table{ entries };
+    }
+
+    // the table applying `first` and then `second`: compose( f, g )( x ) == g( f( x ) )
+    inline half_table compose( half_table const& first, half_table const& second )
+    {
+        std::vector<float16_t> entries( float16_t_private::table_entries );
+        second.apply( first.entries(), entries );
+        return half_table{ entries };
+    }
+
+}//namespace numeric
+
+#endif
@@ -1,10 +1,46 @@
 #define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
 #include "catch.hpp"
 #include "../float16_t.hpp"
+#include "../float16_t_nn.hpp"
+#include "../float16_t_bvh.hpp"
+#include "../float16_t_mesh.hpp"
+#include "../float16_t_arrow.hpp"
+#include "../float16_t_dlpack.hpp"
+#include "../float16_t_safetensors.hpp"
+#include "../float16_t_parquet.hpp"
+#include "../float16_t_column.hpp"
+#include "../float16_t_dictionary.hpp"
+#include "../float16_t_bitmap_index.hpp"
+#include "../float16_t_groupby.hpp"
+#include "../float16_t_rolling.hpp"
+#include "../float16_t_cumulative.hpp"
+#include "../float16_t_ring.hpp"
+#include "../float16_t_loader.hpp"
+#include "../float16_t_checkpoint.hpp"
+#include "../float16_t_hash.hpp"
+#include "../float16_t_lu.hpp"
+#include "../float16_t_krylov.hpp"
+#include "../float16_t_stencil.hpp"
+#include "../float16_t_lut3d.hpp"
+#include "../float16_t_table.hpp"
+#include "../float16_t_poly.hpp"
+#ifdef __linux__
+#include "../float16_t_allreduce.hpp"
+#include <sys/wait.h>
+#endif
 #include <cmath>
 #include <iostream>
 #include <bitset>
 #include <limits>
+#include <vector>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <sstream>
 
 void print( float x )
 {
@@ -209,5 +245,1976 @@ TEST_CASE( "constant2", "[constant2]" )
     }
 }
 
+TEST_CASE( "softmax_cross_entropy", "[softmax_cross_entropy]" )
+{
+    using numeric::float16_t;
+
+    std::size_t const rows = 7;
+    std::size_t const classes = 1037; // spans several chunks with a ragged tail
+    std::vector<float16_t> logits( rows * classes );
+    for ( std::size_t i = 0; i != logits.size(); ++i )
+        logits[i] = float16_t{ std::sin( 0.37f * i ) * 6.0f };
+    std::vector<std::int64_t> labels{ 3, 1036, -100, 0, 512, 511, 77 };
+
+    numeric::cross_entropy_options opt;
+    opt.label_smoothing = 0.1f;
+    opt.grad_scale = 0.5f;
+    opt.threads = 3;
+
+    std::vector<float> loss( rows );
+    std::vector<float16_t> grad = logits; // in place
+    auto const valid = numeric::softmax_cross_entropy( logits, labels, classes, loss, grad, opt );
+    REQUIRE( valid == 6 );
+
+    for ( std::size_t r = 0; r != rows; ++r )
+    {
+        if ( labels[r] == opt.ignore_index )
+        {
+            REQUIRE( loss[r] == 0.0f );
+            for ( std::size_t c = 0; c != classes; ++c )
+                REQUIRE( float( grad[r*classes+c] ) == 0.0f );
+            continue;
+        }
+
+        double mx = -1.0e30, s = 0.0, sx = 0.0;
+        for ( std::size_t c = 0; c != classes; ++c )
+            mx = std::max( mx, double( float( logits[r*classes+c] ) ) );
+        for ( std::size_t c = 0; c != classes; ++c )
+        {
+            double const x = float( logits[r*classes+c] );
+            s += std::exp( x - mx );
+            sx += x;
+        }
+        double const lse = mx + std::log( s );
+        double const eps = opt.label_smoothing;
+        double const expected = lse - ( 1.0 - eps ) * float( logits[r*classes+labels[r]] ) - eps / classes * sx;
+        REQUIRE( std::abs( loss[r] - expected ) < 1.0e-3 );
+
+        for ( std::size_t c = 0; c != classes; ++c )
+        {
+            double const target = eps / classes + ( c == std::size_t( labels[r] ) ? 1.0 - eps : 0.0 );
+            double const g = ( std::exp( float( logits[r*classes+c] ) - lse ) - target ) * opt.grad_scale;
+            REQUIRE( std::abs( float( grad[r*classes+c] ) - g ) < 1.0e-3 );
+        }
+    }
+}
+
+TEST_CASE( "bulk_narrow", "[narrow]" )
+{
+    using numeric::float16_t;
+
+    // every float exactly halfway between two finite halves must round the same way at any position and length
+    std::size_t mismatches = 0;
+    for ( std::uint32_t bits = 0; bits != 0x7bff; ++bits )
+    {
+        for ( std::uint32_t sign : { 0x0000u, 0x8000u } )
+        {
+            float const lo = float( float16_t{ static_cast<std::uint16_t>( bits | sign ) } );
+            float const hi = float( float16_t{ static_cast<std::uint16_t>( ( bits + 1 ) | sign ) } );
+            float const tie = 0.5f * ( lo + hi );
+            std::vector<float> src( 9, tie );
+            std::vector<float16_t> whole( 9 ), single( 1 );
+            numeric::narrow( src.data(), whole.data(), whole.size() );
+            numeric::narrow( src.data(), single.data(), single.size() );
+            for ( std::size_t k = 1; k != whole.size(); ++k )
+                mismatches += std::uint16_t( whole[k] ) != std::uint16_t( whole[0] );
+            mismatches += std::uint16_t( single[0] ) != std::uint16_t( whole[0] );
+        }
+    }
+    REQUIRE( mismatches == 0 );
+}
+
+TEST_CASE( "embedding_bag", "[embedding_bag]" )
+{
+    using numeric::float16_t;
+
+    std::size_t const rows = 50;
+    std::size_t const dim = 19; // F16C body plus scalar tail
+    std::vector<float16_t> table( rows * dim );
+    for ( std::size_t i = 0; i != table.size(); ++i )
+        table[i] = float16_t{ std::cos( 0.11f * i ) };
+
+    std::vector<std::int64_t> indices{ 1, 4, 4, 49, 0, 7, 8, 9, 10, 11, 12, 13, 2 };
+    std::vector<std::int64_t> offsets{ 0, 3, 3, 5, 12 }; // bag 1 is empty
+    std::vector<float> weights( indices.size() );
+    for ( std::size_t k = 0; k != weights.size(); ++k )
+        weights[k] = 0.25f * ( k + 1 );
+
+    for ( auto mode : { numeric::embedding_bag_mode::sum, numeric::embedding_bag_mode::mean } )
+        for ( bool weighted : { false, true } )
+        {
+            std::vector<float> out( offsets.size() * dim, -1.0f );
+            numeric::embedding_bag( table, dim, indices, offsets, mode, out,
+                                    weighted ? std::span<float const>{ weights } : std::span<float const>{}, 2 );
+
+            for ( std::size_t b = 0; b != offsets.size(); ++b )
+            {
+                std::size_t const first = offsets[b];
+                std::size_t const last = b + 1 == offsets.size() ? indices.size() : offsets[b+1];
+                for ( std::size_t d = 0; d != dim; ++d )
+                {
+                    double expected = 0.0;
+                    for ( std::size_t k = first; k != last; ++k )
+                        expected += ( weighted ? weights[k] : 1.0 ) * float( table[indices[k]*dim+d] );
+                    if ( mode == numeric::embedding_bag_mode::mean && last > first )
+                        expected /= double( last - first );
+                    REQUIRE( std::abs( out[b*dim+d] - expected ) < 1.0e-4 );
+                }
+            }
+        }
+
+    // indices before the first bag would silently drop out of every bag
+    std::vector<std::int64_t> const late{ 2, 5 };
+    std::vector<float> out( late.size() * dim );
+    REQUIRE_THROWS_AS( numeric::embedding_bag( table, dim, indices, late, numeric::embedding_bag_mode::sum, out ), std::invalid_argument );
+}
+
+#ifdef __linux__
+TEST_CASE( "shm_allreduce", "[shm_allreduce]" )
+{
+    using numeric::float16_t;
+
+    std::size_t const world = 4;
+    std::size_t const n = 3001; // several pieces of `capacity`, ragged chunks
+    std::size_t const capacity = 1000;
+    std::string const name = "/float16_t_test_allreduce_" + std::to_string( getpid() );
+
+    auto const value = []( std::size_t rank, std::size_t i ) { return 0.001f * float( ( i * 7 + rank * 13 ) % 97 ); };
+
+    // a segment left behind by a run that crashed half way through its first barrier
+    {
+        std::size_t const bytes = sizeof( numeric::float16_t_private::shm_allreduce_header ) + world * capacity * sizeof( float16_t );
+        int const fd = shm_open( name.c_str(), O_CREAT | O_RDWR, 0600 );
+        REQUIRE( fd >= 0 );
+        REQUIRE( ftruncate( fd, static_cast<off_t>( bytes ) ) == 0 );
+        void* const p = mmap( nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+        close( fd );
+        REQUIRE( p != MAP_FAILED );
+        auto& h = *static_cast<numeric::float16_t_private::shm_allreduce_header*>( p );
+        h.arrived.store( world - 1 );
+        h.generation.store( 5 );
+        h.attached.store( 2 );
+        munmap( p, bytes );
+    }
+
+    std::vector<pid_t> children;
+    for ( std::size_t rank = 1; rank != world; ++rank )
+    {
+        pid_t const pid = fork();
+        REQUIRE( pid >= 0 );
+        if ( pid == 0 )
+        {
+            int status = 0;
+            try
+            {
+                numeric::shm_allreduce ar{ name, rank, world, capacity };
+                std::vector<float16_t> data( n );
+                for ( std::size_t i = 0; i != n; ++i ) data[i] = float16_t{ value( rank, i ) };
+                ar.allreduce( data );
+                ar.allreduce( data ); // sums of world identical buffers
+                for ( std::size_t i = 0; i != n; ++i )
+                {
+                    float expected = 0.0f;
+                    for ( std::size_t r = 0; r != world; ++r ) expected += float( float16_t{ value( r, i ) } );
+                    if ( std::abs( float( data[i] ) - expected * world ) > 0.02f ) status = 1;
+                }
+            }
+            catch ( ... ) { status = 2; }
+            _exit( status );
+        }
+        children.push_back( pid );
+    }
+
+    std::this_thread::sleep_for( std::chrono::milliseconds( 50 ) ); // let the other ranks find the stale segment first
+    numeric::shm_allreduce ar{ name, 0, world, capacity };
+    std::vector<float16_t> data( n );
+    for ( std::size_t i = 0; i != n; ++i ) data[i] = float16_t{ value( 0, i ) };
+    ar.allreduce( data );
+    for ( std::size_t i = 0; i != n; ++i )
+    {
+        float expected = 0.0f;
+        for ( std::size_t r = 0; r != world; ++r ) expected += float( float16_t{ value( r, i ) } );
+        REQUIRE( std::abs( float( data[i] ) - expected ) < 0.005f );
+    }
+    ar.allreduce( data );
+
+    for ( auto pid : children )
+    {
+        int status = -1;
+        REQUIRE( waitpid( pid, &status, 0 ) == pid );
+        REQUIRE( WIFEXITED( status ) );
+        REQUIRE( WEXITSTATUS( status ) == 0 );
+    }
+
+    // peers that never show up fail the attach instead of hanging it, and an oversized segment is refused
+    REQUIRE_THROWS_AS( ( numeric::shm_allreduce{ name, 0, 2, capacity, std::chrono::milliseconds( 50 ) } ), std::system_error );
+    REQUIRE( shm_open( name.c_str(), O_RDWR, 0600 ) < 0 );
+    REQUIRE_THROWS_AS( ( numeric::shm_allreduce{ name, 1, 2, capacity, std::chrono::milliseconds( 50 ) } ), std::system_error );
+    REQUIRE_THROWS_AS( ( numeric::shm_allreduce{ name, 0, 4, SIZE_MAX / 4 } ), std::invalid_argument );
+
+    // a peer that dies after attaching fails the next barrier
+    pid_t const quitter = fork();
+    REQUIRE( quitter >= 0 );
+    if ( quitter == 0 )
+    {
+        try { numeric::shm_allreduce ar{ name, 1, 2, capacity }; }
+        catch ( ... ) {}
+        _exit( 0 );
+    }
+    {
+        numeric::shm_allreduce lonely{ name, 0, 2, capacity, std::chrono::milliseconds( 100 ) };
+        REQUIRE_THROWS_AS( lonely.barrier(), std::system_error );
+    }
+    int status = -1;
+    REQUIRE( waitpid( quitter, &status, 0 ) == quitter );
+}
+#endif
+
+TEST_CASE( "round_down_up", "[round_down_up]" )
+{
+    using numeric::float16_t;
+
+    for ( float x = -70000.0f; x < 70000.0f; x += 13.37f )
+    {
+        float16_t const lo = numeric::round_down( x );
+        float16_t const hi = numeric::round_up( x );
+        REQUIRE( float( lo ) <= x );
+        REQUIRE( float( hi ) >= x );
+        REQUIRE( ( lo == hi || numeric::next_up( lo ) == hi ) );
+    }
+    for ( float x = -1.0e-6f; x < 1.0e-6f; x += 1.1e-8f )
+    {
+        REQUIRE( float( numeric::round_down( x ) ) <= x );
+        REQUIRE( float( numeric::round_up( x ) ) >= x );
+    }
+    REQUIRE( numeric::round_down( 1.0f ) == numeric::fp16_one );
+    REQUIRE( numeric::round_up( 1.0f ) == numeric::fp16_one );
+    REQUIRE( numeric::round_down( 1.0e6f ) == numeric::fp16_max );
+    REQUIRE( numeric::next_down( numeric::fp16_zero ) == float16_t{ static_cast<std::uint16_t>( 0x8001 ) } );
+}
+
+TEST_CASE( "bvh4", "[bvh4]" )
+{
+    std::vector<numeric::aabb> boxes( 5000 );
+    std::uint32_t seed = 12345;
+    auto const rnd = [&]() { seed = seed * 1664525u + 1013904223u; return float( seed >> 8 ) / float( 1u << 24 ); };
+    for ( auto& b : boxes )
+        for ( int a = 0; a != 3; ++a )
+        {
+            float const c = rnd() * 200.0f - 100.0f;
+            float const e = rnd() * 1.5f;
+            b.min[a] = c - e;
+            b.max[a] = c + e;
+        }
+
+    numeric::bvh4 const bvh{ boxes, 2 };
+    for ( auto const& node : bvh.nodes() )
+        for ( unsigned c = 0; c != 4; ++c )
+            if ( node.child[c] != 0xffffffffu )
+                REQUIRE( !numeric::bvh4::child_box( node, c ).empty() );
+
+    // traversal must report every primitive whose exact box is hit (the half boxes are conservative)
+    for ( int q = 0; q != 200; ++q )
+    {
+        numeric::ray r;
+        r.origin = { rnd() * 240.0f - 120.0f, rnd() * 240.0f - 120.0f, rnd() * 240.0f - 120.0f };
+        r.direction = { rnd() - 0.5f, rnd() - 0.5f, q % 7 == 0 ? 0.0f : rnd() - 0.5f };
+        r.t_max = 1000.0f;
+
+        std::vector<char> reported( boxes.size(), 0 );
+        bvh.intersect( r, [&]( std::uint32_t prim, float& ) { reported[prim] = 1; } );
+
+        for ( std::size_t i = 0; i != boxes.size(); ++i )
+        {
+            float tn = r.t_min, tf = r.t_max;
+            bool miss = false;
+            for ( int a = 0; a != 3; ++a )
+            {
+                if ( r.direction[a] == 0.0f )
+                {
+                    miss = miss || r.origin[a] < boxes[i].min[a] || r.origin[a] > boxes[i].max[a];
+                    continue;
+                }
+                float const t0 = ( boxes[i].min[a] - r.origin[a] ) / r.direction[a];
+                float const t1 = ( boxes[i].max[a] - r.origin[a] ) / r.direction[a];
+                tn = std::max( tn, std::min( t0, t1 ) );
+                tf = std::min( tf, std::max( t0, t1 ) );
+            }
+            if ( !miss && tn <= tf )
+                REQUIRE( reported[i] );
+        }
+    }
+
+    for ( int q = 0; q != 50; ++q )
+    {
+        numeric::aabb query;
+        for ( int a = 0; a != 3; ++a )
+        {
+            query.min[a] = rnd() * 200.0f - 100.0f;
+            query.max[a] = query.min[a] + rnd() * 30.0f;
+        }
+        std::vector<char> reported( boxes.size(), 0 );
+        bvh.intersect( query, [&]( std::uint32_t prim ) { reported[prim] = 1; } );
+        for ( std::size_t i = 0; i != boxes.size(); ++i )
+            if ( boxes[i].overlaps( query ) )
+                REQUIRE( reported[i] );
+    }
+
+    // closest hit along a row of boxes: leaves are visited nearest first and pruned by the shrinking t_max,
+    // so only the primitives near the first hit reach the callback
+    {
+        std::vector<numeric::aabb> row( 256 );
+        for ( std::size_t i = 0; i != row.size(); ++i )
+        {
+            row[i].min = { 3.0f * float( i ), 0.0f, 0.0f };
+            row[i].max = { 3.0f * float( i ) + 1.0f, 1.0f, 1.0f };
+        }
+        numeric::bvh4 const line{ row, 1 };
+        numeric::ray r;
+        r.origin = { -5.0f, 0.5f, 0.5f };
+        r.direction = { 1.0f, 0.0f, 0.0f };
+        r.t_max = 10000.0f;
+        std::size_t calls = 0;
+        std::uint32_t closest = 0xffffffffu;
+        line.intersect( r, [&]( std::uint32_t prim, float& t_max )
+        {
+            ++calls;
+            float const t = row[prim].min[0] - r.origin[0];
+            if ( t < t_max ) { t_max = t; closest = prim; }
+        } );
+        REQUIRE( closest == 0 );
+        // the leaf holding box 0 is the nearest, every other leaf starts beyond its hit
+        std::size_t nearest_leaf = 0;
+        for ( auto const& node : line.nodes() )
+            for ( unsigned c = 0; c != 4; ++c )
+            {
+                std::uint32_t const child = node.child[c];
+                if ( child == 0xffffffffu || !( child & numeric::float16_t_private::bvh_leaf_flag ) )
+                    continue;
+                std::uint32_t const first = ( child & ~numeric::float16_t_private::bvh_leaf_flag ) >> numeric::float16_t_private::bvh_leaf_count_bits;
+                std::uint32_t const count = child & numeric::float16_t_private::bvh_max_leaf_size;
+                for ( std::uint32_t i = first; i != first + count; ++i )
+                    if ( line.primitive_indices()[i] == 0 )
+                        nearest_leaf = count;
+            }
+        REQUIRE( nearest_leaf != 0 );
+        REQUIRE( calls == nearest_leaf );
+    }
+
+    // above bvh_parallel_threshold the subtrees are built with std::async and the SAH bins per thread;
+    // the result must answer queries exactly like a single-threaded build
+    std::vector<numeric::aabb> many( 40000 );
+    for ( auto& b : many )
+        for ( int a = 0; a != 3; ++a )
+        {
+            float const c = rnd() * 400.0f - 200.0f;
+            float const e = rnd() * 1.5f;
+            b.min[a] = c - e;
+            b.max[a] = c + e;
+        }
+    numeric::bvh4 const serial{ many, 1 };
+    numeric::bvh4 const parallel{ many, 4 };
+    auto const hits = []( numeric::bvh4 const& tree, auto const& query )
+    {
+        std::vector<std::uint32_t> found;
+        if constexpr ( std::is_same_v<std::decay_t<decltype( query )>, numeric::ray> )
+            tree.intersect( query, [&]( std::uint32_t prim, float& ) { found.push_back( prim ); } );
+        else
+            tree.intersect( query, [&]( std::uint32_t prim ) { found.push_back( prim ); } );
+        std::sort( found.begin(), found.end() );
+        return found;
+    };
+    for ( int q = 0; q != 100; ++q )
+    {
+        numeric::ray r;
+        r.origin = { rnd() * 480.0f - 240.0f, rnd() * 480.0f - 240.0f, rnd() * 480.0f - 240.0f };
+        r.direction = { rnd() - 0.5f, rnd() - 0.5f, rnd() - 0.5f };
+        r.t_max = 2000.0f;
+        auto const expected = hits( serial, r );
+        REQUIRE( hits( parallel, r ) == expected );
+
+        numeric::aabb query;
+        for ( int a = 0; a != 3; ++a )
+        {
+            query.min[a] = rnd() * 400.0f - 200.0f;
+            query.max[a] = query.min[a] + rnd() * 40.0f;
+        }
+        auto const inside = hits( serial, query );
+        REQUIRE( hits( parallel, query ) == inside );
+        for ( std::size_t i = 0; i != many.size(); ++i )
+            if ( many[i].overlaps( query ) )
+                REQUIRE( std::binary_search( inside.begin(), inside.end(), std::uint32_t( i ) ) );
+    }
+}
+
+TEST_CASE( "mesh_codecs", "[mesh_codecs]" )
+{
+    using numeric::float16_t;
+
+    std::size_t const vertices = 2000;
+    std::vector<float> positions( 3 * vertices ), normals( 3 * vertices ), uvs( 2 * vertices );
+    for ( std::size_t i = 0; i != vertices; ++i )
+    {
+        // a long strip far from the origin, where absolute half coordinates would be useless
+        positions[3*i]   = 10000.0f + 0.5f * i;
+        positions[3*i+1] = -2000.0f + std::sin( 0.1f * i );
+        positions[3*i+2] = 3.0f * std::cos( 0.07f * i );
+
+        float const theta = 0.013f * i, phi = 0.37f * i;
+        normals[3*i]   = std::sin( theta ) * std::cos( phi );
+        normals[3*i+1] = std::sin( theta ) * std::sin( phi );
+        normals[3*i+2] = std::cos( theta );
+
+        uvs[2*i]   = 0.0005f * i;
+        uvs[2*i+1] = 1.0f - 0.0003f * i;
+    }
+
+    {
+        std::size_t const chunk = 64;
+        std::vector<float16_t> encoded( positions.size() );
+        std::vector<float> offsets( 3 * ( ( vertices + chunk - 1 ) / chunk ) );
+        auto const err = numeric::encode_positions( positions, chunk, encoded, offsets );
+        REQUIRE( err.max < 0.01f );
+        REQUIRE( err.rms <= err.max );
+
+        std::vector<float> decoded( positions.size() );
+        numeric::decode_positions( encoded, chunk, offsets, decoded );
+        float worst = 0.0f;
+        for ( std::size_t i = 0; i != positions.size(); ++i )
+            worst = std::max( worst, std::abs( decoded[i] - positions[i] ) );
+        REQUIRE( worst <= err.max + 1.0e-3f );
+    }
+
+    auto const check_normals = [&]( auto const& encoded, numeric::codec_error err, float bound )
+    {
+        REQUIRE( err.max < bound );
+        std::vector<float> decoded( normals.size() );
+        numeric::decode_normals( encoded, decoded );
+        for ( std::size_t i = 0; i != vertices; ++i )
+        {
+            double const d = normals[3*i] * double( decoded[3*i] ) + normals[3*i+1] * double( decoded[3*i+1] ) + normals[3*i+2] * double( decoded[3*i+2] );
+            REQUIRE( std::acos( std::min( d, 1.0 ) ) <= err.max + 1.0e-3 );
+        }
+    };
+    {
+        std::vector<float16_t> encoded( 2 * vertices );
+        auto const err = numeric::encode_normals( normals, encoded );
+        check_normals( std::span<float16_t const>{ encoded }, err, 2.0e-3f );
+    }
+    {
+        std::vector<std::int16_t> encoded( 2 * vertices );
+        auto const err = numeric::encode_normals( normals, encoded );
+        check_normals( std::span<std::int16_t const>{ encoded }, err, 2.0e-4f );
+    }
+
+    {
+        std::vector<float16_t> encoded( uvs.size() );
+        auto const err = numeric::encode_uvs( uvs, encoded );
+        REQUIRE( err.max < 1.0e-3f );
+        std::vector<float> decoded( uvs.size() );
+        numeric::decode_uvs( encoded, decoded );
+        for ( std::size_t i = 0; i != uvs.size(); ++i )
+            REQUIRE( std::abs( decoded[i] - uvs[i] ) <= err.max );
+    }
+}
+
+TEST_CASE( "arrow_c_data_interface", "[arrow]" )
+{
+    using numeric::float16_t;
+
+    auto values = std::make_shared<std::vector<float16_t>>( 21 );
+    for ( std::size_t i = 0; i != values->size(); ++i )
+        (*values)[i] = float16_t{ 0.5f * i };
+    auto validity = std::make_shared<std::vector<std::uint8_t>>( std::vector<std::uint8_t>{ 0xff, 0xfb, 0x0e } ); // 10, 16 and 20 are null
+
+    struct buffers { std::shared_ptr<std::vector<float16_t>> v; std::shared_ptr<std::vector<std::uint8_t>> b; };
+    auto owner = std::make_shared<buffers>( buffers{ values, validity } );
+
+    ArrowArray array;
+    ArrowSchema schema;
+    numeric::export_arrow( *values, *validity, owner, &array, &schema, "score" );
+    owner.reset();
+    REQUIRE( values.use_count() == 2 );
+    REQUIRE( std::string( schema.format ) == "e" );
+    REQUIRE( std::string( schema.name ) == "score" );
+    REQUIRE( schema.flags == ARROW_FLAG_NULLABLE );
+    REQUIRE( array.length == 21 );
+    REQUIRE( array.null_count == 3 );
+
+    {
+        numeric::arrow_float16_array imported{ &array, &schema };
+        REQUIRE( array.release == nullptr ); // moved
+        auto const view = imported.values();
+        REQUIRE( view.data() == values->data() ); // zero copy
+        REQUIRE( view.size() == 21 );
+        for ( std::size_t i = 0; i != view.size(); ++i )
+        {
+            REQUIRE( view[i] == (*values)[i] );
+            REQUIRE( imported.valid( i ) == ( i != 10 && i != 16 && i != 20 ) );
+        }
+
+        numeric::arrow_float16_array moved{ std::move( imported ) };
+        REQUIRE( imported.size() == 0 );
+        REQUIRE( moved.size() == 21 );
+        REQUIRE( values.use_count() == 2 );
+    }
+    REQUIRE( values.use_count() == 1 ); // released by the consumer
+
+    schema.release( &schema );
+    REQUIRE( schema.release == nullptr );
+
+    ArrowSchema wrong = schema;
+    wrong.format = "f";
+    wrong.release = nullptr;
+    ArrowArray plain;
+    numeric::export_arrow( *values, {}, values, &plain, &schema );
+    REQUIRE( plain.null_count == 0 );
+    REQUIRE_THROWS_AS( numeric::arrow_float16_array( &plain, &wrong ), std::invalid_argument );
+    REQUIRE( plain.release != nullptr );
+    plain.release( &plain );
+    schema.release( &schema );
+}
+
+TEST_CASE( "dlpack", "[dlpack]" )
+{
+    using numeric::float16_t;
+
+    auto storage = std::make_shared<std::vector<float16_t>>( 3 * 4 );
+    for ( std::size_t i = 0; i != storage->size(); ++i )
+        (*storage)[i] = float16_t{ float( i ) };
+
+    DLManagedTensor* managed = numeric::to_dlpack( storage->data(), { 3, 4 }, {}, storage );
+    REQUIRE( storage.use_count() == 2 );
+    REQUIRE( managed->dl_tensor.dtype.code == kDLFloat );
+    REQUIRE( managed->dl_tensor.dtype.bits == 16 );
+    REQUIRE( managed->dl_tensor.strides[0] == 4 );
+    {
+        numeric::dlpack_float16_tensor tensor{ managed };
+        REQUIRE( tensor.data() == storage->data() );
+        REQUIRE( tensor.size() == 12 );
+        REQUIRE( tensor.is_contiguous() );
+        REQUIRE( tensor.values().size() == 12 );
+        std::int64_t const idx[2] = { 2, 1 };
+        REQUIRE( float( tensor[idx] ) == 9.0f );
+        tensor[idx] = float16_t{ -1.0f };
+        REQUIRE( float( (*storage)[9] ) == -1.0f );
+    }
+    REQUIRE( storage.use_count() == 1 );
+
+    // transposed view: shape 4x3 with strides (1, 4)
+    {
+        numeric::dlpack_float16_tensor tensor{ numeric::to_dlpack( storage->data(), { 4, 3 }, { 1, 4 }, storage ) };
+        REQUIRE_FALSE( tensor.is_contiguous() );
+        REQUIRE_THROWS_AS( tensor.values(), std::logic_error );
+        std::int64_t const idx[2] = { 3, 2 };
+        REQUIRE( float( tensor[idx] ) == 11.0f );
+    }
+    REQUIRE( storage.use_count() == 1 );
+
+    {
+        DLManagedTensor* wrong = numeric::to_dlpack( storage->data(), { 12 }, {}, storage );
+        wrong->dl_tensor.dtype.bits = 32;
+        REQUIRE_THROWS_AS( numeric::dlpack_float16_tensor{ wrong }, std::invalid_argument );
+        REQUIRE( storage.use_count() == 1 ); // rejected tensors are still deleted
+    }
+    {
+        DLManagedTensor* negative = numeric::to_dlpack( storage->data(), { 12 }, {}, storage );
+        negative->dl_tensor.ndim = -1;
+        REQUIRE_THROWS_AS( numeric::dlpack_float16_tensor{ negative }, std::invalid_argument );
+        DLManagedTensor* shapeless = numeric::to_dlpack( storage->data(), { 12 }, {}, storage );
+        shapeless->dl_tensor.shape = nullptr;
+        REQUIRE_THROWS_AS( numeric::dlpack_float16_tensor{ shapeless }, std::invalid_argument );
+        REQUIRE( storage.use_count() == 1 );
+    }
+}
+
+TEST_CASE( "safetensors", "[safetensors]" )
+{
+    using numeric::float16_t;
+
+    auto const path = ( std::filesystem::temp_directory_path() / ( "float16_t_test_" + std::to_string( ::getpid() ) + ".safetensors" ) ).string();
+
+    std::vector<float16_t> a( 6 ), b( 1000 );
+    for ( std::size_t i = 0; i != a.size(); ++i ) a[i] = float16_t{ 0.25f * i };
+    for ( std::size_t i = 0; i != b.size(); ++i ) b[i] = float16_t{ std::sin( 0.01f * i ) };
+
+    {
+        numeric::safetensors_writer writer{ path, { { "layer.\"a\"", "F16", { 2, 3 } }, { "empty", "F16", { 0 } }, { "b", "F16", { 10, 100 } } },
+                                            { { "format", "pt" } } };
+        writer.write( std::span<float16_t const>{ a }.first( 4 ) );
+        writer.write( std::span<float16_t const>{ a }.subspan( 4 ) );
+        for ( std::size_t i = 0; i < b.size(); i += 333 )
+            writer.write( std::span<float16_t const>{ b }.subspan( i, std::min<std::size_t>( 333, b.size() - i ) ) );
+        REQUIRE_THROWS_AS( writer.write( a ), std::length_error );
+        writer.close();
+    }
+
+    {
+        numeric::safetensors_reader reader{ path };
+        REQUIRE( reader.tensors().size() == 3 );
+        REQUIRE( reader.metadata().at( "format" ) == "pt" );
+        auto const va = reader.view( "layer.\"a\"" );
+        REQUIRE( va.size() == 6 );
+        REQUIRE( reinterpret_cast<std::uintptr_t>( va.data() ) % 64 == 0 ); // data section is 64 byte aligned
+        for ( std::size_t i = 0; i != a.size(); ++i ) REQUIRE( va[i] == a[i] );
+        REQUIRE( reader.view( "empty" ).empty() );
+        auto const vb = reader.view( "b" );
+        REQUIRE( reader.tensor( "b" ).shape == std::vector<std::int64_t>{ 10, 100 } );
+        for ( std::size_t i = 0; i != b.size(); ++i ) REQUIRE( vb[i] == b[i] );
+        REQUIRE_THROWS_AS( reader.view( "missing" ), std::out_of_range );
+    }
+
+    // a hand written header with other dtypes, unknown keys and whitespace
+    {
+        std::string header = R"( { "x" : { "dtype" : "F32", "shape" : [ 1 ], "data_offsets" : [ 0, 4 ], "extra" : [ true, null, -1.5e3, { "k" : "v" } ] } ,
+                                 "y" : { "dtype":"F16","shape":[2],"data_offsets":[4,8]}, "__metadata__" : { "n\u0041me" : "t\tab" } } )";
+        while ( ( 8 + header.size() ) % 8 != 0 ) header += ' '; // as written by the reference implementation
+        std::ofstream out{ path, std::ios::binary | std::ios::trunc };
+        std::uint64_t const n = header.size();
+        for ( int i = 0; i != 8; ++i ) out.put( static_cast<char>( n >> ( 8 * i ) ) );
+        out << header;
+        float const one = 1.0f;
+        out.write( reinterpret_cast<char const*>( &one ), 4 );
+        std::uint16_t const halves[2] = { 0x3c00, 0xc000 };
+        out.write( reinterpret_cast<char const*>( halves ), 4 );
+        out.close();
+
+        numeric::safetensors_reader reader{ path };
+        REQUIRE( reader.metadata().at( "nAme" ) == "t\tab" );
+        REQUIRE( reader.bytes( "x" ).size() == 4 );
+        REQUIRE_THROWS_AS( reader.view( "x" ), std::invalid_argument );
+        auto const vy = reader.view( "y" );
+        REQUIRE( float( vy[0] ) == 1.0f );
+        REQUIRE( float( vy[1] ) == -2.0f );
+    }
+
+    // offsets beyond the end of the file
+    {
+        std::string const header = R"({"y":{"dtype":"F16","shape":[4],"data_offsets":[0,8]}})";
+        std::ofstream out{ path, std::ios::binary | std::ios::trunc };
+        std::uint64_t const n = header.size();
+        for ( int i = 0; i != 8; ++i ) out.put( static_cast<char>( n >> ( 8 * i ) ) );
+        out << header << "abcd";
+        out.close();
+        REQUIRE_THROWS_AS( numeric::safetensors_reader{ path }, std::runtime_error );
+    }
+
+    // malformed escapes and shapes whose element count would wrap around
+    for ( std::string const header : std::initializer_list<std::string>{ R"({"\u12zz":{"dtype":"F16","shape":[0],"data_offsets":[0,0]}})",
+                                                                      R"({"\uzz12":{"dtype":"F16","shape":[0],"data_offsets":[0,0]}})",
+                                                                      R"({"y":{"dtype":"F16","shape":[4294967296,4294967296],"data_offsets":[0,0]}})",
+                                                                      R"({"y":{"dtype":"F16","shape":[99999999999999999999],"data_offsets":[0,0]}})",
+                                                                      R"({"\q":{"dtype":"F16","shape":[0],"data_offsets":[0,0]}})",
+                                                                      R"({"y":{"dtype":"F16","shape":[0],"data_offsets":[0,0],"deep":)" + std::string( 100000, '[' ) } )
+    {
+        std::ofstream out{ path, std::ios::binary | std::ios::trunc };
+        std::uint64_t const n = header.size();
+        for ( int i = 0; i != 8; ++i ) out.put( static_cast<char>( n >> ( 8 * i ) ) );
+        out << header;
+        out.close();
+        REQUIRE_THROWS_AS( numeric::safetensors_reader{ path }, std::runtime_error );
+    }
+    REQUIRE_THROWS_AS( ( numeric::safetensors_writer{ path, { { "huge", "F16", { std::int64_t( 1 ) << 62, 4 } } } } ), std::overflow_error );
+
+    std::filesystem::remove( path );
+}
+
+TEST_CASE( "parquet", "[parquet]" )
+{
+    auto const path = ( std::filesystem::temp_directory_path() / "float16_t_test.parquet" ).string();
+
+    std::vector<numeric::float16_t> values( 2500 );
+    for ( std::size_t i = 0; i != values.size(); ++i )
+        values[i] = numeric::float16_t{ std::sin( float( i ) * 0.37f ) * 100.0f };
+    values[3] = numeric::float16_t{ std::uint16_t( 0x7e00 ) };     // NaN, left out of the statistics
+    values[1100] = numeric::float16_t{ std::uint16_t( 0x7c00 ) };  // +inf
+
+    for ( auto encoding : { numeric::parquet_encoding::plain, numeric::parquet_encoding::byte_stream_split } )
+    {
+        {
+            numeric::parquet_float16_writer writer{ path, "h", encoding, 1000 };
+            writer.write( std::span{ values }.first( 700 ) );
+            writer.write( std::span{ values }.subspan( 700 ) );
+            writer.close();
+        }
+
+        numeric::parquet_float16_reader reader{ path };
+        REQUIRE( reader.column() == "h" );
+        REQUIRE( reader.rows() == values.size() );
+
+        std::vector<numeric::float16_t> page;
+        std::size_t offset = 0, pages = 0;
+        while ( auto info = reader.read_page( page ) )
+        {
+            REQUIRE( info->values == page.size() );
+            REQUIRE( page.size() == std::min<std::size_t>( 1000, values.size() - offset ) );
+            std::uint16_t lo = 0xffff, hi = 0;
+            for ( std::size_t i = 0; i != page.size(); ++i )
+            {
+                REQUIRE( std::uint16_t( page[i] ) == std::uint16_t( values[offset+i] ) );
+                if ( ( std::uint16_t( page[i] ) & 0x7fff ) > 0x7c00 ) continue;
+                lo = std::min( lo, numeric::order_key( page[i] ) );
+                hi = std::max( hi, numeric::order_key( page[i] ) );
+            }
+            REQUIRE( info->min.has_value() );
+            REQUIRE( numeric::order_key( *info->min ) == lo );
+            REQUIRE( numeric::order_key( *info->max ) == hi );
+            offset += page.size();
+            ++pages;
+        }
+        REQUIRE( offset == values.size() );
+        REQUIRE( pages == 3 );
+    }
+
+    // all-NaN pages carry no min/max, zero bounds are reported as -0 (min) and +0 (max)
+    {
+        std::vector<numeric::float16_t> const special = { numeric::float16_t{ std::uint16_t( 0x7e00 ) }, numeric::float16_t{ std::uint16_t( 0xfe01 ) },
+                                                          numeric::float16_t{ std::uint16_t( 0x0000 ) }, numeric::float16_t{ std::uint16_t( 0x0000 ) } };
+        numeric::parquet_float16_writer writer{ path, "z", numeric::parquet_encoding::plain, 2 };
+        writer.write( special );
+        writer.close();
+
+        numeric::parquet_float16_reader reader{ path };
+        std::vector<numeric::float16_t> page;
+        auto first = reader.read_page( page );
+        REQUIRE( first );
+        REQUIRE( !first->min );
+        REQUIRE( !first->max );
+        auto second = reader.read_page( page );
+        REQUIRE( second );
+        REQUIRE( std::uint16_t( *second->min ) == 0x8000 );
+        REQUIRE( std::uint16_t( *second->max ) == 0x0000 );
+        REQUIRE( !reader.read_page( page ) );
+    }
+
+    // an empty column still gets one (empty) page and a valid footer
+    {
+        numeric::parquet_float16_writer writer{ path, "e" };
+        writer.close();
+        numeric::parquet_float16_reader reader{ path };
+        REQUIRE( reader.rows() == 0 );
+        std::vector<numeric::float16_t> page;
+        while ( reader.read_page( page ) ) REQUIRE( page.empty() );
+    }
+
+    {
+        std::ofstream out{ path, std::ios::binary | std::ios::trunc };
+        out << "PAR1 not a parquet file";
+    }
+    REQUIRE_THROWS_AS( numeric::parquet_float16_reader{ path }, std::runtime_error );
+
+    std::filesystem::remove( path );
+}
+
+TEST_CASE( "float16_column", "[column]" )
+{
+    using numeric::float16_t;
+    using numeric::value_range;
+
+    // predicates on special values
+    REQUIRE( value_range::equal( float16_t{ 0.0f } ).contains( float16_t{ std::uint16_t( 0x8000 ) } ) );
+    REQUIRE( !value_range::greater( float16_t{ std::uint16_t( 0x8000 ) } ).contains( float16_t{ 0.0f } ) );
+    REQUIRE( !value_range::less( float16_t{ 0.0f } ).contains( float16_t{ std::uint16_t( 0x8000 ) } ) );
+    REQUIRE( value_range::greater( numeric::fp16_infinity ).empty() );
+    REQUIRE( value_range::equal( float16_t{ std::uint16_t( 0x7e00 ) } ).empty() );
+    REQUIRE( !value_range::greater_equal( numeric::fp16_infinity_negative ).contains( float16_t{ std::uint16_t( 0xfe00 ) } ) );
+    REQUIRE( !value_range::greater_equal( numeric::fp16_infinity_negative ).contains( float16_t{ std::uint16_t( 0x7e00 ) } ) );
+
+    // sorted-ish data so zone maps can prune: block b holds values around b
+    std::size_t const rows = 10 * 1024 + 37;
+    std::vector<float16_t> values( rows );
+    std::vector<std::uint8_t> validity( ( rows + 7 ) / 8, 0xff );
+    for ( std::size_t i = 0; i != rows; ++i )
+        values[i] = float16_t{ float( i / 1024 ) + float( i % 97 ) / 128.0f };
+    values[5000] = float16_t{ std::uint16_t( 0x7e00 ) };
+    for ( std::size_t i = 3000; i < 4000; i += 7 )
+        validity[i / 8] &= static_cast<std::uint8_t>( ~( 1u << ( i % 8 ) ) );
+
+    numeric::float16_column column{ 1000 };  // rounded up to 1024
+    REQUIRE( column.block_size() == 1024 );
+    column.append( std::span{ values }.first( 2500 ) );
+    column.append( std::span{ values }.subspan( 2500, 1000 ), std::span{ validity }.subspan( 2500 / 8 ) );
+    column.append( std::span{ values }.subspan( 3500 ), std::span{ validity }.subspan( 3500 / 8 ) );
+    REQUIRE( column.size() == rows );
+    REQUIRE( column.zones().size() == 11 );
+    REQUIRE( column.zones()[4].nan_count == 1 );
+    REQUIRE( column.zones()[3].null_count > 0 );
+    REQUIRE( column.zones()[10].size == 37 );
+    REQUIRE( float( column.zones()[7].min() ) == 7.0f );
+
+    auto const check = [&]( value_range const& range, std::size_t threads )
+    {
+        auto const result = column.scan( range, threads );
+        std::size_t expected = 0;
+        for ( std::size_t i = 0; i != rows; ++i )
+        {
+            bool const hit = column.valid( i ) && range.contains( values[i] );
+            expected += hit;
+            REQUIRE( result.selected( i ) == hit );
+        }
+        REQUIRE( result.matches == expected );
+        REQUIRE( result.blocks_skipped + result.blocks_accepted + result.blocks_scanned == 11 );
+        REQUIRE( ( result.selection.back() >> ( rows % 64 ) ) == 0 );
+        return result;
+    };
+
+    auto const gt = check( value_range::greater( float16_t{ 7.5f } ), 3 );
+    REQUIRE( gt.blocks_skipped == 7 );
+    REQUIRE( gt.blocks_accepted == 3 );
+    auto const band = check( value_range::between( float16_t{ 3.25f }, float16_t{ 4.5f } ), 0 );
+    REQUIRE( band.blocks_skipped == 9 );
+    check( value_range::less_equal( float16_t{ 2.0f } ), 1 );
+    check( value_range::equal( float16_t{ 3.5f } ), 2 );
+    REQUIRE( column.scan( value_range::equal( float16_t{ std::uint16_t( 0x7e00 ) } ) ).matches == 0 );
+
+    // random bits, including NaNs, infinities and zeros of both signs, against the scalar predicate
+    std::vector<float16_t> noise( 4099 );
+    std::uint32_t state = 12345;
+    for ( auto& v : noise )
+    {
+        state = state * 1664525u + 1013904223u;
+        v = float16_t{ static_cast<std::uint16_t>( state >> 16 ) };
+    }
+    noise[1] = float16_t{ std::uint16_t( 0x8000 ) };
+    noise[2] = float16_t{ std::uint16_t( 0x0000 ) };
+    numeric::float16_column random_column{ 512 };
+    random_column.append( noise );
+    for ( auto range : { value_range::between( float16_t{ -1.0f }, float16_t{ 0.0f } ), value_range::greater( float16_t{ -100.0f } ),
+                         value_range::less( float16_t{ std::uint16_t( 0x8000 ) } ), value_range::greater_equal( numeric::fp16_infinity_negative ) } )
+    {
+        auto const result = random_column.scan( range );
+        for ( std::size_t i = 0; i != noise.size(); ++i )
+            REQUIRE( result.selected( i ) == range.contains( noise[i] ) );
+    }
+}
+
+TEST_CASE( "dictionary_encoding", "[dictionary]" )
+{
+    using numeric::float16_t;
+
+    auto const round_trip = [&]( std::vector<float16_t> const& values, numeric::encoded_halves const& enc )
+    {
+        std::vector<float16_t> halves( values.size() );
+        std::vector<float> floats( values.size() );
+        numeric::decode_column( enc, halves );
+        numeric::decode_column( enc, floats );
+        for ( std::size_t i = 0; i != values.size(); ++i )
+        {
+            REQUIRE( std::uint16_t( halves[i] ) == std::uint16_t( values[i] ) );
+            if ( ( std::uint16_t( values[i] ) & 0x7fff ) <= 0x7c00 )
+                REQUIRE( floats[i] == float( values[i] ) );
+        }
+    };
+
+    // quantized scores, 201 distinct values including -0, +0 and a NaN payload
+    std::vector<float16_t> scores( 10007 );
+    std::uint32_t state = 7;
+    for ( auto& v : scores )
+    {
+        state = state * 1664525u + 1013904223u;
+        v = float16_t{ float( ( state >> 8 ) % 200 ) / 64.0f - 1.0f };
+    }
+    scores[17] = float16_t{ std::uint16_t( 0x8000 ) };
+    scores[18] = float16_t{ std::uint16_t( 0x7e01 ) };
+
+    auto const enc = numeric::encode_column( scores );
+    REQUIRE( enc.encoding == numeric::half_encoding::dictionary );
+    REQUIRE( enc.values.size() == 202 );
+    REQUIRE( enc.bit_width == 8 );
+    REQUIRE( std::is_sorted( enc.values.begin(), enc.values.end(), []( float16_t a, float16_t b ) { return std::uint16_t( a ) < std::uint16_t( b ); } ) );
+    REQUIRE( enc.bytes() == 2 * 202 + scores.size() );
+    for ( std::size_t n : { std::size_t( 0 ), std::size_t( 1 ), std::size_t( 7 ), std::size_t( 15 ), std::size_t( 16 ), std::size_t( 33 ), scores.size() } )
+    {
+        std::vector<float16_t> const part( scores.begin(), scores.begin() + static_cast<std::ptrdiff_t>( n ) );
+        round_trip( part, numeric::encode_dictionary( part ) );
+    }
+    round_trip( scores, enc );
+
+    // every width from 1 to 16 bits
+    for ( unsigned width = 1; width <= 16; ++width )
+    {
+        std::vector<float16_t> values( std::max<std::size_t>( 4096, std::size_t( 1 ) << width ) + 3 );
+        for ( std::size_t i = 0; i != values.size(); ++i )
+            values[i] = float16_t{ static_cast<std::uint16_t>( ( i * 40503u ) % ( 1u << width ) ) };
+        values.push_back( float16_t{ std::uint16_t( 0xffff ) } );
+        auto const e = numeric::encode_dictionary( values );
+        REQUIRE( e.bit_width == std::min( width + 1, 16u ) );
+        round_trip( values, e );
+    }
+
+    // a constant column needs no index bits
+    std::vector<float16_t> const constant( 1000, float16_t{ 2.5f } );
+    auto const c = numeric::encode_column( constant );
+    REQUIRE( c.bit_width == 0 );
+    REQUIRE( c.bytes() == 2 );
+    round_trip( constant, c );
+
+    // high-cardinality data stays raw
+    std::vector<float16_t> noise( 3000 );
+    for ( std::size_t i = 0; i != noise.size(); ++i )
+        noise[i] = float16_t{ static_cast<std::uint16_t>( i * 7919u ) };
+    auto const raw = numeric::encode_column( noise );
+    REQUIRE( raw.encoding == numeric::half_encoding::raw );
+    round_trip( noise, raw );
+
+    std::vector<float16_t> small( 3 );
+    REQUIRE_THROWS_AS( numeric::decode_column( enc, small ), std::invalid_argument );
+}
+
+TEST_CASE( "float16_bitmap_index", "[bitmap_index]" )
+{
+    using numeric::float16_t;
+    using numeric::value_range;
+
+    // two full containers and a partial one; dense values near zero, sparse tails and special values
+    std::vector<float16_t> values( 2 * 65536 + 1234 );
+    std::uint32_t state = 99;
+    for ( std::size_t i = 0; i != values.size(); ++i )
+    {
+        state = state * 1664525u + 1013904223u;
+        float const u = float( state >> 8 ) / float( 1 << 24 );
+        values[i] = float16_t{ ( i % 10 == 0 ) ? ( u - 0.5f ) * 20000.0f : ( u - 0.5f ) * 4.0f };
+    }
+    values[10] = float16_t{ std::uint16_t( 0x7e00 ) };
+    values[11] = float16_t{ std::uint16_t( 0xfe00 ) };
+    values[12] = numeric::fp16_infinity;
+    values[13] = float16_t{ std::uint16_t( 0x8000 ) };
+    values[14] = float16_t{ std::uint16_t( 0x0000 ) };
+
+    std::vector<value_range> const ranges = {
+        value_range::between( float16_t{ -0.75f }, float16_t{ 1.25f } ),
+        value_range::greater( float16_t{ 100.0f } ),
+        value_range::less_equal( float16_t{ -1.0f } ),
+        value_range::equal( float16_t{ 0.0f } ),
+        value_range::greater_equal( numeric::fp16_infinity_negative ),
+        value_range::between( float16_t{ 2.0f }, float16_t{ 1.0f } ),
+    };
+
+    for ( unsigned bits : { 1u, 4u, 8u, 12u, 16u } )
+    {
+        numeric::float16_bitmap_index index{ values, bits, 2 };
+        REQUIRE( index.bucket_count() == ( std::size_t( 1 ) << bits ) );
+        std::size_t total = 0;
+        for ( std::size_t b = 0; b != index.bucket_count(); ++b ) total += index.bucket_cardinality( b );
+        REQUIRE( total == values.size() );
+
+        for ( auto const& range : ranges )
+        {
+            auto const selection = index.query( range );
+            std::size_t expected = 0;
+            for ( std::size_t i = 0; i != values.size(); ++i )
+            {
+                bool const hit = range.contains( values[i] );
+                expected += hit;
+                REQUIRE( bool( ( selection[i / 64] >> ( i % 64 ) ) & 1 ) == hit );
+            }
+            REQUIRE( index.count( range ) == expected );
+        }
+    }
+
+    numeric::float16_bitmap_index const empty{ {} };
+    REQUIRE( empty.count( value_range::greater_equal( numeric::fp16_infinity_negative ) ) == 0 );
+    REQUIRE_THROWS_AS( ( numeric::float16_bitmap_index{ values, 17 } ), std::invalid_argument );
+}
+
+TEST_CASE( "float16_group_by", "[groupby]" )
+{
+    using numeric::float16_t;
+
+    // std::hash agrees with operator ==
+    std::unordered_map<float16_t, int> map;
+    map[float16_t{ 1.5f }] = 1;
+    map[float16_t{ std::uint16_t( 0x8000 ) }] = 2;
+    map[float16_t{ 0.0f }] = 3;
+    REQUIRE( map.size() == 3 );
+    REQUIRE( map.at( float16_t{ 1.5f } ) == 1 );
+    REQUIRE( std::hash<float16_t>{}( float16_t{ 2.0f } ) == std::hash<float16_t>{}( float16_t{ 2.0f } ) );
+
+    std::size_t const n = 300000;
+    std::vector<float16_t> keys( n );
+    std::vector<float> values( n );
+    std::vector<float16_t> half_values( n );
+    std::uint32_t state = 5;
+    for ( std::size_t i = 0; i != n; ++i )
+    {
+        state = state * 1664525u + 1013904223u;
+        keys[i] = float16_t{ float( ( state >> 10 ) % 41 ) * 0.25f - 5.0f };   // prices rounded to quarters
+        values[i] = float( ( state >> 4 ) % 1000 ) / 8.0f;
+        half_values[i] = float16_t{ values[i] };
+    }
+    keys[0] = float16_t{ std::uint16_t( 0x8000 ) };
+    keys[1] = float16_t{ std::uint16_t( 0x7e00 ) };
+    keys[2] = float16_t{ std::uint16_t( 0x7e01 ) };
+
+    std::unordered_map<float16_t, numeric::group_stats> expected;
+    for ( std::size_t i = 0; i != n; ++i )
+        expected[keys[i]].add( values[i] );
+
+    for ( std::size_t threads : { 1, 3 } )
+    {
+        numeric::float16_group_by group{ { false, false, threads } };
+        group.add( std::span{ keys }.first( 1000 ), std::span<float const>{ values }.first( 1000 ) );
+        group.add( std::span{ keys }.subspan( 1000 ), std::span<float const>{ values }.subspan( 1000 ) );
+        REQUIRE( group.groups() == expected.size() );
+
+        float16_t previous = numeric::fp16_infinity_negative;
+        bool first = true;
+        group.for_each( [&]( float16_t key, numeric::group_stats const& stats )
+        {
+            auto const& e = expected.at( key );
+            REQUIRE( stats.count == e.count );
+            REQUIRE( stats.sum == Approx( e.sum ).epsilon( 1e-12 ) );
+            REQUIRE( stats.min == e.min );
+            REQUIRE( stats.max == e.max );
+            if ( !first )
+                REQUIRE( numeric::order_key( previous ) < numeric::order_key( key ) );
+            previous = key;
+            first = false;
+        } );
+
+        // half metrics aggregate the same (the values are exact in half)
+        numeric::float16_group_by halves{ { false, false, threads } };
+        halves.add( keys, std::span<float16_t const>{ half_values } );
+        REQUIRE( halves[float16_t{ -5.0f }].sum == group[float16_t{ -5.0f }].sum );
+        REQUIRE( halves[float16_t{ -5.0f }].count == group[float16_t{ -5.0f }].count );
+    }
+
+    // canonicalization folds -0 into +0 and all NaN payloads into one group
+    numeric::float16_group_by merged{ { true, true, 2 } };
+    merged.add( keys, std::span<float const>{ values } );
+    REQUIRE( merged.groups() == expected.size() - 2 );
+    REQUIRE( merged[float16_t{ std::uint16_t( 0x8000 ) }].count == expected.at( float16_t{ 0.0f } ).count + 1 );
+    REQUIRE( merged[float16_t{ std::uint16_t( 0xfe03 ) }].count == 2 );
+    REQUIRE( merged[float16_t{ std::uint16_t( 0xfe03 ) }].sum == double( values[1] ) + double( values[2] ) );
+
+    numeric::float16_group_by other;
+    other.merge( merged );
+    REQUIRE( other[numeric::fp16_nan].count == 2 );
+
+    REQUIRE_THROWS_AS( merged.add( keys, std::span<float const>{ values }.first( 3 ) ), std::invalid_argument );
+}
+
+TEST_CASE( "rolling_window", "[rolling]" )
+{
+    using numeric::float16_t;
+
+    std::size_t const series = 3, steps = 5000, window = 37;
+    std::vector<float16_t> samples( series * steps );
+    std::uint32_t state = 11;
+    for ( std::size_t i = 0; i != samples.size(); ++i )
+    {
+        state = state * 1664525u + 1013904223u;
+        float const noise = float( ( state >> 8 ) % 2001 ) / 1000.0f - 1.0f;
+        // series 0 rides on a large offset, series 1 contains a -0 and a long constant stretch
+        float const base = ( i % series == 0 ) ? 1000.0f : 0.0f;
+        samples[i] = float16_t{ base + noise * ( i % series == 1 && i / series > 4000 ? 0.0f : 1.0f ) };
+    }
+    samples[1 * series + 1] = float16_t{ std::uint16_t( 0x8000 ) };
+
+    numeric::rolling_window rolling{ { window, series, 1, 0 } };
+    std::vector<float> mean( samples.size() ), stddev( samples.size() );
+    std::vector<float16_t> lo( samples.size() ), hi( samples.size() );
+
+    // uneven chunks, the state carries over
+    for ( std::size_t first = 0, chunk = 1; first < steps; first += chunk, chunk = chunk * 3 % 301 + 1 )
+    {
+        std::size_t const n = std::min( chunk, steps - first ) * series;
+        std::size_t const o = first * series;
+        rolling.process( std::span{ samples }.subspan( o, n ),
+                         { std::span{ mean }.subspan( o, n ), std::span{ stddev }.subspan( o, n ), std::span{ lo }.subspan( o, n ), std::span{ hi }.subspan( o, n ) } );
+    }
+    REQUIRE( rolling.steps() == steps );
+
+    for ( std::size_t t = 0; t != steps; ++t )
+        for ( std::size_t s = 0; s != series; ++s )
+        {
+            std::size_t const first = t + 1 >= window ? t + 1 - window : 0;
+            double sum = 0.0, squares = 0.0;
+            float16_t min = samples[first * series + s], max = min;
+            for ( std::size_t k = first; k <= t; ++k )
+            {
+                float16_t const v = samples[k * series + s];
+                sum += float( v );
+                if ( numeric::order_key( v ) < numeric::order_key( min ) ) min = v;
+                if ( numeric::order_key( v ) > numeric::order_key( max ) ) max = v;
+            }
+            double const count = double( t + 1 - first );
+            double const m = sum / count;
+            for ( std::size_t k = first; k <= t; ++k )
+                squares += ( float( samples[k * series + s] ) - m ) * ( float( samples[k * series + s] ) - m );
+            double const sd = count > 1 ? std::sqrt( squares / ( count - 1 ) ) : 0.0;
+
+            std::size_t const i = t * series + s;
+            REQUIRE( std::abs( mean[i] - m ) <= 1e-5 * std::max( 1.0, std::abs( m ) ) + 2e-4 );
+            REQUIRE( std::abs( stddev[i] - sd ) <= 2e-3 );
+            REQUIRE( std::uint16_t( lo[i] ) == std::uint16_t( min ) );
+            REQUIRE( std::uint16_t( hi[i] ) == std::uint16_t( max ) );
+        }
+
+    // after the constant stretch the recomputed sums give an exact zero deviation
+    REQUIRE( stddev[( steps - 1 ) * series + 1] == 0.0f );
+
+    // reset starts a fresh stream
+    rolling.reset();
+    std::vector<float> m1( series ), s1( series );
+    rolling.process( std::span{ samples }.first( series ), m1, s1 );
+    REQUIRE( m1[0] == float( samples[0] ) );
+    REQUIRE( s1[0] == 0.0f );
+
+    REQUIRE_THROWS_AS( rolling.process( std::span{ samples }.first( 2 ), m1, s1 ), std::invalid_argument );
+    REQUIRE_THROWS_AS( numeric::rolling_window( numeric::rolling_options{} ), std::invalid_argument );
+}
+
+TEST_CASE( "prefix_scans", "[cumulative]" )
+{
+    using numeric::float16_t;
+
+    for ( std::size_t n : { std::size_t( 0 ), std::size_t( 1 ), std::size_t( 15 ), std::size_t( 17 ), std::size_t( 1000 ), std::size_t( 300001 ) } )
+        for ( std::size_t threads : { 1, 4 } )
+        {
+            std::vector<float16_t> in( n );
+            std::uint32_t state = 3;
+            for ( auto& v : in )
+            {
+                state = state * 1664525u + 1013904223u;
+                v = float16_t{ float( ( state >> 8 ) % 1001 ) / 1000.0f };
+            }
+
+            // cumsum in fp32 goes far past half's range without saturating
+            std::vector<float> sum( n );
+            numeric::cumsum( std::span<float16_t const>{ in }, std::span{ sum }, threads );
+            double reference = 0.0;
+            for ( std::size_t i = 0; i != n; ++i )
+            {
+                reference += float( in[i] );
+                REQUIRE( sum[i] == Approx( reference ).epsilon( 1e-5 ).margin( 1e-4 ) );
+            }
+
+            std::vector<float16_t> half_sum( n ), exclusive( n );
+            numeric::inclusive_scan( std::span<float16_t const>{ in }, std::span{ half_sum }, numeric::scan_op::sum, threads );
+            numeric::exclusive_scan( std::span<float16_t const>{ in }, std::span{ exclusive }, numeric::scan_op::sum, threads );
+            // half outputs saturate to +inf once the running sum leaves half's range
+            auto const as_half = []( float x ) { return x >= 65520.0f ? float( numeric::fp16_infinity ) : float( float16_t{ x } ); };
+            for ( std::size_t i = 0; i != n; ++i )
+            {
+                REQUIRE( float( half_sum[i] ) == Approx( as_half( sum[i] ) ).epsilon( 2e-3 ) );
+                REQUIRE( float( exclusive[i] ) == Approx( i ? as_half( sum[i - 1] ) : 0.0f ).epsilon( 2e-3 ) );
+            }
+
+            // products of values near one
+            std::vector<float16_t> near_one( n );
+            for ( std::size_t i = 0; i != n; ++i )
+                near_one[i] = float16_t{ 1.0f + ( float( in[i] ) - 0.5f ) / 1024.0f };
+            std::vector<float> product( n );
+            numeric::cumprod( std::span<float16_t const>{ near_one }, std::span{ product }, threads );
+            double p = 1.0;
+            for ( std::size_t i = 0; i != n; ++i )
+            {
+                p *= float( near_one[i] );
+                REQUIRE( product[i] == Approx( p ).epsilon( 1e-3 ) );
+            }
+        }
+
+    // cummax is exact, NaNs propagate, exclusive starts at -inf
+    std::vector<float16_t> in( 70000 );
+    std::uint32_t state = 9;
+    for ( auto& v : in )
+    {
+        state = state * 1664525u + 1013904223u;
+        v = float16_t{ ( float( ( state >> 8 ) % 2000001 ) - 1000000.0f ) / 16.0f / float( 1 + ( &v - in.data() ) / 1000 ) };
+    }
+    in[5] = float16_t{ std::uint16_t( 0x8000 ) };
+    std::vector<float16_t> with_nan = in;
+    with_nan[40000] = float16_t{ std::uint16_t( 0xfe00 ) };
+
+    for ( std::size_t threads : { 1, 3 } )
+    {
+        std::vector<float16_t> inclusive( in.size() ), exclusive( in.size() );
+        std::vector<float> inclusive_float( in.size() );
+        numeric::cummax( std::span<float16_t const>{ in }, std::span{ inclusive }, threads );
+        numeric::cummax( std::span<float16_t const>{ in }, std::span{ inclusive_float }, threads );
+        numeric::exclusive_scan( std::span<float16_t const>{ in }, std::span{ exclusive }, numeric::scan_op::max, threads );
+        REQUIRE( std::uint16_t( exclusive[0] ) == std::uint16_t( numeric::fp16_infinity_negative ) );
+        float16_t m = in[0];
+        for ( std::size_t i = 0; i != in.size(); ++i )
+        {
+            if ( i ) REQUIRE( std::uint16_t( exclusive[i] ) == std::uint16_t( m ) );
+            if ( numeric::order_key( in[i] ) > numeric::order_key( m ) ) m = in[i];
+            REQUIRE( std::uint16_t( inclusive[i] ) == std::uint16_t( m ) );
+            REQUIRE( inclusive_float[i] == float( m ) );
+        }
+
+        std::vector<float16_t> nan_max( in.size() );
+        numeric::cummax( std::span<float16_t const>{ with_nan }, std::span{ nan_max }, threads );
+        REQUIRE( ( std::uint16_t( nan_max[39999] ) & 0x7fff ) <= 0x7c00 );
+        for ( std::size_t i = 40000; i != in.size(); ++i )
+            REQUIRE( ( std::uint16_t( nan_max[i] ) & 0x7fff ) > 0x7c00 );
+    }
+
+    // a running sum of 1 + 2^-11 is a tie, vector lanes and tails must round it the same way
+    std::uint16_t const tied = std::uint16_t( [] { float const x = 1.0f + 1.0f / 2048.0f; float16_t h; numeric::narrow( &x, &h, 1 ); return h; }() );
+    for ( std::size_t n : { std::size_t( 9 ), std::size_t( 23 ), std::size_t( 200003 ) } )
+        for ( std::size_t threads : { 1, 4 } )
+        {
+            std::vector<float16_t> tie( n, float16_t{ 0.0f } );
+            tie[0] = float16_t{ 1.0f };
+            tie[1] = float16_t{ 1.0f / 2048.0f };
+            std::vector<float16_t> inclusive( n ), exclusive( n );
+            numeric::inclusive_scan( std::span<float16_t const>{ tie }, std::span{ inclusive }, numeric::scan_op::sum, threads );
+            numeric::exclusive_scan( std::span<float16_t const>{ tie }, std::span{ exclusive }, numeric::scan_op::sum, threads );
+            for ( std::size_t i = 0; i != n; ++i )
+            {
+                REQUIRE( std::uint16_t( inclusive[i] ) == ( i ? tied : 0x3c00 ) );
+                if ( i > 1 ) REQUIRE( std::uint16_t( exclusive[i] ) == tied );
+            }
+        }
+
+    std::vector<float> small( 3 );
+    REQUIRE_THROWS_AS( numeric::cumsum( std::span<float16_t const>{ in }, std::span{ small } ), std::invalid_argument );
+}
+
+TEST_CASE( "block_rings", "[ring]" )
+{
+    using numeric::float16_t;
+    std::size_t const block = 5;
+
+    auto const fill = []( std::span<float16_t> b, std::uint16_t id ) { for ( auto& v : b ) v = float16_t{ id }; };
+
+    // single thread: capacity rounding, partial batches, wrap-around
+    {
+        numeric::spsc_block_ring spsc{ block, 3 };
+        numeric::mpmc_block_ring mpmc{ block, 3 };
+        REQUIRE( spsc.capacity() == 4 );
+        REQUIRE( mpmc.capacity() == 4 );
+
+        std::vector<float16_t> in( 6 * block ), out( 6 * block );
+        for ( std::uint16_t id = 0; id != 6; ++id )
+            fill( std::span{ in }.subspan( id * block, block ), id );
+
+        for ( int round = 0; round != 3; ++round )
+        {
+            REQUIRE( spsc.try_push( in ) == 4 );
+            REQUIRE( mpmc.try_push( in ) == 4 );
+            REQUIRE( spsc.try_push( std::span{ in }.first( block ) ) == 0 );
+            REQUIRE( mpmc.try_push( std::span{ in }.first( block ) ) == 0 );
+            REQUIRE( spsc.try_pop( std::span{ out }.first( 3 * block ) ) == 3 );
+            REQUIRE( mpmc.try_pop( std::span{ out }.subspan( 3 * block, 3 * block ) ) == 3 );
+            REQUIRE( std::equal( out.begin(), out.begin() + 3 * block, in.begin() ) );
+            REQUIRE( std::equal( out.begin() + 3 * block, out.end(), in.begin() ) );
+            REQUIRE( spsc.try_pop( out ) == 1 );
+            REQUIRE( mpmc.try_pop( out ) == 1 );
+            REQUIRE( std::uint16_t( out[0] ) == 3 );
+            REQUIRE( spsc.try_pop( out ) == 0 );
+            REQUIRE( mpmc.try_pop( out ) == 0 );
+        }
+        REQUIRE_THROWS_AS( spsc.try_push( std::span{ in }.first( 3 ) ), std::invalid_argument );
+        REQUIRE_THROWS_AS( numeric::mpmc_block_ring( 0, 4 ), std::invalid_argument );
+    }
+
+    // threads: every block arrives exactly once and intact
+    std::size_t const per_producer = 20000;   // even, and 3 * per_producer blocks split evenly into pushes of 3 and pops of 2
+    {
+        numeric::spsc_block_ring ring{ block, 16 };
+        std::thread producer{ [&]
+        {
+            std::vector<float16_t> b( 3 * block );
+            for ( std::size_t i = 0; i != 3 * per_producer; i += 3 )
+            {
+                for ( std::size_t k = 0; k != 3; ++k ) fill( std::span{ b }.subspan( k * block, block ), std::uint16_t( ( i + k ) & 0x7fff ) );
+                ring.push( b );
+            }
+        } };
+        std::vector<float16_t> b( 2 * block );
+        bool ordered = true;
+        for ( std::size_t i = 0; i != 3 * per_producer; i += 2 )
+        {
+            ring.pop( b );
+            for ( std::size_t j = 0; j != b.size(); ++j )
+                ordered = ordered && std::uint16_t( b[j] ) == ( ( i + j / block ) & 0x7fff );
+        }
+        producer.join();
+        REQUIRE( ordered );
+    }
+    {
+        std::size_t const producers = 3, consumers = 2;
+        numeric::mpmc_block_ring ring{ block, 8 };
+        std::vector<std::atomic<int>> seen( producers * per_producer );
+        std::atomic<std::size_t> received{ 0 };
+        std::atomic<bool> torn{ false };
+        std::vector<std::thread> threads;
+        for ( std::size_t p = 0; p != producers; ++p )
+            threads.emplace_back( [&, p]
+            {
+                std::vector<float16_t> b( 2 * block );
+                for ( std::size_t i = 0; i < per_producer; i += 2 )
+                {
+                    // block id = p * per_producer + i, stored as two halves of 16 bits each
+                    for ( std::size_t k = 0; k != 2; ++k )
+                    {
+                        std::uint32_t const id = static_cast<std::uint32_t>( p * per_producer + i + k );
+                        for ( std::size_t j = 0; j != block; ++j )
+                            b[k * block + j] = float16_t{ static_cast<std::uint16_t>( j % 2 ? id >> 16 : id & 0xffff ) };
+                    }
+                    ring.push( b );
+                }
+            } );
+        for ( std::size_t c = 0; c != consumers; ++c )
+            threads.emplace_back( [&]
+            {
+                std::vector<float16_t> b( 3 * block );
+                while ( received.load() < producers * per_producer )
+                {
+                    std::size_t const n = ring.try_pop( b );
+                    for ( std::size_t k = 0; k != n; ++k )
+                    {
+                        std::uint32_t const id = std::uint16_t( b[k * block] ) | ( std::uint32_t( std::uint16_t( b[k * block + 1] ) ) << 16 );
+                        for ( std::size_t j = 2; j != block; ++j )
+                            if ( std::uint16_t( b[k * block + j] ) != std::uint16_t( b[k * block + j % 2] ) ) torn = true;
+                        if ( id < seen.size() ) seen[id]++;
+                        else torn = true;
+                    }
+                    received += n;
+                    if ( !n ) std::this_thread::yield();
+                }
+            } );
+        for ( auto& t : threads ) t.join();
+        REQUIRE( !torn );
+        REQUIRE( std::all_of( seen.begin(), seen.end(), []( std::atomic<int> const& s ) { return s.load() == 1; } ) );
+    }
+}
+
+TEST_CASE( "half_loader", "[loader]" )
+{
+    using numeric::float16_t;
+
+    std::size_t const n = 100000, offset = 100;
+    std::vector<float16_t> values( n );
+    for ( std::size_t i = 0; i != n; ++i )
+        values[i] = numeric::float16_t_private::is_nan_bits( std::uint16_t( i * 7 ) ) ? float16_t{ 1.0f } : float16_t{ std::uint16_t( i * 7 ) };
+
+    auto const path = std::filesystem::temp_directory_path() / "float16_t_loader_test.bin";
+    {
+        std::ofstream file{ path, std::ios::binary };
+        std::string const header( offset, 'x' );
+        file.write( header.data(), std::streamsize( header.size() ) );
+        file.write( reinterpret_cast<char const*>( values.data() ), std::streamsize( n * sizeof( float16_t ) ) );
+    }
+
+    for ( bool uring : { true, false } )
+        for ( std::size_t threads : { 1, 3 } )
+        {
+            numeric::half_loader loader{ { 4096, 3, threads, uring } };
+            if ( !uring ) REQUIRE( !loader.uses_io_uring() );
+            std::vector<float> out( n, -1.0f );
+            auto const stats = loader.load( path.string(), offset, out );
+            REQUIRE( stats.bytes == n * sizeof( float16_t ) );
+            REQUIRE( stats.chunks == ( n * sizeof( float16_t ) + 4095 ) / 4096 );
+            REQUIRE( stats.overlap() >= 0.0 );
+            REQUIRE( stats.overlap() <= 1.0 );
+            bool same = true;
+            for ( std::size_t i = 0; i != n; ++i )
+                same = same && float16_t{ out[i] } == values[i];
+            REQUIRE( same );
+
+            // a range running past the end of the file
+            std::vector<float> tail( 10 );
+            REQUIRE_THROWS_AS( loader.load( path.string(), offset + n * sizeof( float16_t ) - 4, tail ), std::runtime_error );
+        }
+
+    numeric::half_loader loader;
+    std::vector<float> tail( 10 );
+    REQUIRE_THROWS_AS( loader.load( ( path.string() + ".missing" ), 0, tail ), std::system_error );
+    REQUIRE( loader.load( path.string(), offset + 2, 3 ) == std::vector<float>{ float( values[1] ), float( values[2] ), float( values[3] ) } );
+    std::filesystem::remove( path );
+}
+
+TEST_CASE( "checkpoint_writer", "[checkpoint]" )
+{
+    using numeric::float16_t;
+
+    auto const directory = std::filesystem::temp_directory_path();
+    std::vector<float16_t> weights( 3 * 1000 ), bias( 7 );
+    for ( std::size_t i = 0; i != weights.size(); ++i ) weights[i] = float16_t{ float( i % 1000 ) * 0.25f };
+    for ( std::size_t i = 0; i != bias.size(); ++i ) bias[i] = float16_t{ -float( i ) };
+
+    for ( bool direct : { false, true } )
+    {
+        numeric::checkpoint_writer writer{ { 2, 4096, 2, direct, 2 } };
+        std::vector<std::future<void>> saved;
+        std::vector<std::vector<float16_t>> expected;
+        for ( int step = 0; step != 5; ++step )
+        {
+            auto const path = ( directory / ( "float16_t_checkpoint_" + std::to_string( step ) + ".safetensors" ) ).string();
+            saved.push_back( writer.save( path, { { "weights", { 3, 1000 }, weights }, { "bias", { 7 }, bias } }, { { "step", std::to_string( step ) } } ) );
+            expected.push_back( weights );
+            // the snapshot is taken inside save(), later updates must not leak into the file
+            for ( auto& w : weights ) w = float16_t{ float( w ) + 1.0f };
+        }
+        for ( auto& f : saved ) f.get();
+        writer.wait();
+
+        for ( int step = 0; step != 5; ++step )
+        {
+            auto const path = directory / ( "float16_t_checkpoint_" + std::to_string( step ) + ".safetensors" );
+            for ( auto const& entry : std::filesystem::directory_iterator{ directory } )
+                REQUIRE( entry.path().string().rfind( path.string() + ".tmp", 0 ) == std::string::npos );
+            {
+                numeric::safetensors_reader const reader{ path.string() };
+                REQUIRE( reader.metadata().at( "step" ) == std::to_string( step ) );
+                REQUIRE( reader.tensor( "weights" ).shape == std::vector<std::int64_t>{ 3, 1000 } );
+                REQUIRE( reinterpret_cast<std::uintptr_t>( reader.view( "weights" ).data() ) % 4096 == 0 );
+                auto const w = reader.view( "weights" );
+                auto const b = reader.view( "bias" );
+                REQUIRE( std::equal( w.begin(), w.end(), expected[step].begin(), expected[step].end() ) );
+                REQUIRE( std::equal( b.begin(), b.end(), bias.begin(), bias.end() ) );
+            }
+            std::filesystem::remove( path );
+        }
+    }
+
+    // the usual "latest" loop: back-to-back saves to one path all succeed and the newest one ends up in place
+    {
+        auto const latest = ( directory / ( "float16_t_checkpoint_latest_" + std::to_string( ::getpid() ) + ".safetensors" ) ).string();
+        numeric::checkpoint_writer writer{ { 3, 4096, 4, false, 1 } };
+        std::vector<std::future<void>> saved;
+        for ( int step = 0; step != 3; ++step )
+            saved.push_back( writer.save( latest, { { "bias", { 7 }, bias } }, { { "step", std::to_string( step ) } } ) );
+        for ( auto& f : saved ) REQUIRE_NOTHROW( f.get() );
+        {
+            numeric::safetensors_reader const reader{ latest };
+            REQUIRE( reader.metadata().at( "step" ) == "2" );
+        }
+        for ( auto const& entry : std::filesystem::directory_iterator{ directory } )
+            REQUIRE( entry.path().string().rfind( latest + ".tmp", 0 ) == std::string::npos );
+        std::filesystem::remove( latest );
+    }
+
+    numeric::checkpoint_writer writer;
+    REQUIRE_THROWS_AS( writer.save( ( directory / "x.safetensors" ).string(), { { "w", { 2, 2 }, bias } } ), std::invalid_argument );
+    auto missing = writer.save( ( directory / "float16_t_no_such_directory" / "x.safetensors" ).string(), { { "w", { 7 }, bias } } );
+    REQUIRE_THROWS_AS( missing.get(), std::system_error );
+}
 
+TEST_CASE( "content_hash", "[hash]" )
+{
+    using numeric::float16_t;
+    using numeric::digest128;
+    using numeric::hash_options;
+
+    std::vector<float16_t> v( 5 * numeric::hash_leaf_size + 77 );
+    for ( std::size_t i = 0; i != v.size(); ++i )
+        v[i] = float16_t{ static_cast<std::uint16_t>( i * 2654435761u >> 7 ) };
+
+    // fixed answers: the AVX-512, AVX2 and scalar kernels must all produce these
+    REQUIRE( numeric::content_hash128( v, { false, false, 7, 1 } ) == digest128{ 0xdd26411fc1395fbfull, 0x25171b86fc7fe780ull } );
+    REQUIRE( numeric::content_hash128( v, { true, true, 7, 1 } ) == digest128{ 0x039a44564697c0b8ull, 0x82205928c749f86full } );
+    REQUIRE( numeric::content_hash128( std::span{ v }.first( 100 ) ) == digest128{ 0xe0e18897150cd26eull, 0x9a40be857193f7e5ull } );
+
+    // independent of the thread count
+    for ( std::size_t threads : { 2, 3, 8 } )
+        REQUIRE( numeric::content_hash128( v, { false, false, 7, threads } ) == numeric::content_hash128( v, { false, false, 7, 1 } ) );
+
+    // sensitive to every element, the length, the seed and the order
+    auto const base = numeric::content_hash128( v );
+    for ( std::size_t i : { std::size_t( 0 ), std::size_t( 31 ), std::size_t( 32 ), numeric::hash_leaf_size, v.size() - 1 } )
+    {
+        auto w = v;
+        w[i] = float16_t{ static_cast<std::uint16_t>( std::uint16_t( w[i] ) ^ 1 ) };
+        REQUIRE( numeric::content_hash128( w ) != base );
+    }
+    std::vector<float16_t> zeros( 3 );
+    REQUIRE( numeric::content_hash128( std::span{ zeros }.first( 2 ) ) != numeric::content_hash128( zeros ) );
+    REQUIRE( numeric::content_hash128( std::span<float16_t const>{} ) != numeric::content_hash128( std::span{ zeros }.first( 1 ) ) );
+    REQUIRE( numeric::content_hash64( v, { false, false, 1, 0 } ) != numeric::content_hash64( v ) );
+    REQUIRE( numeric::content_hash64( v ) == base.lo );
+
+    // canonicalization
+    std::vector<float16_t> a{ float16_t{ 1.0f }, numeric::fp16_zero, float16_t{ std::uint16_t( 0x7e00 ) } };
+    std::vector<float16_t> b{ float16_t{ 1.0f }, numeric::fp16_zero_negative, float16_t{ std::uint16_t( 0xfd01 ) } };
+    REQUIRE( numeric::content_hash128( a ) != numeric::content_hash128( b ) );
+    REQUIRE( numeric::content_hash128( a, { true, false } ) != numeric::content_hash128( b, { true, false } ) );
+    REQUIRE( numeric::content_hash128( a, { true, true } ) == numeric::content_hash128( b, { true, true } ) );
+    a.resize( 40, numeric::fp16_zero_negative );
+    b.resize( 40, numeric::fp16_zero );
+    REQUIRE( numeric::content_hash128( a, { true, true } ) == numeric::content_hash128( b, { true, true } ) );
+
+    // shards of 2^k whole leaves combine into the hash of the whole
+    auto const all = std::span<float16_t const>{ v }.first( 3 * numeric::hash_leaf_size + 5 );
+    auto const x = all.first( 2 * numeric::hash_leaf_size ), y = all.subspan( 2 * numeric::hash_leaf_size );
+    REQUIRE( numeric::hash_combine( numeric::content_hash128( x ), numeric::content_hash128( y ) ) == numeric::content_hash128( all ) );
+    REQUIRE( numeric::hash_combine( numeric::content_hash128( y ), numeric::content_hash128( x ) ) != numeric::content_hash128( all ) );
+}
+
+TEST_CASE( "mixed_lu", "[lu]" )
+{
+    std::size_t const n = 150;
+    std::mt19937 engine{ 7 };
+    std::uniform_real_distribution<double> uniform{ -1.0, 1.0 };
+
+    // a moderately conditioned matrix with rows spanning many orders of magnitude, beyond half range
+    std::vector<double> a( n * n ), truth( n ), b( n, 0.0 );
+    for ( std::size_t i = 0; i != n; ++i )
+    {
+        double const row_magnitude = std::pow( 10.0, double( i % 13 ) - 6.0 ) * ( i % 3 ? 1.0 : 1.0e6 );
+        for ( std::size_t j = 0; j != n; ++j )
+            a[i * n + j] = ( uniform( engine ) + ( i == j ? 4.0 : 0.0 ) ) * row_magnitude;
+    }
+    for ( auto& t : truth ) t = uniform( engine );
+    for ( std::size_t i = 0; i != n; ++i )
+        for ( std::size_t j = 0; j != n; ++j )
+            b[i] += a[i * n + j] * truth[j];
+
+    std::vector<double> reference;
+    for ( std::size_t threads : { 1, 3 } )
+    {
+        numeric::mixed_lu const lu{ a, n, { 32, threads } };
+        REQUIRE( lu.bytes() < n * n * sizeof( float ) );
+
+        // the half factors alone give a few digits
+        std::vector<double> x0 = b;
+        lu.solve( x0 );
+        double error0 = 0.0;
+        for ( std::size_t i = 0; i != n; ++i ) error0 = std::max( error0, std::abs( x0[i] - truth[i] ) );
+        REQUIRE( error0 < 1.0e-1 );
+
+        std::vector<double> x( n );
+        auto const result = lu.refine( a, b, x );
+        REQUIRE( result.converged );
+        REQUIRE( result.iterations >= 1 );
+        REQUIRE( result.backward_error <= double( n ) * std::ldexp( 1.0, -53 ) );
+        double error = 0.0;
+        for ( std::size_t i = 0; i != n; ++i ) error = std::max( error, std::abs( x[i] - truth[i] ) );
+        REQUIRE( error < 1.0e-11 );
+
+        if ( reference.empty() ) reference = x;
+        else REQUIRE( x == reference );
+    }
+
+    std::vector<double> x( n );
+    REQUIRE( numeric::solve_refined( a, n, b, x ).converged );
+
+    std::vector<double> singular( 9, 1.0 );
+    REQUIRE_THROWS_AS( numeric::mixed_lu( singular, 3 ), std::runtime_error );
+    REQUIRE_THROWS_AS( numeric::mixed_lu( singular, 4 ), std::invalid_argument );
+}
+
+TEST_CASE( "krylov_solvers", "[krylov]" )
+{
+    // 2D Poisson (5-point) on a g x g grid, optionally with a first-order convection term making it nonsymmetric
+    auto const grid = []( std::size_t g, double magnitude, double convection )
+    {
+        std::vector<std::uint64_t> offsets{ 0 };
+        std::vector<std::uint32_t> columns;
+        std::vector<double> values;
+        for ( std::size_t i = 0; i != g; ++i )
+            for ( std::size_t j = 0; j != g; ++j )
+            {
+                auto const add = [&]( std::size_t r, std::size_t c, double v ) { columns.push_back( std::uint32_t( r * g + c ) ); values.push_back( v * magnitude ); };
+                if ( i ) add( i - 1, j, -1.0 );
+                if ( j ) add( i, j - 1, -1.0 - convection );
+                add( i, j, 4.0 );
+                if ( j + 1 < g ) add( i, j + 1, -1.0 + convection );
+                if ( i + 1 < g ) add( i + 1, j, -1.0 );
+                offsets.push_back( values.size() );
+            }
+        return numeric::half_csr_matrix{ g * g, g * g, offsets, columns, values };
+    };
+
+    std::size_t const g = 30, n = g * g;
+    {
+        // entries far beyond half range are scaled in by a power of two, so 4 and -1 times 2^20 survive exactly
+        auto const a = grid( g, 1048576.0, 0.0 );
+        REQUIRE( a.nonzeros() == 5 * n - 4 * g );
+        REQUIRE( a.flushed() == 0 );
+        REQUIRE( a.bytes() < a.nonzeros() * ( sizeof( float ) + sizeof( std::uint32_t ) ) );
+
+        std::vector<double> ones( n, 1.0 ), b( n );
+        a.multiply( std::span<double const>{ ones }, std::span<double>{ b } );
+        REQUIRE( b[g + 1] == 0.0 );
+        REQUIRE( b[0] == 2097152.0 );
+
+        std::vector<double> x( n, 0.0 ), reference;
+        for ( std::size_t threads : { 1, 3 } )
+        {
+            std::fill( x.begin(), x.end(), 0.0 );
+            auto const result = numeric::conjugate_gradient( a, std::span<double const>{ b }, std::span<double>{ x }, { 1000, 1.0e-10, 30, 50, threads } );
+            REQUIRE( result.converged );
+            REQUIRE( !result.breakdown );
+            REQUIRE( result.relative_residual <= 1.0e-10 );
+            REQUIRE( result.iterations < 200 );
+            REQUIRE( std::all_of( x.begin(), x.end(), []( double v ) { return std::abs( v - 1.0 ) < 1.0e-7; } ) );
+            if ( reference.empty() ) reference = x;
+            else REQUIRE( x == reference );
+        }
+
+        std::vector<float> bf( b.begin(), b.end() ), xf( n, 0.0f );
+        auto const single = numeric::conjugate_gradient( a, std::span<float const>{ bf }, std::span<float>{ xf }, { 1000, 1.0e-5 } );
+        REQUIRE( single.converged );
+        REQUIRE( std::all_of( xf.begin(), xf.end(), []( float v ) { return std::abs( v - 1.0f ) < 1.0e-3f; } ) );
+
+        // the negated matrix is not positive definite
+        auto const negative = grid( g, -1.0, 0.0 );
+        std::fill( x.begin(), x.end(), 0.0 );
+        auto const broken = numeric::conjugate_gradient( negative, std::span<double const>{ b }, std::span<double>{ x } );
+        REQUIRE( broken.breakdown );
+        REQUIRE( !broken.converged );
+    }
+    {
+        auto const a = grid( g, 1.0, 0.5 );
+        std::vector<double> ones( n, 1.0 ), b( n );
+        a.multiply( std::span<double const>{ ones }, std::span<double>{ b } );
+        for ( std::size_t restart : { 10, 40 } )
+        {
+            std::vector<double> x( n, 0.0 );
+            auto const result = numeric::gmres( a, std::span<double const>{ b }, std::span<double>{ x }, { 2000, 1.0e-9, restart } );
+            REQUIRE( result.converged );
+            REQUIRE( result.relative_residual <= 1.0e-9 );
+            REQUIRE( std::all_of( x.begin(), x.end(), []( double v ) { return std::abs( v - 1.0 ) < 1.0e-6; } ) );
+        }
+        std::vector<float> bf( b.begin(), b.end() ), xf( n, 0.0f );
+        auto const single = numeric::gmres( a, std::span<float const>{ bf }, std::span<float>{ xf }, { 2000, 1.0e-5, 20 } );
+        REQUIRE( single.converged );
+
+        // an iteration cap is honoured
+        std::vector<double> x( n, 0.0 );
+        auto const capped = numeric::gmres( a, std::span<double const>{ b }, std::span<double>{ x }, { 5, 1.0e-12, 3 } );
+        REQUIRE( !capped.converged );
+        REQUIRE( capped.iterations == 5 );
+    }
+
+    std::vector<std::uint64_t> offsets{ 0, 1 };
+    std::vector<std::uint32_t> columns{ 1 };
+    std::vector<double> values{ 1.0 };
+    REQUIRE_THROWS_AS( numeric::half_csr_matrix( 1, 1, offsets, columns, values ), std::invalid_argument );
+}
+
+TEST_CASE( "stencil_temporal_blocking", "[stencil]" )
+{
+    // straightforward reference: every step widens, applies all 27 weights to interior cells and narrows
+    auto const reference = []( float const ( &w )[3][3][3], std::vector<numeric::float16_t> grid, std::size_t nx, std::size_t ny, std::size_t nz, std::size_t steps )
+    {
+        bool const planar = nz == 1;
+        for ( std::size_t s = 0; s != steps; ++s )
+        {
+            std::vector<numeric::float16_t> next = grid;
+            for ( std::size_t z = planar ? 0 : 1; z < ( planar ? 1 : nz - 1 ); ++z )
+                for ( std::size_t y = 1; y + 1 < ny; ++y )
+                    for ( std::size_t x = 1; x + 1 < nx; ++x )
+                    {
+                        float sum = 0.0f;
+                        for ( int dz = planar ? 1 : 0; dz != ( planar ? 2 : 3 ); ++dz )
+                            for ( int dy = 0; dy != 3; ++dy )
+                                for ( int dx = 0; dx != 3; ++dx )
+                                    sum += w[dz][dy][dx] * float( grid[( ( z + dz - 1 ) * ny + y + dy - 1 ) * nx + x + dx - 1] );
+                        next[( z * ny + y ) * nx + x] = numeric::float16_t{ sum };
+                    }
+            grid = std::move( next );
+        }
+        return grid;
+    };
+    auto const max_difference = []( std::vector<numeric::float16_t> const& a, std::vector<numeric::float16_t> const& b )
+    {
+        float d = 0.0f;
+        for ( std::size_t i = 0; i != a.size(); ++i ) d = std::max( d, std::abs( float( a[i] ) - float( b[i] ) ) );
+        return d;
+    };
+    auto const same_bits = []( std::vector<numeric::float16_t> const& a, std::vector<numeric::float16_t> const& b )
+    {
+        return std::equal( a.begin(), a.end(), b.begin(), []( numeric::float16_t p, numeric::float16_t q ) { return std::uint16_t( p ) == std::uint16_t( q ); } );
+    };
+    std::mt19937 engine{ 97 };
+    std::uniform_real_distribution<float> uniform{ 0.0f, 1.0f };
+    auto const random_grid = [&]( std::size_t cells )
+    {
+        std::vector<numeric::float16_t> grid( cells );
+        for ( auto& v : grid ) v = numeric::float16_t{ uniform( engine ) };
+        return grid;
+    };
 
+    {
+        std::size_t const nx = 37, ny = 29;
+        for ( auto const& stencil : { numeric::stencil2d::five_point( 0.2f, 0.2f ), numeric::stencil2d::nine_point( 0.5f, 0.1f, 0.025f ) } )
+        {
+            float w[3][3][3] = {};
+            std::memcpy( w[1], stencil.weights, sizeof( stencil.weights ) );
+            auto const initial = random_grid( nx * ny );
+            auto const expected = reference( w, initial, nx, ny, 1, 10 );
+
+            auto one = initial;
+            numeric::apply_stencil( stencil, one, nx, ny, 10, { 1, 8, 8, 0, 1 } );
+            REQUIRE( max_difference( one, expected ) <= 2.0e-3f );
+
+            auto blocked = initial;
+            numeric::apply_stencil( stencil, blocked, nx, ny, 10, { 4, 8, 5, 0, 1 } );
+            REQUIRE( max_difference( blocked, expected ) <= 2.0e-3f );
+            for ( std::size_t x = 0; x != nx; ++x )
+                REQUIRE( ( std::uint16_t( blocked[x] ) == std::uint16_t( initial[x] ) && std::uint16_t( blocked[( ny - 1 ) * nx + x] ) == std::uint16_t( initial[( ny - 1 ) * nx + x] ) ) );
+
+            // tiles and threads do not change the result
+            auto other = initial;
+            numeric::apply_stencil( stencil, other, nx, ny, 10, { 4, 0, 0, 0, 3 } );
+            REQUIRE( same_bits( blocked, other ) );
+        }
+
+        // a linear field is a fixed point of the averaging 5-point stencil
+        std::vector<numeric::float16_t> linear( nx * ny );
+        for ( std::size_t y = 0; y != ny; ++y )
+            for ( std::size_t x = 0; x != nx; ++x )
+                linear[y * nx + x] = numeric::float16_t{ float( x + 2 * y ) };
+        auto moved = linear;
+        numeric::apply_stencil( numeric::stencil2d::five_point( 0.0f, 0.25f ), moved, nx, ny, 20, { 8, 16, 4, 0, 2 } );
+        REQUIRE( same_bits( moved, linear ) );
+    }
+    {
+        std::size_t const nx = 19, ny = 17, nz = 13;
+        for ( auto const& stencil : { numeric::stencil3d::seven_point( 0.4f, 0.1f ), numeric::stencil3d::twenty_seven_point( 0.3f, 0.05f, 0.025f, 0.0125f ) } )
+        {
+            auto const initial = random_grid( nx * ny * nz );
+            auto const expected = reference( stencil.weights, initial, nx, ny, nz, 7 );
+            auto blocked = initial;
+            std::vector<numeric::float16_t> scratch( blocked.size() );
+            numeric::apply_stencil( stencil, blocked, scratch, nx, ny, nz, 7, { 3, 8, 4, 5, 1 } );
+            REQUIRE( max_difference( blocked, expected ) <= 2.0e-3f );
+
+            auto other = initial;
+            numeric::apply_stencil( stencil, other, nx, ny, nz, 7, { 3, 0, 0, 0, 3 } );
+            REQUIRE( same_bits( blocked, other ) );
+        }
+    }
+
+    std::vector<numeric::float16_t> grid( 12 ), scratch( 11 );
+    REQUIRE_THROWS_AS( numeric::apply_stencil( numeric::stencil2d::five_point( 0.2f, 0.2f ), grid, scratch, 4, 3, 1 ), std::invalid_argument );
+    REQUIRE_THROWS_AS( numeric::apply_stencil( numeric::stencil2d::five_point( 0.2f, 0.2f ), grid, 4, 4, 1 ), std::invalid_argument );
+}
+
+TEST_CASE( "lut3d_apply", "[lut3d]" )
+{
+    std::mt19937 engine{ 98 };
+    std::uniform_real_distribution<float> uniform{ 0.0f, 1.0f };
+    std::size_t const pixels = 1003;
+    std::vector<numeric::float16_t> image( 4 * pixels ), out( image.size() );
+    for ( auto& v : image ) v = numeric::float16_t{ uniform( engine ) };
+    auto const channel_error = [&]( auto const& expected )
+    {
+        float e = 0.0f;
+        for ( std::size_t p = 0; p != pixels; ++p )
+        {
+            std::array<float, 3> const want = expected( float( image[4 * p] ), float( image[4 * p + 1] ), float( image[4 * p + 2] ) );
+            for ( std::size_t c = 0; c != 3; ++c ) e = std::max( e, std::abs( float( out[4 * p + c] ) - want[c] ) );
+            REQUIRE( std::uint16_t( out[4 * p + 3] ) == std::uint16_t( image[4 * p + 3] ) );
+        }
+        return e;
+    };
+
+    // both interpolations reproduce an affine map (up to the half rounding of entries and results)
+    auto const matrix = []( float r, float g, float b ) { return std::array<float, 3>{ 0.8f * r + 0.1f * g + 0.1f * b, 0.2f * r + 0.7f * g, 0.5f * b + 0.25f }; };
+    auto const affine = numeric::lut3d::from_function( 17, matrix );
+    REQUIRE( affine.size() == 17 );
+    REQUIRE( affine.bytes() == 17 * 17 * 17 * 4 * sizeof( numeric::float16_t ) );
+    for ( auto interpolation : { numeric::lut_interpolation::tetrahedral, numeric::lut_interpolation::trilinear } )
+    {
+        numeric::apply_lut( affine, image, out, { interpolation } );
+        REQUIRE( channel_error( matrix ) <= 2.0e-3f );
+    }
+
+    // a smooth nonlinear grade: tetrahedral close to the function, and the same on any thread count
+    auto const grade = []( float r, float g, float b ) { return std::array<float, 3>{ r * g, b * b, std::sqrt( ( r + g + b ) / 3.0f ) }; };
+    auto const lut = numeric::lut3d::from_function( 33, grade );
+    numeric::apply_lut( lut, image, out, { numeric::lut_interpolation::tetrahedral, 1 } );
+    REQUIRE( channel_error( []( float r, float g, float b ) { return std::array<float, 3>{ r * g, b * b, std::sqrt( ( r + g + b ) / 3.0f ) }; } ) <= 2.0e-2f );
+    auto const single = out;
+    numeric::apply_lut( lut, image, out, { numeric::lut_interpolation::tetrahedral, 3 } );
+    REQUIRE( std::equal( out.begin(), out.end(), single.begin(), []( numeric::float16_t a, numeric::float16_t b ) { return std::uint16_t( a ) == std::uint16_t( b ); } ) );
+
+    // a grid point comes back exactly, in place
+    auto const corner = lut.entry( 32, 16, 8 );
+    std::vector<numeric::float16_t> pixel{ numeric::float16_t{ 1.0f }, numeric::float16_t{ 0.5f }, numeric::float16_t{ 0.25f }, numeric::float16_t{ 0.75f } };
+    numeric::apply_lut( lut, pixel, pixel );
+    REQUIRE( float( pixel[0] ) == corner[0] );
+    REQUIRE( float( pixel[1] ) == corner[1] );
+    REQUIRE( float( pixel[2] ) == corner[2] );
+    REQUIRE( float( pixel[3] ) == 0.75f );
+
+    // HDR through a log2 shaper: a LUT holding the inverse shaper returns the input over 16 stops
+    float const low = -8.0f, high = 8.0f;
+    auto const shaper = numeric::lut_shaper::log2( low, high );
+    REQUIRE( shaper( numeric::float16_t{ 0.18f } ) == Approx( 0.5f ).margin( 1.0e-3 ) );
+    REQUIRE( shaper( numeric::float16_t{ -1.0f } ) == 0.0f );
+    REQUIRE( shaper( numeric::fp16_nan ) == 0.0f );
+    auto const inverse = numeric::lut3d::from_function( 65, [&]( float r, float g, float b )
+    {
+        auto const linear = [&]( float t ) { return 0.18f * std::exp2( low + t * ( high - low ) ); };
+        return std::array<float, 3>{ linear( r ), linear( g ), linear( b ) };
+    } );
+    std::uniform_real_distribution<float> stops{ -6.0f, 6.0f };
+    for ( std::size_t p = 0; p != pixels; ++p )
+        for ( std::size_t c = 0; c != 3; ++c )
+            image[4 * p + c] = numeric::float16_t{ 0.18f * std::exp2( stops( engine ) ) };
+    numeric::apply_lut( inverse, shaper, image, out );
+    for ( std::size_t i = 0; i != image.size(); ++i )
+        if ( i % 4 != 3 )
+            REQUIRE( float( out[i] ) == Approx( float( image[i] ) ).epsilon( 0.01 ) );
+
+    // results exactly halfway between two halves round the same way in full groups of 8 and in the tail
+    auto const ramp = numeric::lut3d::from_function( 2, []( float r, float, float ) { float const v = 1.0f + r / 1024.0f; return std::array<float, 3>{ v, v, v }; } );
+    std::vector<numeric::float16_t> ties( 4 * 9 ), tied( ties.size() );
+    for ( std::size_t p = 0; p != 9; ++p )
+    {
+        ties[4 * p] = numeric::float16_t{ 0.5f };
+        ties[4 * p + 1] = ties[4 * p + 2] = numeric::float16_t{ 0.0f };
+        ties[4 * p + 3] = numeric::float16_t{ 1.0f };
+    }
+    for ( auto interpolation : { numeric::lut_interpolation::tetrahedral, numeric::lut_interpolation::trilinear } )
+    {
+        numeric::apply_lut( ramp, ties, tied, { interpolation } );
+        for ( std::size_t i = 4; i != tied.size(); ++i )
+            REQUIRE( std::uint16_t( tied[i] ) == std::uint16_t( tied[i % 4] ) );
+    }
+
+    std::vector<float> short_table( 3 * 8 - 1 );
+    REQUIRE_THROWS_AS( numeric::lut3d( 2, short_table ), std::invalid_argument );
+    REQUIRE_THROWS_AS( numeric::lut3d::from_function( 1025, matrix ), std::invalid_argument );
+    REQUIRE_THROWS_AS( numeric::apply_lut( lut, std::span<numeric::float16_t const>{ image.data(), 6 }, std::span<numeric::float16_t>{ out.data(), 6 } ), std::invalid_argument );
+}
+
+TEST_CASE( "half_table_tabulate", "[table]" )
+{
+    auto const same = []( numeric::float16_t a, numeric::float16_t b ) { return std::uint16_t( a ) == std::uint16_t( b ); };
+    auto const tanh = numeric::tabulate( []( float x ) { return std::tanh( x ); } );
+    auto const exp = numeric::tabulate( []( float x ) { return std::exp( x ); }, 2 );
+    for ( std::uint32_t i = 0; i != 65536; ++i )
+    {
+        numeric::float16_t const x{ static_cast<std::uint16_t>( i ) };
+        if ( numeric::float16_t_private::is_nan_bits( std::uint16_t( x ) ) )
+        {
+            REQUIRE( numeric::float16_t_private::is_nan_bits( std::uint16_t( tanh( x ) ) ) );
+            continue;
+        }
+        REQUIRE( same( tanh( x ), numeric::float16_t{ std::tanh( float( x ) ) } ) );
+    }
+    // overflow rounds to infinity or saturates, never to NaN
+    REQUIRE( same( exp( numeric::float16_t{ 12.0f } ), numeric::fp16_infinity ) );
+    REQUIRE( same( numeric::tabulate( []( float x ) { return x * 65510.0f; } )( numeric::float16_t{ 1.0f } ), numeric::fp16_max ) );
+    REQUIRE( same( exp( numeric::fp16_infinity_negative ), numeric::fp16_zero ) );
+
+    // bulk lookups agree with the scalar ones on any thread count, in place too
+    std::mt19937 engine{ 99 };
+    std::vector<numeric::float16_t> in( 100003 ), out( in.size() );
+    for ( auto& v : in ) v = numeric::float16_t{ static_cast<std::uint16_t>( engine() ) };
+    for ( std::size_t threads : { 1, 3 } )
+    {
+        std::fill( out.begin(), out.end(), numeric::fp16_zero );
+        tanh.apply( in, out, threads );
+        for ( std::size_t i = 0; i != in.size(); ++i ) REQUIRE( same( out[i], tanh( in[i] ) ) );
+    }
+    auto inplace = in;
+    tanh.apply( inplace, inplace );
+    REQUIRE( std::equal( inplace.begin(), inplace.end(), out.begin(), same ) );
+
+    // composition fuses the two lookups, the identity is neutral
+    auto const fused = numeric::compose( exp, tanh );
+    for ( std::uint32_t i = 0; i != 65536; ++i )
+    {
+        numeric::float16_t const x{ static_cast<std::uint16_t>( i ) };
+        REQUIRE( same( fused( x ), tanh( exp( x ) ) ) );
+    }
+    REQUIRE( numeric::compose( numeric::half_table{}, tanh ) == tanh );
+    REQUIRE( numeric::compose( tanh, numeric::half_table{} ) == tanh );
+    REQUIRE( !( fused == tanh ) );
+
+    // serialization round trip, corrupted and truncated streams are refused
+    std::stringstream stream;
+    fused.save( stream );
+    std::string const bytes = stream.str();
+    REQUIRE( bytes.size() == 8 + 4 + 2 * 65536 + 8 );
+    REQUIRE( bytes.compare( 0, 8, "F16TABLE" ) == 0 );
+    std::istringstream reread{ bytes };
+    REQUIRE( numeric::half_table::load( reread ) == fused );
+    std::string corrupted = bytes;
+    corrupted[12 + 2 * 1234] ^= 1;
+    std::istringstream bad{ corrupted };
+    REQUIRE_THROWS_AS( numeric::half_table::load( bad ), std::runtime_error );
+    std::istringstream truncated{ bytes.substr( 0, 1000 ) };
+    REQUIRE_THROWS_AS( numeric::half_table::load( truncated ), std::runtime_error );
+
+    std::vector<numeric::float16_t> few( 10 );
+    REQUIRE_THROWS_AS( numeric::half_table{ few }, std::invalid_argument );
+    REQUIRE_THROWS_AS( tanh.apply( in, few ), std::invalid_argument );
+}
+
+TEST_CASE( "polyval_chebval", "[poly]" )
+{
+    std::mt19937 engine{ 100 };
+    std::uniform_real_distribution<float> uniform{ -2.0f, 2.0f };
+    std::size_t const n = 70001;
+    std::vector<numeric::float16_t> in( n ), out( n ), other( n );
+    std::vector<float> wide( n );
+    for ( auto& v : in ) v = numeric::float16_t{ uniform( engine ) };
+    auto const same = []( numeric::float16_t a, numeric::float16_t b ) { return std::uint16_t( a ) == std::uint16_t( b ); };
+
+    // reference in double
+    auto const poly = []( std::span<float const> c, double x ) { double y = 0.0; for ( std::size_t k = c.size(); k-- > 0; ) y = y * x + c[k]; return y; };
+    for ( std::size_t degree : { 0, 1, 2, 4, 7, 12 } )
+    {
+        std::vector<float> c( degree + 1 );
+        for ( std::size_t k = 0; k <= degree; ++k ) c[k] = 1.0f / float( k + 1 ) * ( k % 2 ? -1.0f : 1.0f );
+        for ( auto scheme : { numeric::poly_scheme::horner, numeric::poly_scheme::estrin } )
+        {
+            numeric::polyval( c, in, wide, { scheme } );
+            for ( std::size_t i = 0; i != n; ++i )
+            {
+                double const want = poly( c, double( float( in[i] ) ) );
+                REQUIRE( std::abs( wide[i] - want ) <= 1.0e-5 * std::max( 1.0, std::abs( want ) ) * double( degree + 1 ) );
+            }
+        }
+    }
+
+    // compile-time degrees agree with the runtime ones (half outputs, any thread count)
+    std::array<float, 6> const fixed{ 0.5f, -1.0f, 0.25f, 2.0f, -0.125f, 0.0625f };
+    for ( auto scheme : { numeric::poly_scheme::horner, numeric::poly_scheme::estrin } )
+    {
+        numeric::polyval( fixed, in, out, { scheme, 1 } );
+        numeric::polyval( std::span<float const>{ fixed }, in, other, { scheme, 3 } );
+        for ( std::size_t i = 0; i != n; ++i )
+            REQUIRE( std::abs( float( out[i] ) - float( other[i] ) ) <= 1.0e-3f * std::max( 1.0f, std::abs( float( out[i] ) ) ) );
+        numeric::polyval( fixed, in, other, { scheme, 3 } );
+        REQUIRE( std::equal( out.begin(), out.end(), other.begin(), same ) );
+    }
+
+    // overflow becomes infinity, not NaN
+    std::vector<numeric::float16_t> large{ numeric::float16_t{ 300.0f }, numeric::float16_t{ -300.0f }, numeric::float16_t{ 255.0f } };
+    std::vector<numeric::float16_t> squared( 3 );
+    numeric::polyval( std::array<float, 3>{ 0.0f, 0.0f, 1.0f }, large, squared );
+    REQUIRE( same( squared[0], numeric::fp16_infinity ) );
+    REQUIRE( same( squared[1], numeric::fp16_infinity ) );
+    REQUIRE( float( squared[2] ) == 65024.0f );
+
+    // Chebyshev: T3( t ) = 4 t^3 - 3 t, and a series on [0, 4] against the direct cosine form
+    std::array<float, 4> const t3{ 0.0f, 0.0f, 0.0f, 1.0f };
+    numeric::chebval( t3, in, wide, -2.0f, 2.0f );
+    for ( std::size_t i = 0; i != n; ++i )
+    {
+        double const t = double( float( in[i] ) ) / 2.0;
+        REQUIRE( std::abs( wide[i] - ( 4.0 * t * t * t - 3.0 * t ) ) <= 1.0e-5 );
+    }
+    std::vector<float> const series{ 1.0f, 0.5f, -0.25f, 0.125f, 0.0625f, -0.03125f, 0.015625f };
+    std::vector<numeric::float16_t> positive( n );
+    std::uniform_real_distribution<float> interval{ 0.0f, 4.0f };
+    for ( auto& v : positive ) v = numeric::float16_t{ interval( engine ) };
+    numeric::chebval( series, positive, wide, 0.0f, 4.0f, 2 );
+    for ( std::size_t i = 0; i != n; ++i )
+    {
+        double const theta = std::acos( std::clamp( double( float( positive[i] ) ) / 2.0 - 1.0, -1.0, 1.0 ) );
+        double want = 0.0;
+        for ( std::size_t k = 0; k != series.size(); ++k ) want += series[k] * std::cos( double( k ) * theta );
+        REQUIRE( std::abs( wide[i] - want ) <= 1.0e-5 );
+    }
+    std::array<float, 7> fixed_series;
+    std::copy( series.begin(), series.end(), fixed_series.begin() );
+    std::vector<float> fixed_wide( n );
+    numeric::chebval( fixed_series, positive, fixed_wide, 0.0f, 4.0f );
+    for ( std::size_t i = 0; i != n; ++i ) REQUIRE( std::abs( fixed_wide[i] - wide[i] ) <= 1.0e-5f );
+
+    REQUIRE_THROWS_AS( numeric::polyval( fixed, in, std::span<numeric::float16_t>{ out.data(), 3 } ), std::invalid_argument );
+    REQUIRE_THROWS_AS( numeric::chebval( series, in, out, 1.0f, 1.0f ), std::invalid_argument );
+}